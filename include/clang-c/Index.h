@@ -32,7 +32,7 @@
  * compatible, thus CINDEX_VERSION_MAJOR is expected to remain stable.
  */
 #define CINDEX_VERSION_MAJOR 0
-#define CINDEX_VERSION_MINOR 57
+#define CINDEX_VERSION_MINOR 59
 
 #define CINDEX_VERSION_ENCODE(major, minor) ( \
       ((major) * 10000)                       \
@@ -1609,6 +1609,142 @@ CINDEX_LINKAGE int clang_reparseTranslationUnit(CXTranslationUnit TU,
                                           struct CXUnsavedFile *unsaved_files,
                                                 unsigned options);
 
+/**
+ * A request to stop a long running operation, such as a reparse, code
+ * completion or indexing, either explicitly or once a deadline has passed.
+ *
+ * The operation checks the token between declarations and while collecting
+ * code-completion results, and then returns the partial results it has so
+ * far: a translation unit that only contains the declarations parsed before
+ * it stopped, and the code-completion results found so far. Precompiled
+ * preambles and modules are always built completely.
+ */
+typedef struct CXCancellationTokenImpl *CXCancellationToken;
+
+/**
+ * Create a cancellation token, which isn't cancelled and has no deadline.
+ */
+CINDEX_LINKAGE CXCancellationToken clang_CancellationToken_create(void);
+
+/**
+ * Dispose a cancellation token. The operations that use it keep it alive
+ * until they are done.
+ */
+CINDEX_LINKAGE void clang_CancellationToken_dispose(CXCancellationToken token);
+
+/**
+ * Request that the operations using \p token stop as soon as possible.
+ *
+ * This function can be called from any thread.
+ */
+CINDEX_LINKAGE void clang_CancellationToken_cancel(CXCancellationToken token);
+
+/**
+ * Request that the operations using \p token stop once \p timeout_ms
+ * milliseconds have passed from now.
+ *
+ * This function can be called from any thread.
+ */
+CINDEX_LINKAGE void
+clang_CancellationToken_setDeadline(CXCancellationToken token,
+                                    unsigned timeout_ms);
+
+/**
+ * Returns non-zero if \p token was cancelled or its deadline has passed.
+ */
+CINDEX_LINKAGE unsigned
+clang_CancellationToken_isCancelled(CXCancellationToken token);
+
+/**
+ * Make \c clang_reparseTranslationUnit() and \c clang_codeCompleteAt() stop
+ * early on \p TU when \p token is cancelled, or stop using a token if
+ * \p token is NULL.
+ *
+ * A reparse that is stopped early returns \c CXError_Failure, like any other
+ * failed reparse, since the translation unit it leaves is incomplete.
+ *
+ * A background reparse started with \c clang_reparseTranslationUnitAsync()
+ * is stopped with \c clang_cancelReparse() instead.
+ */
+CINDEX_LINKAGE void
+clang_TranslationUnit_setCancellationToken(CXTranslationUnit TU,
+                                           CXCancellationToken token);
+
+/**
+ * A reparse of a translation unit running in the background, started by
+ * \c clang_reparseTranslationUnitAsync().
+ */
+typedef struct CXReparseTaskImpl *CXReparseTask;
+
+/**
+ * Callback invoked once a background reparse is done.
+ *
+ * The callback is invoked on the thread that performed the reparse, with the
+ * result that \c clang_finishReparse() will return unless the task is
+ * cancelled in the meantime. It must not call \c clang_finishReparse() itself.
+ */
+typedef void (*CXReparseCallback)(CXReparseTask task, enum CXErrorCode result,
+                                  CXClientData client_data);
+
+/**
+ * Start reparsing the source files that produced this translation unit on a
+ * background thread.
+ *
+ * The translation unit is reparsed like with
+ * \c clang_reparseTranslationUnit(), but into a new AST. Until the task is
+ * finished with \c clang_finishReparse(), \p TU keeps its previous AST and
+ * can still be used, e.g. for code completion and cursor queries, from the
+ * thread that started the reparse.
+ *
+ * \param TU The translation unit whose contents will be re-parsed.
+ *
+ * \param num_unsaved_files The number of unsaved file entries in \p
+ * unsaved_files.
+ *
+ * \param unsaved_files The files that have not yet been saved to disk. They
+ * are copied before this function returns.
+ *
+ * \param options A bitset of options composed of the flags in CXReparse_Flags.
+ *
+ * \param callback Invoked once the reparse is done, or NULL.
+ *
+ * \param client_data Passed to \p callback.
+ *
+ * \returns The task that performs the reparse, which must be finished with
+ * \c clang_finishReparse() before \p TU is disposed, or NULL if the
+ * translation unit can't be reparsed.
+ */
+CINDEX_LINKAGE CXReparseTask clang_reparseTranslationUnitAsync(
+    CXTranslationUnit TU, unsigned num_unsaved_files,
+    struct CXUnsavedFile *unsaved_files, unsigned options,
+    CXReparseCallback callback, CXClientData client_data);
+
+/**
+ * Request that a background reparse is abandoned.
+ *
+ * A reparse that didn't start yet is skipped; a reparse that is in flight
+ * stops at the next declaration and its result is discarded. Either way,
+ * \c clang_finishReparse() leaves the translation unit unchanged and returns
+ * \c CXError_Failure.
+ *
+ * This function can be called from any thread.
+ */
+CINDEX_LINKAGE void clang_cancelReparse(CXReparseTask task);
+
+/**
+ * Wait for a background reparse to be done and, if it succeeded, replace the
+ * AST of its translation unit with the new one.
+ *
+ * Replacing the AST invalidates all cursors and source locations that refer
+ * into the translation unit, like \c clang_reparseTranslationUnit() does.
+ * The task is disposed by this function.
+ *
+ * \returns 0 if the translation unit was reparsed, otherwise one of the
+ * \c CXErrorCode values. Unlike with \c clang_reparseTranslationUnit(), the
+ * translation unit keeps its previous AST when the reparse failed.
+ */
+CINDEX_LINKAGE enum CXErrorCode clang_finishReparse(CXReparseTask task);
+
 /**
   * Categorizes how memory is being used by a translation unit.
   */
@@ -6556,6 +6692,16 @@ CINDEX_LINKAGE CXIndexAction clang_IndexAction_create(CXIndex CIdx);
  */
 CINDEX_LINKAGE void clang_IndexAction_dispose(CXIndexAction);
 
+/**
+ * Make the indexing done through the given index action stop early, as if
+ * \c abortQuery returned true, once \p token is cancelled. Parsing a source
+ * file also stops at the next declaration. A null \p token stops using the
+ * previous one.
+ */
+CINDEX_LINKAGE void
+clang_IndexAction_setCancellationToken(CXIndexAction action,
+                                       CXCancellationToken token);
+
 typedef enum {
   /**
    * Used to indicate that no special indexing options are needed.
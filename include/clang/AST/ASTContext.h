@@ -89,6 +89,8 @@ class AtomicExpr;
 class BlockExpr;
 class BuiltinTemplateDecl;
 class CharUnits;
+class ConstexprBytecode;
+class ConstexprCallCache;
 class CXXABI;
 class CXXConstructorDecl;
 class CXXMethodDecl;
@@ -271,6 +273,12 @@ private:
   llvm::DenseMap<const MaterializeTemporaryExpr *, APValue *>
     MaterializedTemporaryValues;
 
+  /// The results of constexpr function calls, created on first use.
+  std::unique_ptr<ConstexprCallCache> ConstexprCalls;
+
+  /// The bytecode of constexpr functions, created on first use.
+  std::unique_ptr<ConstexprBytecode> ConstexprFunctions;
+
   /// A cache mapping a string value to a StringLiteral object with the same
   /// value.
   ///
@@ -2815,6 +2823,12 @@ public:
   APValue *getMaterializedTemporaryValue(const MaterializeTemporaryExpr *E,
                                          bool MayCreate);
 
+  /// Get the cache of the results of constexpr function calls.
+  ConstexprCallCache &getConstexprCallCache();
+
+  /// Get the bytecode of constexpr functions.
+  ConstexprBytecode &getConstexprBytecode();
+
   /// Return a string representing the human readable name for the specified
   /// function declaration or file name. Used by SourceLocExpr and
   /// PredefinedExpr to cache evaluated results.
@@ -0,0 +1,89 @@
+//===--- ConstexprBytecode.h - Bytecode for constexpr functions -*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines the ConstexprBytecode class, which lets the constant
+//  evaluator run constexpr functions without walking their bodies.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_AST_CONSTEXPRBYTECODE_H
+#define LLVM_CLANG_AST_CONSTEXPRBYTECODE_H
+
+#include "clang/AST/APValue.h"
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace clang {
+
+class ASTContext;
+class FunctionDecl;
+class Stmt;
+
+/// Compiles constexpr functions to bytecode, once per function, and runs the
+/// bytecode on a stack of integer values.
+///
+/// Only a subset of the language is compiled: functions other than member
+/// functions whose parameters, local variables and result have integral or
+/// enumeration type, and the statements and operators on such values. A call
+/// fails if its function, or any function it calls, can't be compiled, and
+/// whenever the call isn't a constant expression or exceeds the step or depth
+/// limits. The constant evaluator then evaluates the call by walking the AST
+/// instead, which diagnoses the failure; the bytecode never diagnoses anything.
+class ConstexprBytecode {
+public:
+  /// The number of evaluation steps and the call depth that a call took.
+  struct Usage {
+    unsigned Steps;
+    unsigned Depth;
+  };
+
+  explicit ConstexprBytecode(ASTContext &Ctx);
+  ~ConstexprBytecode();
+
+  /// Evaluates a call to \p Callee, whose definition is \p Body, with the
+  /// arguments \p Args.
+  ///
+  /// \param StepLimit The number of statements that may be evaluated.
+  /// \param DepthLimit The number of nested calls that may be active,
+  /// including this one.
+  ///
+  /// \returns false if the call can't be evaluated as bytecode.
+  bool call(const FunctionDecl *Callee, const Stmt *Body,
+            ArrayRef<APValue> Args, unsigned StepLimit, unsigned DepthLimit,
+            APValue &Result, Usage &Used);
+
+  void PrintStats() const;
+
+  struct Function;
+
+private:
+  const Function *getFunction(const FunctionDecl *FD, const Stmt *Body);
+  bool run(const Function *F, unsigned StepLimit, unsigned DepthLimit,
+           uint64_t &Result, Usage &Used);
+
+  ASTContext &Ctx;
+
+  /// The compiled functions, or null for the functions that can't be
+  /// compiled.
+  llvm::DenseMap<const FunctionDecl *, std::unique_ptr<Function>> Functions;
+
+  /// The parameters, local variables and operands of the active calls.
+  std::vector<uint64_t> Stack;
+
+  unsigned NumCompiled = 0;
+  unsigned NumUnsupported = 0;
+  unsigned NumCalls = 0;
+  unsigned NumFailedCalls = 0;
+};
+
+} // namespace clang
+
+#endif // LLVM_CLANG_AST_CONSTEXPRBYTECODE_H
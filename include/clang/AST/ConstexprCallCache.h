@@ -0,0 +1,64 @@
+//===--- ConstexprCallCache.h - Cache of constexpr call results -*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines the ConstexprCallCache class, which lets the constant
+//  evaluator reuse the results of constexpr function calls.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_AST_CONSTEXPRCALLCACHE_H
+#define LLVM_CLANG_AST_CONSTEXPRCALLCACHE_H
+
+#include "clang/AST/APValue.h"
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/StringMap.h"
+
+namespace clang {
+
+/// The results of the constexpr function calls evaluated in a translation
+/// unit, keyed on the function and the values of its arguments.
+///
+/// Only calls whose result depends on nothing but their arguments, and that
+/// produce no diagnostics, are cached; the key is computed by the constant
+/// evaluator. The cache holds at most a fixed number of values, counting the
+/// subobjects of aggregates, and is emptied when it's full.
+class ConstexprCallCache {
+public:
+  struct Entry {
+    APValue Result;
+    /// The number of evaluation steps that the call took.
+    unsigned Steps;
+    /// The depth of the deepest call, relative to the cached call.
+    unsigned Depth;
+  };
+
+  /// \param Limit The maximum number of values in the cache.
+  explicit ConstexprCallCache(unsigned Limit) : Limit(Limit) {}
+
+  /// Returns the cached result of the call with the given key, if any.
+  const Entry *lookup(StringRef Key);
+
+  /// Caches the result of the call with the given key, whose argument and
+  /// result values are made of \p Size values.
+  void insert(StringRef Key, Entry E, unsigned Size);
+
+  void PrintStats() const;
+
+private:
+  llvm::StringMap<Entry> Entries;
+  unsigned Limit;
+  unsigned Size = 0;
+
+  unsigned NumHits = 0;
+  unsigned NumMisses = 0;
+  unsigned NumFlushes = 0;
+};
+
+} // namespace clang
+
+#endif // LLVM_CLANG_AST_CONSTEXPRCALLCACHE_H
@@ -0,0 +1,65 @@
+//===--- CancellationToken.h - Cooperative cancellation ---------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// Defines the CancellationToken class, through which a client asks a long
+/// running parse or code completion to stop early.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_BASIC_CANCELLATIONTOKEN_H
+#define LLVM_CLANG_BASIC_CANCELLATIONTOKEN_H
+
+#include <atomic>
+#include <chrono>
+#include <limits>
+
+namespace clang {
+
+/// A request to stop an operation, either explicitly or once a deadline has
+/// passed.
+///
+/// The operation checks the token at points where it can stop safely, and
+/// then returns the partial results it has so far. All the member functions
+/// can be called from any thread.
+class CancellationToken {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /// Request that the operation stops as soon as possible.
+  void cancel() { Cancelled = true; }
+
+  /// Request that the operation stops once \p Deadline has passed.
+  void setDeadline(Clock::time_point Deadline) {
+    DeadlineTicks = Deadline.time_since_epoch().count();
+  }
+
+  /// Whether the operation should stop.
+  bool isCancelled() const {
+    if (Cancelled)
+      return true;
+    Clock::rep Deadline = DeadlineTicks;
+    if (Deadline == NoDeadline ||
+        Clock::now().time_since_epoch().count() < Deadline)
+      return false;
+    // Don't query the clock again once the deadline has passed.
+    Cancelled = true;
+    return true;
+  }
+
+private:
+  static constexpr Clock::rep NoDeadline =
+      std::numeric_limits<Clock::rep>::max();
+
+  mutable std::atomic<bool> Cancelled{false};
+  std::atomic<Clock::rep> DeadlineTicks{NoDeadline};
+};
+
+} // end namespace clang
+
+#endif // LLVM_CLANG_BASIC_CANCELLATIONTOKEN_H
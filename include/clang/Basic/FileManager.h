@@ -33,6 +33,7 @@
 namespace llvm {
 
 class MemoryBuffer;
+class ThreadPool;
 
 } // end namespace llvm
 
@@ -160,10 +161,16 @@ class FileManager : public RefCountedBase<FileManager> {
   // Statistics.
   unsigned NumDirLookups, NumFileLookups;
   unsigned NumDirCacheMisses, NumFileCacheMisses;
+  unsigned NumPrefetchedStats, NumPrefetchedStatHits;
 
   // Caching.
   std::unique_ptr<FileSystemStatCache> StatCache;
 
+  /// The results of the stat() calls made ahead of time by
+  /// prefetchFileStats(), keyed by the path that is passed to the file
+  /// system. Each one is used by the first lookup of its path.
+  llvm::StringMap<llvm::ErrorOr<llvm::vfs::Status>> PrefetchedStats;
+
   bool getStatValue(StringRef Path, llvm::vfs::Status &Status, bool isFile,
                     std::unique_ptr<llvm::vfs::File> *F);
 
@@ -195,6 +202,19 @@ public:
   /// Removes the FileSystemStatCache object from the manager.
   void clearStatCache();
 
+  /// Stat the given files concurrently on \p Pool, so that the next lookup
+  /// of each of them doesn't have to wait for the file system.
+  ///
+  /// This does nothing if a stat cache is installed, as the stat caches
+  /// can't be queried concurrently. The file system must support concurrent
+  /// status() calls.
+  void prefetchFileStats(ArrayRef<std::string> Filenames,
+                         llvm::ThreadPool &Pool);
+
+  /// Drops the results of prefetchFileStats() that haven't been used yet,
+  /// so that later lookups of those paths go to the file system.
+  void clearPrefetchedStats() { PrefetchedStats.clear(); }
+
   /// Lookup, cache, and verify the specified directory (real or
   /// virtual).
   ///
@@ -232,11 +252,17 @@ public:
 
   /// Open the specified file as a MemoryBuffer, returning a new
   /// MemoryBuffer if successful, otherwise returning null.
+  ///
+  /// Buffers that don't need a null terminator are memory mapped whenever
+  /// the file is large enough, even if its size is a multiple of the page
+  /// size.
   llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
   getBufferForFile(const FileEntry *Entry, bool isVolatile = false,
-                   bool ShouldCloseOpenFile = true);
+                   bool ShouldCloseOpenFile = true,
+                   bool RequiresNullTerminator = true);
   llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
-  getBufferForFile(StringRef Filename, bool isVolatile = false);
+  getBufferForFile(StringRef Filename, bool isVolatile = false,
+                   bool RequiresNullTerminator = true);
 
   /// Get the 'stat' information for the given \p Path.
   ///
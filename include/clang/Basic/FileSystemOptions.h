@@ -24,6 +24,10 @@ public:
   /// If set, paths are resolved as if the working directory was
   /// set to the value of WorkingDir.
   std::string WorkingDir;
+
+  /// If set, the file used to share the results of file system lookups in
+  /// system header directories with other compiler invocations.
+  std::string StatCacheFile;
 };
 
 } // end namespace clang
@@ -15,16 +15,20 @@
 #define LLVM_CLANG_BASIC_FILESYSTEMSTATCACHE_H
 
 #include "clang/Basic/LLVM.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Optional.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/VirtualFileSystem.h"
 #include <cstdint>
 #include <ctime>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace clang {
 
@@ -52,6 +56,9 @@ public:
       std::unique_ptr<llvm::vfs::File> *F,
       FileSystemStatCache *Cache, llvm::vfs::FileSystem &FS);
 
+  /// Print statistics about the cache to stderr, if it keeps any.
+  virtual void PrintStats() const {}
+
 protected:
   // FIXME: The pointer here is a non-owning/optional reference to the
   // unique_ptr. Optional<unique_ptr<vfs::File>&> might be nicer, but
@@ -83,6 +90,78 @@ public:
                           llvm::vfs::FileSystem &FS) override;
 };
 
+/// A stat cache stored in a file, which is shared by all the compiler
+/// invocations pointed at it.
+///
+/// Only lookups of paths which do not exist, inside a set of directories such
+/// as the sysroot and the system header directories, are cached: those are
+/// most of the lookups made by header search. Every cached lookup is recorded
+/// along with the inode and modification time of the parent directory, and is
+/// only reused while the parent directory still matches, since creating the
+/// file changes the directory. This costs a single stat() per directory
+/// instead of one per lookup. Paths which exist are always looked up in the
+/// file system, because their contents can change without touching their
+/// directory.
+///
+/// The cache file is memory-mapped when it is loaded, and save() replaces it
+/// atomically, so concurrent compilers never see a partially written cache.
+class PersistentStatCache : public FileSystemStatCache {
+public:
+  /// A lookup of a path which did not exist.
+  struct Entry {
+    /// The identity of the parent directory when the lookup was made.
+    llvm::sys::fs::UniqueID ParentID;
+    int64_t ParentMTime = 0;
+  };
+
+private:
+  /// The identity of a directory, as far as cache validation is concerned.
+  struct DirectoryStamp {
+    llvm::sys::fs::UniqueID ID;
+    int64_t MTime = 0;
+  };
+
+  std::string CachePath;
+  std::vector<std::string> Prefixes;
+
+  /// The contents of the cache file, and an on-disk hash table over them.
+  std::unique_ptr<llvm::MemoryBuffer> Buffer;
+  void *Table = nullptr;
+
+  /// The lookups which could not be served from the cache file.
+  llvm::StringMap<Entry> NewEntries;
+
+  /// The parent directories validated so far, or None for the ones which
+  /// could not be stat'ed.
+  llvm::StringMap<Optional<DirectoryStamp>> ParentStamps;
+
+  unsigned NumHits = 0;
+  unsigned NumMisses = 0;
+
+  bool isCacheable(StringRef Path) const;
+  const DirectoryStamp *getParentStamp(StringRef Parent,
+                                       llvm::vfs::FileSystem &FS);
+
+public:
+  /// Load the cache stored in \p CachePath, if there is one. Only paths below
+  /// one of the absolute directories in \p Prefixes are cached.
+  PersistentStatCache(StringRef CachePath, ArrayRef<std::string> Prefixes);
+  ~PersistentStatCache() override;
+
+  /// Write the cache back to its file if any lookup was not cached yet.
+  std::error_code save();
+
+  unsigned getNumHits() const { return NumHits; }
+  unsigned getNumMisses() const { return NumMisses; }
+
+  std::error_code getStat(StringRef Path, llvm::vfs::Status &Status,
+                          bool isFile,
+                          std::unique_ptr<llvm::vfs::File> *F,
+                          llvm::vfs::FileSystem &FS) override;
+
+  void PrintStats() const override;
+};
+
 } // namespace clang
 
 #endif // LLVM_CLANG_BASIC_FILESYSTEMSTATCACHE_H
@@ -26,6 +26,7 @@ class CompilerInstance;
 class ASTContext;
 class ASTImporter;
 class ASTUnit;
+class Decl;
 class DeclContext;
 class FunctionDecl;
 class VarDecl;
@@ -100,12 +101,23 @@ bool containsConst(const VarDecl *VD, const ASTContext &ACtx);
 /// In order to use this class, an index file is required that describes
 /// the locations of the AST files for each definition.
 ///
-/// Note that this class also implements caching.
+/// Note that this class also implements caching. The loaded AST files are
+/// kept in memory, together with the definitions found in them, so that
+/// every AST file is only loaded and searched once. The amount of memory the
+/// loaded AST files may use can be bounded with \c setMaxLoadedASTMemory.
 class CrossTranslationUnitContext {
 public:
   CrossTranslationUnitContext(CompilerInstance &CI);
   ~CrossTranslationUnitContext();
 
+  /// Limit the heap memory used by the loaded AST files to \p Bytes. When a
+  /// newly loaded AST file makes them exceed the limit, the least recently
+  /// used ones are unloaded. 0 means no limit, which is the default.
+  void setMaxLoadedASTMemory(uint64_t Bytes) { MaxLoadedASTMemory = Bytes; }
+
+  /// Returns the number of AST files that are currently loaded.
+  unsigned getNumLoadedASTs() const;
+
   /// This function loads a function or variable definition from an
   ///        external AST file and merges it into the original AST.
   ///
@@ -161,6 +173,26 @@ public:
   void emitCrossTUDiagnostics(const IndexError &IE);
 
 private:
+  /// An AST file loaded into memory.
+  struct LoadedAST {
+    std::unique_ptr<ASTUnit> Unit;
+    /// The definitions of functions and variables in the unit, keyed by
+    /// their lookup name. Collected the first time a definition is looked up
+    /// in the unit.
+    llvm::StringMap<const Decl *> Definitions;
+    bool HasDefinitions = false;
+    /// The value of \c UseCounter when the unit was last used.
+    unsigned LastUse = 0;
+  };
+
+  llvm::Expected<LoadedAST *> loadExternalASTImpl(StringRef LookupName,
+                                                  StringRef CrossTUDir,
+                                                  StringRef IndexName,
+                                                  bool DisplayCTUProgress);
+  /// Unloads the least recently used AST files other than \p Keep until the
+  /// loaded AST files fit into \c MaxLoadedASTMemory.
+  void unloadLeastRecentlyUsedASTs(const LoadedAST *Keep,
+                                   bool DisplayCTUProgress);
   void lazyInitLookupTable(TranslationUnitDecl *ToTU);
   ASTImporter &getOrCreateASTImporter(ASTContext &From);
   template <typename T>
@@ -169,19 +201,20 @@ private:
                                                      StringRef IndexName,
                                                      bool DisplayCTUProgress);
   template <typename T>
-  const T *findDefInDeclContext(const DeclContext *DC,
-                                StringRef LookupName);
+  const T *findDefinition(LoadedAST &AST, StringRef LookupName);
   template <typename T>
   llvm::Expected<const T *> importDefinitionImpl(const T *D);
 
-  llvm::StringMap<std::unique_ptr<clang::ASTUnit>> FileASTUnitMap;
-  llvm::StringMap<clang::ASTUnit *> NameASTUnitMap;
+  llvm::StringMap<LoadedAST> FileASTUnitMap;
+  llvm::StringMap<LoadedAST *> NameASTUnitMap;
   llvm::StringMap<std::string> NameFileMap;
   llvm::DenseMap<TranslationUnitDecl *, std::unique_ptr<ASTImporter>>
       ASTUnitImporterMap;
   CompilerInstance &CI;
   ASTContext &Context;
   std::unique_ptr<ASTImporterLookupTable> LookupTable;
+  uint64_t MaxLoadedASTMemory = 0;
+  unsigned UseCounter = 0;
 };
 
 } // namespace cross_tu
@@ -124,6 +124,17 @@ class Compilation {
   /// Whether to keep temporary files regardless of -save-temps.
   bool ForceKeepTempFiles = false;
 
+  /// Print the command line of \p C if -v or CC_PRINT_OPTIONS is in effect.
+  ///
+  /// \return false if the CC_PRINT_OPTIONS log file could not be opened.
+  bool PrintCommand(const Command &C) const;
+
+  /// Execute the jobs in \p Jobs on up to \p NumThreads threads, starting a
+  /// job only once every job producing one of its inputs has finished.
+  void ExecuteJobsInParallel(
+      const JobList &Jobs, unsigned NumThreads,
+      SmallVectorImpl<std::pair<int, const Command *>> &FailingCommands) const;
+
 public:
   Compilation(const Driver &D, const ToolChain &DefaultToolChain,
               llvm::opt::InputArgList *Args,
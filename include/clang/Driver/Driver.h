@@ -199,6 +199,22 @@ public:
   /// Whether the driver is generating diagnostics for debugging purposes.
   unsigned CCGenDiagnostics : 1;
 
+  /// The maximum number of independent jobs to execute concurrently, as set
+  /// by -fparallel-jobs=. Zero means one job per hardware thread.
+  unsigned ParallelJobs = 1;
+
+  /// Whether cc1 jobs should run inside the driver process through CC1Main
+  /// (-fintegrated-cc1).
+  bool IntegratedCC1 = false;
+
+  /// Callback used to run a -cc1 or -cc1as command line without spawning a
+  /// new process. \p Argv starts with the executable, followed by "-cc1".
+  typedef int (*CC1ToolFunc)(ArrayRef<const char *> Argv);
+
+  /// The entry point of the integrated cc1 tools, set by the clang executable.
+  /// When null, cc1 jobs always run in a separate process.
+  CC1ToolFunc CC1Main = nullptr;
+
 private:
   /// Raw target triple.
   std::string TargetTriple;
@@ -16,6 +16,7 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/iterator.h"
 #include "llvm/Option/Option.h"
+#include "llvm/Support/Compiler.h"
 #include <memory>
 #include <string>
 #include <utility>
@@ -58,6 +59,10 @@ class Command {
   /// Whether to print the input filenames when executing.
   bool PrintInputFilenames = false;
 
+  /// Whether the command runs inside the driver process instead of spawning
+  /// a new one.
+  bool InProcess = false;
+
   /// Response file name, if this command is set to use one, or nullptr
   /// otherwise
   const char *ResponseFile = nullptr;
@@ -85,6 +90,10 @@ class Command {
   /// The results are the contents of a response file, written into a raw_ostream.
   void writeResponseFile(raw_ostream &OS) const;
 
+protected:
+  /// Print the input filenames if requested by setPrintInputFilenames.
+  void PrintFileNames() const;
+
 public:
   Command(const Action &Source, const Tool &Creator, const char *Executable,
           const llvm::opt::ArgStringList &Arguments,
@@ -130,6 +139,38 @@ public:
 
   /// Set whether to print the input filenames when executing.
   void setPrintInputFilenames(bool P) { PrintInputFilenames = P; }
+
+  /// Whether the command runs inside the driver process instead of spawning
+  /// a new one.
+  bool isInProcess() const { return InProcess; }
+
+  /// Set whether the command runs inside the driver process.
+  void setInProcess(bool P) { InProcess = P; }
+};
+
+/// A cc1 or cc1as command, which can run inside the driver process through
+/// Driver::CC1Main instead of a new process when -fintegrated-cc1 is given.
+class CC1Command : public Command {
+public:
+  CC1Command(const Action &Source, const Tool &Creator,
+             const char *Executable, const llvm::opt::ArgStringList &Arguments,
+             ArrayRef<InputInfo> Inputs);
+
+  void Print(llvm::raw_ostream &OS, const char *Terminator, bool Quote,
+             CrashReportInfo *CrashInfo = nullptr) const override;
+
+  int Execute(ArrayRef<Optional<StringRef>> Redirects, std::string *ErrMsg,
+              bool *ExecutionFailed) const override;
+
+  /// Whether the calling thread is running a cc1 job inside the driver
+  /// process.
+  static bool isRunningInProcess();
+
+  /// Stop the cc1 job running inside the driver process on the calling
+  /// thread, and make it fail with \p RetCode as if its process had exited
+  /// with that status. Used by the fatal error handlers of cc1 and cc1as,
+  /// which would otherwise exit the driver too. Does not return.
+  LLVM_ATTRIBUTE_NORETURN static void exitInProcess(int RetCode);
 };
 
 /// Like Command, but with a fallback which is executed in case
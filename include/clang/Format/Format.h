@@ -18,8 +18,11 @@
 #include "clang/Tooling/Core/Replacement.h"
 #include "clang/Tooling/Inclusions/IncludeStyle.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Optional.h"
 #include "llvm/Support/Regex.h"
+#include <memory>
 #include <system_error>
+#include <vector>
 
 namespace llvm {
 namespace vfs {
@@ -2087,6 +2090,77 @@ struct FormattingAttemptStatus {
   /// original line number at which a syntax error might have occurred. This is
   /// based on a best-effort analysis and could be imprecise.
   unsigned Line = 0;
+
+  /// The number of lines whose line breaks were chosen by searching through
+  /// the possible line breaks.
+  unsigned NumSearchedLines = 0;
+
+  /// The number of states those searches expanded.
+  unsigned NumExpandedStates = 0;
+
+  /// The number of states those searches dropped without expanding them,
+  /// because an equivalent state had been reached with a lower penalty.
+  unsigned NumPrunedStates = 0;
+
+  /// The number of searches that became so large that they stopped telling
+  /// apart states that only differ in their nesting, which may have given
+  /// worse line breaks.
+  unsigned NumCutOffSearches = 0;
+
+  /// The time spent searching for line breaks, in seconds.
+  double SearchTime = 0;
+
+  /// The one-based line number of the line whose search took longest, and
+  /// the time it took, in seconds.
+  unsigned SlowestSearchLine = 0;
+  double SlowestSearchTime = 0;
+};
+
+/// Remembers the line breaks that were chosen for the lines formatted by
+/// \c reformat, so that formatting the same lines again, e.g. after an edit
+/// elsewhere in the file, doesn't need to search for the best line breaks
+/// again.
+///
+/// The entries are keyed by the text and the annotations of a line, its
+/// start column and the style, so one cache can be used for several files
+/// and styles. The cache can be used by several threads at the same time.
+class LineFormattingCache {
+public:
+  /// The line breaks chosen for a line.
+  struct Entry {
+    /// The penalty of the formatted line.
+    unsigned Penalty = 0;
+    /// Whether a line break is inserted before each token of the line after
+    /// the first one.
+    std::vector<bool> NewLines;
+  };
+
+  LineFormattingCache();
+  ~LineFormattingCache();
+
+  /// Returns the entry for \p Key, if there is one.
+  llvm::Optional<Entry> lookup(StringRef Key);
+
+  /// Adds the line breaks chosen for the line with the given \p Key.
+  void insert(StringRef Key, Entry E);
+
+  /// Adds the entries written by \c save to the cache. Returns false if
+  /// \p Buffer does not contain a saved cache.
+  bool load(StringRef Buffer);
+
+  /// Writes the entries that were looked up or added since they were loaded
+  /// to \p OS. The entries of the lines that no longer exist are dropped.
+  void save(raw_ostream &OS) const;
+
+  /// The number of lookups that found an entry.
+  unsigned getNumHits() const;
+
+  /// The number of lookups that didn't find an entry.
+  unsigned getNumMisses() const;
+
+private:
+  struct Implementation;
+  std::unique_ptr<Implementation> Impl;
 };
 
 /// Reformats the given \p Ranges in \p Code.
@@ -2100,10 +2174,15 @@ struct FormattingAttemptStatus {
 ///
 /// If ``Status`` is non-null, its value will be populated with the status of
 /// this formatting attempt. See \c FormattingAttemptStatus.
+///
+/// If ``Cache`` is non-null, the line breaks of the lines found in it are
+/// reused, and the line breaks chosen for the other lines are added to it.
+/// See \c LineFormattingCache.
 tooling::Replacements reformat(const FormatStyle &Style, StringRef Code,
                                ArrayRef<tooling::Range> Ranges,
                                StringRef FileName = "<stdin>",
-                               FormattingAttemptStatus *Status = nullptr);
+                               FormattingAttemptStatus *Status = nullptr,
+                               LineFormattingCache *Cache = nullptr);
 
 /// Same as above, except if ``IncompleteFormat`` is non-null, its value
 /// will be set to true if any of the affected ranges were not formatted due to
@@ -63,6 +63,7 @@ class ASTContext;
 class ASTDeserializationListener;
 class ASTMutationListener;
 class ASTReader;
+class CancellationToken;
 class CompilerInstance;
 class CompilerInvocation;
 class Decl;
@@ -118,6 +119,10 @@ private:
   IntrusiveRefCntPtr<ASTReader> Reader;
   bool HadModuleLoaderFatalFailure = false;
 
+  /// Whether the last parse was stopped early through the cancellation token,
+  /// leaving a partial translation unit.
+  bool ParseCancelled = false;
+
   struct ASTWriterData;
   std::unique_ptr<ASTWriterData> WriterData;
 
@@ -207,6 +212,13 @@ private:
   /// some number of calls.
   unsigned PreambleRebuildCountdown = 0;
 
+  /// The size of the preamble of the main file on the last reparse that
+  /// used the current preamble as a prefix of it, or zero.
+  ///
+  /// The preamble is only rebuilt once its end stopped changing, so that
+  /// every edit at the end of the include block doesn't rebuild it.
+  unsigned DeferredPreambleSize = 0;
+
   /// Counter indicating how often the preamble was build in total.
   unsigned PreambleCounter = 0;
 
@@ -218,8 +230,9 @@ private:
   /// of that loading. It must be cleared when preamble is recreated.
   llvm::StringMap<SourceLocation> PreambleSrcLocCache;
 
-  /// The contents of the preamble.
-  llvm::Optional<PrecompiledPreamble> Preamble;
+  /// The contents of the preamble, which may be shared with other ASTUnits
+  /// through the shared preamble cache.
+  std::shared_ptr<const PrecompiledPreamble> Preamble;
 
   /// When non-NULL, this is the buffer used to store the contents of
   /// the main file when it has been padded for use with the precompiled
@@ -664,6 +677,15 @@ public:
          IntrusiveRefCntPtr<DiagnosticsEngine> Diags, bool CaptureDiagnostics,
          bool UserFilesAreVolatile);
 
+  /// Set the total size, in bytes, of the precompiled preambles kept in the
+  /// process-wide shared preamble cache.
+  ///
+  /// When the cache is enabled, ASTUnits that parse the same main file with
+  /// the same options reuse the preamble built by one of them, as long as
+  /// the preamble is still valid, instead of each building its own. Zero, the
+  /// default, disables the cache and drops the preambles it holds.
+  static void setSharedPreambleCacheSize(uint64_t Size);
+
   enum WhatToLoad {
     /// Load options and the preprocessor state.
     LoadPreprocessorOnly,
@@ -844,6 +866,26 @@ public:
                ArrayRef<RemappedFile> RemappedFiles = None,
                IntrusiveRefCntPtr<llvm::vfs::FileSystem> VFS = nullptr);
 
+  /// Create a new ASTUnit for the same translation unit, that hasn't been
+  /// parsed yet and starts from the precompiled preamble of this one.
+  ///
+  /// The new ASTUnit doesn't share any mutable state with this one, so it can
+  /// be reparsed on another thread while this one is still in use, and then
+  /// replace it. It captures its diagnostics like this one; diagnostics that
+  /// aren't captured are printed to the standard error.
+  ///
+  /// \returns The new ASTUnit, or null if this one wasn't parsed from source.
+  std::unique_ptr<ASTUnit> createUnparsedCopy() const;
+
+  /// Make the next reparses and code completions stop early, keeping what
+  /// they parsed so far, once \p Token is cancelled. A null \p Token stops
+  /// using the previous one.
+  void setCancellationToken(std::shared_ptr<CancellationToken> Token);
+
+  /// Whether the last parse was stopped early through the cancellation token.
+  /// Such a parse fails, and its partial translation unit can't be saved.
+  bool wasParseCancelled() const { return ParseCancelled; }
+
   /// Free data that will be re-generated on the next parse.
   ///
   /// Preamble-related data is not affected.
@@ -25,11 +25,15 @@
 #include <cassert>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace llvm {
+class MemoryBuffer;
 class raw_fd_ostream;
+class ThreadPool;
 class Timer;
 class TimerGroup;
 }
@@ -183,6 +187,32 @@ class CompilerInstance : public ModuleLoader {
   /// Force an output buffer.
   std::unique_ptr<llvm::raw_pwrite_stream> OutputStream;
 
+  /// The threads that build the modules imported by the main file, see
+  /// \c prebuildMainFileImports.
+  std::unique_ptr<llvm::ThreadPool> ModuleBuildPool;
+
+  /// Whether the modules imported by the main file have been looked at.
+  bool PrebuildAttempted = false;
+
+  /// The module files built by \c ModuleBuildPool that have not been added
+  /// to the in-memory module cache yet, along with their file names.
+  std::vector<std::pair<std::string, std::unique_ptr<llvm::MemoryBuffer>>>
+      PrebuiltModules;
+  std::mutex PrebuiltModulesLock;
+
+  /// Starts building the modules that the main file imports and that are
+  /// missing from the module cache, except for \p Building, in the
+  /// background. This is done at most once, at the first module that has to
+  /// be built, if -fmodules-build-threads allows more than one thread.
+  void prebuildMainFileImports(StringRef Building);
+
+  /// Adds the module files that were built in the background to the
+  /// in-memory module cache.
+  void adoptPrebuiltModules();
+
+  /// Waits for the modules that are built in the background.
+  void waitForModuleBuilds();
+
   CompilerInstance(const CompilerInstance &) = delete;
   void operator=(const CompilerInstance &) = delete;
 public:
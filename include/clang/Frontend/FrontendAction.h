@@ -30,12 +30,16 @@
 namespace clang {
 class ASTMergeAction;
 class CompilerInstance;
+class DeserializationProfile;
 
 /// Abstract base class for actions which can be performed by the frontend.
 class FrontendAction {
   FrontendInputFile CurrentInput;
   std::unique_ptr<ASTUnit> CurrentASTUnit;
   CompilerInstance *Instance;
+  /// The profile requested with -deserialization-profile, which is written
+  /// when the source file ends.
+  std::shared_ptr<DeserializationProfile> DeserialProfile;
   friend class ASTMergeAction;
   friend class WrapperFrontendAction;
 
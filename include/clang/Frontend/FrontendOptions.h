@@ -106,6 +106,9 @@ enum ActionKind {
   /// Print the "preamble" of the input file
   PrintPreamble,
 
+  /// Print the output of the dependency directives source minimizer.
+  PrintDependencyDirectivesSourceMinimizerOutput,
+
   /// -E mode.
   PrintPreprocessedInput,
 
@@ -100,6 +100,15 @@ public:
                 const llvm::MemoryBuffer *MainFileBuffer, PreambleBounds Bounds,
                 llvm::vfs::FileSystem *VFS) const;
 
+  /// Check whether PrecompiledPreamble can be reused for the new contents
+  /// (\p MainFileBuffer) of the main file, whose preamble (\p Bounds) only
+  /// adds lines after the end of this one. The added lines are then parsed
+  /// as part of the main file.
+  bool CanReuseAsPrefix(const CompilerInvocation &Invocation,
+                        const llvm::MemoryBuffer *MainFileBuffer,
+                        PreambleBounds Bounds,
+                        llvm::vfs::FileSystem *VFS) const;
+
   /// Changes options inside \p CI to use PCH from this preamble. Also remaps
   /// main file to \p MainFileBuffer and updates \p VFS to ensure the preamble
   /// is accessible.
@@ -159,6 +159,18 @@ public:
   /// regenerated often.
   unsigned ModuleCachePruneAfter = 31 * 24 * 60 * 60;
 
+  /// The number of modules that may be built at the same time when the
+  /// modules imported by the main file are missing from the module cache.
+  ///
+  /// With fewer than two, each module is built when it is first imported.
+  unsigned ModulesBuildThreads = 0;
+
+  /// The number of threads that stat the input files of a module file
+  /// concurrently when they are validated.
+  ///
+  /// With fewer than two, the input files are stat'ed one by one.
+  unsigned ModulesValidationThreads = 0;
+
   /// The time in seconds when the build session started.
   ///
   /// This time is used by other optimizations in header search and module
@@ -192,6 +204,12 @@ public:
   /// \c BuildSessionTimestamp).
   unsigned ModulesValidateOncePerBuildSession : 1;
 
+  /// If true (with \c ModulesValidateOncePerBuildSession), skip verifying
+  /// all the input files of a module, including the user ones, if a module
+  /// file with the same signature was already verified during this build
+  /// session.
+  unsigned ModulesValidateSignatureOncePerBuildSession : 1;
+
   /// Whether to validate system input files when a module is loaded.
   unsigned ModulesValidateSystemHeaders : 1;
 
@@ -208,6 +226,7 @@ public:
         UseBuiltinIncludes(true), UseStandardSystemIncludes(true),
         UseStandardCXXIncludes(true), UseLibcxx(false), Verbose(false),
         ModulesValidateOncePerBuildSession(false),
+        ModulesValidateSignatureOncePerBuildSession(false),
         ModulesValidateSystemHeaders(false), UseDebugInfo(false),
         ModulesValidateDiagnosticOptions(true), ModulesHashContent(false) {}
 
@@ -1597,6 +1597,10 @@ public:
     getDiagnostics().setSuppressAllDiagnostics(true);
   }
 
+  /// Returns true if the client asked to stop processing the translation
+  /// unit through PreprocessorOptions::Cancellation.
+  bool isCancellationRequested() const;
+
   /// The location of the currently-active \#pragma clang
   /// arc_cf_code_audited begin.
   ///
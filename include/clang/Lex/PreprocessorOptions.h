@@ -9,6 +9,7 @@
 #ifndef LLVM_CLANG_LEX_PREPROCESSOROPTIONS_H_
 #define LLVM_CLANG_LEX_PREPROCESSOROPTIONS_H_
 
+#include "clang/Basic/CancellationToken.h"
 #include "clang/Basic/LLVM.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/StringSet.h"
@@ -90,6 +91,16 @@ public:
   /// deserialized, and we emit an error if they are; for testing purposes.
   std::set<std::string> DeserializedPCHDeclsToErrorOn;
 
+  /// If non-empty, the file to which the declarations and identifiers that
+  /// are deserialized from AST files are written, see
+  /// \c DeserializationProfile.
+  std::string DeserializationProfileFile;
+
+  /// If non-empty, a deserialization profile from translation units using
+  /// the PCH that is generated; the declarations they read are written first
+  /// in the PCH, so that reading them touches fewer pages.
+  std::string PCHLayoutProfile;
+
   /// If non-zero, the implicit PCH include is actually a precompiled
   /// preamble that covers this number of bytes in the main source file.
   ///
@@ -169,6 +180,14 @@ public:
   /// build it again.
   std::shared_ptr<FailedModulesSet> FailedModules;
 
+  /// If set, the parsing of the translation unit and the collection of the
+  /// code-completion results stop once this token is cancelled, leaving a
+  /// partial translation unit and partial results.
+  ///
+  /// The token isn't used for the modules and preambles that are built for
+  /// the translation unit, so that they are never left incomplete.
+  std::shared_ptr<CancellationToken> Cancellation;
+
 public:
   PreprocessorOptions() : PrecompiledPreambleBytes(0, false) {}
 
@@ -195,12 +214,15 @@ public:
     MacroIncludes.clear();
     ChainedIncludes.clear();
     DumpDeserializedPCHDecls = false;
+    DeserializationProfileFile.clear();
+    PCHLayoutProfile.clear();
     ImplicitPCHInclude.clear();
     SingleFileParseMode = false;
     LexEditorPlaceholders = true;
     RetainRemappedFileBuffers = true;
     PrecompiledPreambleBytes.first = 0;
     PrecompiledPreambleBytes.second = false;
+    Cancellation.reset();
   }
 };
 
@@ -7810,10 +7810,19 @@ public:
   /// but have not yet been performed.
   std::deque<PendingImplicitInstantiation> PendingInstantiations;
 
+  /// The implicit template instantiations that were left pending while
+  /// instantiating templates at the end of a translation unit prefix, because
+  /// the templates may still be defined after the prefix.
+  std::deque<PendingImplicitInstantiation> PendingPrefixInstantiations;
+
   /// Queue of implicit template instantiations that cannot be performed
   /// eagerly.
   SmallVector<PendingImplicitInstantiation, 1> LateParsedInstantiations;
 
+  /// The number of enabled GlobalEagerInstantiationScopes we are in, which
+  /// must perform all of their instantiations before they end.
+  unsigned NumGlobalEagerInstantiationScopes = 0;
+
   class GlobalEagerInstantiationScope {
   public:
     GlobalEagerInstantiationScope(Sema &S, bool Enabled)
@@ -7822,6 +7831,7 @@ public:
 
       SavedPendingInstantiations.swap(S.PendingInstantiations);
       SavedVTableUses.swap(S.VTableUses);
+      ++S.NumGlobalEagerInstantiationScopes;
     }
 
     void perform() {
@@ -7834,6 +7844,8 @@ public:
     ~GlobalEagerInstantiationScope() {
       if (!Enabled) return;
 
+      --S.NumGlobalEagerInstantiationScopes;
+
       // Restore the set of pending vtables.
       assert(S.VTableUses.empty() &&
              "VTableUses should be empty before it is discarded.");
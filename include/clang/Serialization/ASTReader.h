@@ -73,6 +73,12 @@
 #include <utility>
 #include <vector>
 
+namespace llvm {
+
+class ThreadPool;
+
+} // namespace llvm
+
 namespace clang {
 
 class ASTConsumer;
@@ -930,6 +936,10 @@ private:
   /// Whether validate system input files.
   bool ValidateSystemInputs;
 
+  /// The threads that stat the input files of a module before they are
+  /// validated, created on first use.
+  std::unique_ptr<llvm::ThreadPool> InputFileStatPool;
+
   /// Whether we are allowed to use the global module index.
   bool UseGlobalIndex;
 
@@ -1213,6 +1223,10 @@ private:
   /// Reads the stored information about an input file.
   InputFileInfo readInputFileInfo(ModuleFile &F, unsigned ID);
 
+  /// Stat the first \p NumInputs input files of \p F concurrently, if that
+  /// was requested, ahead of their validation.
+  void prefetchInputFiles(ModuleFile &F, unsigned NumInputs);
+
   /// Retrieve the file entry and 'overridden' bit for an input
   /// file in the given module file.
   serialization::InputFile getInputFile(ModuleFile &F, unsigned ID,
@@ -155,6 +155,10 @@ private:
   /// file is up to date, but not otherwise.
   bool IncludeTimestamps;
 
+  /// The keys of the declarations that are written first in a precompiled
+  /// header, in order, see \c setHotDecls().
+  std::vector<std::string> HotDeclKeys;
+
   /// Indicates when the AST writing is actively performing
   /// serialization, rather than just queueing updates.
   bool WritingAST = false;
@@ -532,6 +536,7 @@ private:
   unsigned ExprImplicitCastAbbrev = 0;
 
   void WriteDeclAbbrevs();
+  void AssignHotDeclIDs(ASTContext &Context);
   void WriteDecl(ASTContext &Context, Decl *D);
 
   ASTFileSignature WriteASTCore(Sema &SemaRef, StringRef isysroot,
@@ -549,6 +554,14 @@ public:
 
   const LangOptions &getLangOpts() const;
 
+  /// Write the given declarations, identified by their
+  /// \c DeserializationProfile key, before the other declarations of a
+  /// precompiled header, so that the translation units that read them
+  /// touch fewer pages of the file.
+  void setHotDecls(std::vector<std::string> Keys) {
+    HotDeclKeys = std::move(Keys);
+  }
+
   /// Get a timestamp for output into the AST file. The actual timestamp
   /// of the specified file may be ignored if we have been instructed to not
   /// include timestamps in the output file.
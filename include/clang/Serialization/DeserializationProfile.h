@@ -0,0 +1,72 @@
+//===- DeserializationProfile.h - Record of deserialized decls --*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines the DeserializationProfile class, which records the
+//  declarations and identifiers that a translation unit deserializes from its
+//  AST files, so that a PCH can be laid out for the translation units that
+//  use it.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SERIALIZATION_DESERIALIZATIONPROFILE_H
+#define LLVM_CLANG_SERIALIZATION_DESERIALIZATIONPROFILE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringRef.h"
+#include <string>
+#include <vector>
+
+namespace clang {
+
+class ASTReader;
+class Decl;
+class IdentifierInfo;
+
+/// The declarations and identifiers deserialized by a translation unit, in
+/// the order in which they were first read.
+///
+/// The profile is written as lines of tab-separated fields:
+/// \code
+///   decl <AST file> <decl kind> <file>:<offset> <qualified name>
+///   identifier <name>
+/// \endcode
+/// where lines starting with '#' are comments. A declaration is identified
+/// across builds of the AST file by its kind and the location of its name
+/// (see \c getDeclKey()).
+class DeserializationProfile {
+public:
+  void setReader(ASTReader *Reader) { this->Reader = Reader; }
+
+  void addDecl(const Decl *D);
+  void addIdentifier(const IdentifierInfo *II);
+
+  /// Write the profile. The AST context of the declarations must still
+  /// exist.
+  void write(raw_ostream &OS) const;
+
+  /// Returns the key that identifies \p D in a profile, or an empty string if
+  /// \p D isn't written in a file. The file is named by its absolute path, so
+  /// the key doesn't depend on how the file was found.
+  static std::string getDeclKey(const Decl *D);
+
+  /// Returns the keys of the declarations in the profile \p Buffer, in
+  /// profile order.
+  static std::vector<std::string> readDeclKeys(StringRef Buffer);
+
+private:
+  ASTReader *Reader = nullptr;
+  std::vector<const Decl *> Decls;
+  llvm::DenseSet<const Decl *> SeenDecls;
+  std::vector<const IdentifierInfo *> Identifiers;
+  llvm::DenseSet<const IdentifierInfo *> SeenIdentifiers;
+};
+
+} // namespace clang
+
+#endif // LLVM_CLANG_SERIALIZATION_DESERIALIZATIONPROFILE_H
@@ -20,6 +20,8 @@
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
+#include <array>
+#include <cstdint>
 #include <memory>
 #include <utility>
 
@@ -68,7 +70,7 @@ class GlobalModuleIndex {
 
   /// Information about a given module file.
   struct ModuleInfo {
-    ModuleInfo() : File(), Size(), ModTime() { }
+    ModuleInfo() : File(), Size(), ModTime(), Signature() { }
 
     /// The module file, once it has been resolved.
     ModuleFile *File;
@@ -83,6 +85,10 @@ class GlobalModuleIndex {
     /// index was built.
     time_t ModTime;
 
+    /// The signature of the module file at the time the global index was
+    /// built, or zero if it has none.
+    std::array<uint32_t, 5> Signature;
+
     /// The module IDs on which this module directly depends.
     /// FIXME: We don't really need a vector here.
     llvm::SmallVector<unsigned, 4> Dependencies;
@@ -189,6 +195,10 @@ public:
 
   /// Write a global index into the given
   ///
+  /// The entries of the previous index for the module files that did not
+  /// change since it was written are reused, and only the other module files
+  /// are loaded, on several threads when there are many of them.
+  ///
   /// \param FileMgr The file manager to use to load module files.
   /// \param PCHContainerRdr - The PCHContainerOperations to use for loading and
   /// creating modules.
@@ -16,6 +16,8 @@
 
 #include "clang/Tooling/ArgumentsAdjusters.h"
 #include "clang/Tooling/Execution.h"
+#include "llvm/Support/VirtualFileSystem.h"
+#include <functional>
 
 namespace clang {
 namespace tooling {
@@ -61,6 +63,17 @@ public:
     OverlayFiles[FilePath] = Content;
   }
 
+  using FileSystemWrapper = std::function<IntrusiveRefCntPtr<
+      llvm::vfs::FileSystem>(IntrusiveRefCntPtr<llvm::vfs::FileSystem>)>;
+
+  /// Wraps the file system that the files are read from. With
+  /// -execute-share-file-contents, the cache shared by the threads reads
+  /// through the wrapped file system. \p Wrapper is called once per file,
+  /// concurrently.
+  void setFileSystemWrapper(FileSystemWrapper Wrapper) {
+    WrapFileSystem = std::move(Wrapper);
+  }
+
 private:
   // Used to store the parser when the executor is initialized with parser.
   llvm::Optional<CommonOptionsParser> OptionsParser;
@@ -68,10 +81,12 @@ private:
   std::unique_ptr<ToolResults> Results;
   ExecutionContext Context;
   llvm::StringMap<std::string> OverlayFiles;
+  FileSystemWrapper WrapFileSystem;
   unsigned ThreadCount;
 };
 
 extern llvm::cl::opt<std::string> Filter;
+extern llvm::cl::opt<bool> ShareFileContents;
 
 } // end namespace tooling
 } // end namespace clang
@@ -19,6 +19,8 @@
 #include "clang/AST/AttrIterator.h"
 #include "clang/AST/CharUnits.h"
 #include "clang/AST/Comment.h"
+#include "clang/AST/ConstexprBytecode.h"
+#include "clang/AST/ConstexprCallCache.h"
 #include "clang/AST/Decl.h"
 #include "clang/AST/DeclBase.h"
 #include "clang/AST/DeclCXX.h"
@@ -967,6 +969,11 @@ void ASTContext::PrintStats() const {
                << NumImplicitDestructors
                << " implicit destructors created\n";
 
+  if (ConstexprCalls)
+    ConstexprCalls->PrintStats();
+  if (ConstexprFunctions)
+    ConstexprFunctions->PrintStats();
+
   if (ExternalSource) {
     llvm::errs() << "\n";
     ExternalSource->PrintStats();
@@ -10208,6 +10215,19 @@ ASTContext::getMaterializedTemporaryValue(const MaterializeTemporaryExpr *E,
   return MaterializedTemporaryValues.lookup(E);
 }
 
+ConstexprCallCache &ASTContext::getConstexprCallCache() {
+  if (!ConstexprCalls)
+    ConstexprCalls = llvm::make_unique<ConstexprCallCache>(
+        getLangOpts().ConstexprCallCacheSize);
+  return *ConstexprCalls;
+}
+
+ConstexprBytecode &ASTContext::getConstexprBytecode() {
+  if (!ConstexprFunctions)
+    ConstexprFunctions = llvm::make_unique<ConstexprBytecode>(*this);
+  return *ConstexprFunctions;
+}
+
 QualType ASTContext::getStringLiteralArrayType(QualType EltTy,
                                                unsigned Length) const {
   // A C++ string literal has a const-qualified element type (C++ 2.13.4p1).
@@ -0,0 +1,981 @@
+//===--- ConstexprBytecode.cpp - Bytecode for constexpr functions ---------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the ConstexprBytecode class.
+//
+//  The bytecode mirrors the tree-walking evaluator in ExprConstant.cpp: every
+//  statement that it passes to EvaluateStmt costs a step, and every operation
+//  that isn't a constant expression there makes the bytecode fail. Values are
+//  kept as 64 bits, sign-extended from the width of their type if it's signed
+//  and zero-extended otherwise.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/AST/ConstexprBytecode.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Decl.h"
+#include "clang/AST/DeclCXX.h"
+#include "clang/AST/Expr.h"
+#include "clang/AST/ExprCXX.h"
+#include "clang/AST/Stmt.h"
+#include "llvm/ADT/APSInt.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace clang;
+
+namespace {
+
+enum class Opcode : uint8_t {
+  Step,       // Count an evaluation step.
+  Const,      // Push constant Arg.
+  Load,       // Push the value of slot Arg.
+  Store,      // Store the top of the stack in slot Arg, keeping it.
+  LoadGlobal, // Push the value of constexpr variable Arg.
+  Pop,
+  Cast,       // Convert the top of the stack to the instruction's type.
+  ToBool,
+  Add, Sub, Mul, Div, Rem, Shl, Shr, And, Or, Xor,
+  LT, GT, LE, GE, EQ, NE,
+  Neg, Not, LNot,
+  PreInc, PreDec, PostInc, PostDec, // Update slot Arg.
+  Jmp,        // Jump to instruction Arg.
+  JmpIfFalse, // Pop a value, and jump to instruction Arg if it's zero.
+  JmpIfTrue,  // Pop a value, and jump to instruction Arg if it isn't zero.
+  Call,       // Call function Arg with the arguments on the stack.
+  Ret,        // Return the top of the stack.
+  Fail        // Fail the evaluation.
+};
+
+/// An integral type, as the width of its values and their signedness.
+struct IntType {
+  unsigned Width;
+  bool Signed;
+};
+
+struct Instr {
+  Opcode Op;
+  /// The type of the operation.
+  uint8_t Width;
+  bool Signed;
+  /// For shifts, whether the right operand is signed. For negations,
+  /// increments and decrements, whether they can overflow.
+  bool Flag;
+  int32_t Arg;
+};
+
+} // namespace
+
+struct ConstexprBytecode::Function {
+  std::vector<Instr> Code;
+  std::vector<uint64_t> Constants;
+  std::vector<const FunctionDecl *> Callees;
+  std::vector<const VarDecl *> Globals;
+  unsigned NumParams = 0;
+  /// The number of parameters and local variables.
+  unsigned NumSlots = 0;
+  IntType Result = {64, true};
+};
+
+static uint64_t normalize(uint64_t V, unsigned Width, bool Signed) {
+  if (Width == 64)
+    return V;
+  if (Signed)
+    return static_cast<uint64_t>(llvm::SignExtend64(V, Width));
+  return V & llvm::maskTrailingOnes<uint64_t>(Width);
+}
+
+static uint64_t getRawValue(const llvm::APSInt &V) {
+  return V.isSigned() ? static_cast<uint64_t>(V.getSExtValue())
+                      : V.getZExtValue();
+}
+
+static int64_t getMinValue(unsigned Width) {
+  return static_cast<int64_t>(~0ULL << (Width - 1));
+}
+
+static int64_t getMaxValue(unsigned Width) {
+  return static_cast<int64_t>(~0ULL >> (65 - Width));
+}
+
+namespace {
+
+/// Compiles the body of a function to bytecode.
+class Compiler {
+  ASTContext &Ctx;
+  ConstexprBytecode::Function &F;
+  llvm::DenseMap<const VarDecl *, unsigned> Slots;
+
+  /// The jumps of the break and continue statements of a loop, to patch once
+  /// their targets are known.
+  struct Loop {
+    SmallVector<unsigned, 4> Breaks;
+    SmallVector<unsigned, 4> Continues;
+  };
+  SmallVector<Loop, 4> Loops;
+
+public:
+  Compiler(ASTContext &Ctx, ConstexprBytecode::Function &F)
+      : Ctx(Ctx), F(F) {}
+
+  bool compileFunction(const FunctionDecl *FD, const Stmt *Body);
+
+private:
+  bool getType(QualType T, IntType &Result);
+
+  unsigned emit(Opcode Op, IntType T = {64, true}, int32_t Arg = 0,
+                bool Flag = false) {
+    F.Code.push_back({Op, static_cast<uint8_t>(T.Width), T.Signed, Flag, Arg});
+    return F.Code.size() - 1;
+  }
+  void emitConst(uint64_t V) {
+    F.Constants.push_back(V);
+    emit(Opcode::Const, {64, true}, F.Constants.size() - 1);
+  }
+  void emitConversion(QualType To, IntType T) {
+    if (To->isBooleanType())
+      emit(Opcode::ToBool);
+    else
+      emit(Opcode::Cast, T);
+  }
+  void patch(unsigned Jump) { F.Code[Jump].Arg = F.Code.size(); }
+
+  bool addSlot(const VarDecl *VD);
+  bool getSlot(const Expr *E, unsigned &Slot, IntType &T);
+
+  bool compileStmt(const Stmt *S);
+  bool compileVarDecl(const VarDecl *VD);
+  bool compileCondition(const VarDecl *CondVar, const Expr *Cond);
+  bool compileLoopBody(const Stmt *Body, Loop &L);
+  bool compileExpr(const Expr *E);
+  bool compileDiscarded(const Expr *E);
+  bool compileUpdate(const Expr *E);
+  bool compileCast(const CastExpr *E, IntType T);
+  bool compileLoad(const Expr *E);
+  bool compileUnary(const UnaryOperator *E, IntType T);
+  bool compileBinary(const BinaryOperator *E, IntType T);
+  bool compileCall(const CallExpr *E);
+};
+
+} // namespace
+
+bool Compiler::getType(QualType T, IntType &Result) {
+  if (T.isNull() || T.isVolatileQualified() ||
+      !T->isIntegralOrEnumerationType())
+    return false;
+  Result.Width = Ctx.getIntWidth(T);
+  Result.Signed = T->isSignedIntegerOrEnumerationType();
+  return Result.Width && Result.Width <= 64;
+}
+
+bool Compiler::compileFunction(const FunctionDecl *FD, const Stmt *Body) {
+  if (isa<CXXMethodDecl>(FD) || FD->isVariadic() || !isa<CompoundStmt>(Body) ||
+      !getType(FD->getReturnType(), F.Result))
+    return false;
+  for (const ParmVarDecl *PVD : FD->parameters())
+    if (!addSlot(PVD))
+      return false;
+  F.NumParams = F.NumSlots;
+
+  if (!compileStmt(Body))
+    return false;
+  // Flowing off the end of the function isn't a constant expression.
+  emit(Opcode::Fail);
+  return true;
+}
+
+bool Compiler::addSlot(const VarDecl *VD) {
+  IntType T;
+  if (!getType(VD->getType(), T))
+    return false;
+  Slots[VD] = F.NumSlots++;
+  return true;
+}
+
+/// Finds the slot of the local variable or parameter that \p E refers to.
+bool Compiler::getSlot(const Expr *E, unsigned &Slot, IntType &T) {
+  const auto *DRE = dyn_cast<DeclRefExpr>(E->IgnoreParens());
+  if (!DRE || DRE->refersToEnclosingVariableOrCapture())
+    return false;
+  const auto *VD = dyn_cast<VarDecl>(DRE->getDecl());
+  if (!VD)
+    return false;
+  auto It = Slots.find(VD);
+  if (It == Slots.end())
+    return false;
+  Slot = It->second;
+  return getType(DRE->getType(), T);
+}
+
+bool Compiler::compileStmt(const Stmt *S) {
+  emit(Opcode::Step);
+
+  switch (S->getStmtClass()) {
+  case Stmt::NullStmtClass:
+    return true;
+
+  case Stmt::CompoundStmtClass:
+    for (const Stmt *Child : cast<CompoundStmt>(S)->body())
+      if (!compileStmt(Child))
+        return false;
+    return true;
+
+  case Stmt::DeclStmtClass:
+    for (const Decl *D : cast<DeclStmt>(S)->decls()) {
+      // Declarations other than variables have no effect on the evaluation.
+      if (const auto *VD = dyn_cast<VarDecl>(D))
+        if (!compileVarDecl(VD))
+          return false;
+    }
+    return true;
+
+  case Stmt::ReturnStmtClass: {
+    const Expr *RetExpr = cast<ReturnStmt>(S)->getRetValue();
+    if (!RetExpr || !compileExpr(RetExpr))
+      return false;
+    emit(Opcode::Ret);
+    return true;
+  }
+
+  case Stmt::IfStmtClass: {
+    const auto *IS = cast<IfStmt>(S);
+    if (IS->getInit() && !compileStmt(IS->getInit()))
+      return false;
+    if (!compileCondition(IS->getConditionVariable(), IS->getCond()))
+      return false;
+    unsigned ToElse = emit(Opcode::JmpIfFalse);
+    if (!compileStmt(IS->getThen()))
+      return false;
+    if (!IS->getElse()) {
+      patch(ToElse);
+      return true;
+    }
+    unsigned ToEnd = emit(Opcode::Jmp);
+    patch(ToElse);
+    if (!compileStmt(IS->getElse()))
+      return false;
+    patch(ToEnd);
+    return true;
+  }
+
+  case Stmt::WhileStmtClass: {
+    const auto *WS = cast<WhileStmt>(S);
+    int32_t Top = F.Code.size();
+    if (!compileCondition(WS->getConditionVariable(), WS->getCond()))
+      return false;
+    unsigned ToEnd = emit(Opcode::JmpIfFalse);
+    Loop L;
+    if (!compileLoopBody(WS->getBody(), L))
+      return false;
+    for (unsigned Jump : L.Continues)
+      F.Code[Jump].Arg = Top;
+    emit(Opcode::Jmp, {64, true}, Top);
+    patch(ToEnd);
+    for (unsigned Jump : L.Breaks)
+      patch(Jump);
+    return true;
+  }
+
+  case Stmt::DoStmtClass: {
+    const auto *DS = cast<DoStmt>(S);
+    int32_t Top = F.Code.size();
+    Loop L;
+    if (!compileLoopBody(DS->getBody(), L))
+      return false;
+    for (unsigned Jump : L.Continues)
+      patch(Jump);
+    if (!compileExpr(DS->getCond()))
+      return false;
+    emit(Opcode::JmpIfTrue, {64, true}, Top);
+    for (unsigned Jump : L.Breaks)
+      patch(Jump);
+    return true;
+  }
+
+  case Stmt::ForStmtClass: {
+    const auto *FS = cast<ForStmt>(S);
+    if (FS->getInit() && !compileStmt(FS->getInit()))
+      return false;
+    int32_t Top = F.Code.size();
+    unsigned ToEnd = 0;
+    if (FS->getCond()) {
+      if (!compileCondition(FS->getConditionVariable(), FS->getCond()))
+        return false;
+      ToEnd = emit(Opcode::JmpIfFalse);
+    }
+    Loop L;
+    if (!compileLoopBody(FS->getBody(), L))
+      return false;
+    for (unsigned Jump : L.Continues)
+      patch(Jump);
+    if (FS->getInc() && !compileDiscarded(FS->getInc()))
+      return false;
+    emit(Opcode::Jmp, {64, true}, Top);
+    if (FS->getCond())
+      patch(ToEnd);
+    for (unsigned Jump : L.Breaks)
+      patch(Jump);
+    return true;
+  }
+
+  case Stmt::BreakStmtClass:
+  case Stmt::ContinueStmtClass: {
+    if (Loops.empty())
+      return false;
+    unsigned Jump = emit(Opcode::Jmp);
+    if (isa<BreakStmt>(S))
+      Loops.back().Breaks.push_back(Jump);
+    else
+      Loops.back().Continues.push_back(Jump);
+    return true;
+  }
+
+  default:
+    if (const auto *E = dyn_cast<Expr>(S))
+      return compileDiscarded(E);
+    return false;
+  }
+}
+
+bool Compiler::compileVarDecl(const VarDecl *VD) {
+  // An uninitialized variable can't be read in a constant expression, and
+  // static and thread_local variables aren't allowed in constexpr functions.
+  // The variable isn't in scope in its own initializer.
+  const Expr *Init = VD->getInit();
+  if (!VD->hasLocalStorage() || !Init || Init->isValueDependent() ||
+      !compileExpr(Init) || !addSlot(VD))
+    return false;
+  emit(Opcode::Store, {64, true}, Slots[VD]);
+  emit(Opcode::Pop);
+  return true;
+}
+
+bool Compiler::compileCondition(const VarDecl *CondVar, const Expr *Cond) {
+  if (CondVar && !compileVarDecl(CondVar))
+    return false;
+  return compileExpr(Cond);
+}
+
+bool Compiler::compileLoopBody(const Stmt *Body, Loop &L) {
+  Loops.emplace_back();
+  bool Success = compileStmt(Body);
+  L = Loops.pop_back_val();
+  return Success;
+}
+
+/// Compiles the full-expression \p E, discarding its value.
+bool Compiler::compileDiscarded(const Expr *E) {
+  E = E->IgnoreParens();
+  if (const auto *CE = dyn_cast<CastExpr>(E))
+    if (CE->getCastKind() == CK_ToVoid)
+      return compileDiscarded(CE->getSubExpr());
+  if (E->isGLValue() ? !compileUpdate(E) : !compileExpr(E))
+    return false;
+  emit(Opcode::Pop);
+  return true;
+}
+
+/// Compiles an assignment, compound assignment, or prefix increment or
+/// decrement of a local variable, which pushes the new value of the variable.
+bool Compiler::compileUpdate(const Expr *E) {
+  E = E->IgnoreParens();
+  unsigned Slot;
+  IntType T;
+
+  if (const auto *UO = dyn_cast<UnaryOperator>(E)) {
+    if (!UO->isPrefix() || !UO->isIncrementDecrementOp() ||
+        !getSlot(UO->getSubExpr(), Slot, T) ||
+        !UO->getSubExpr()->getType()->isIntegerType() ||
+        UO->getSubExpr()->getType()->isBooleanType())
+      return false;
+    emit(UO->isIncrementOp() ? Opcode::PreInc : Opcode::PreDec, T, Slot,
+         UO->canOverflow());
+    return true;
+  }
+
+  const auto *BO = dyn_cast<BinaryOperator>(E);
+  if (!BO || !BO->isAssignmentOp() || !getSlot(BO->getLHS(), Slot, T))
+    return false;
+
+  if (BO->getOpcode() == BO_Assign) {
+    if (!compileExpr(BO->getRHS()))
+      return false;
+    emit(Opcode::Store, {64, true}, Slot);
+    return true;
+  }
+
+  // Perform the operation in the computation type, and convert the result
+  // back to the type of the variable.
+  const auto *CAO = cast<CompoundAssignOperator>(BO);
+  IntType LHSType, ResultType;
+  if (!getType(CAO->getComputationLHSType(), LHSType) ||
+      !getType(CAO->getComputationResultType(), ResultType))
+    return false;
+  emit(Opcode::Load, {64, true}, Slot);
+  emitConversion(CAO->getComputationLHSType(), LHSType);
+  if (!compileExpr(CAO->getRHS()))
+    return false;
+
+  Opcode Op;
+  switch (BinaryOperator::getOpForCompoundAssignment(CAO->getOpcode())) {
+  case BO_Add: Op = Opcode::Add; break;
+  case BO_Sub: Op = Opcode::Sub; break;
+  case BO_Mul: Op = Opcode::Mul; break;
+  case BO_Div: Op = Opcode::Div; break;
+  case BO_Rem: Op = Opcode::Rem; break;
+  case BO_Shl: Op = Opcode::Shl; break;
+  case BO_Shr: Op = Opcode::Shr; break;
+  case BO_And: Op = Opcode::And; break;
+  case BO_Or: Op = Opcode::Or; break;
+  case BO_Xor: Op = Opcode::Xor; break;
+  default:
+    return false;
+  }
+  IntType RHSType;
+  if (!getType(CAO->getRHS()->getType(), RHSType))
+    return false;
+  emit(Op, ResultType, 0, RHSType.Signed);
+  emitConversion(BO->getLHS()->getType(), T);
+  emit(Opcode::Store, {64, true}, Slot);
+  return true;
+}
+
+/// Compiles the prvalue \p E, which pushes its value.
+bool Compiler::compileExpr(const Expr *E) {
+  IntType T;
+  if (E->isGLValue() || !getType(E->getType(), T))
+    return false;
+
+  switch (E->getStmtClass()) {
+  case Stmt::ParenExprClass:
+    return compileExpr(cast<ParenExpr>(E)->getSubExpr());
+  case Stmt::ConstantExprClass:
+    return compileExpr(cast<ConstantExpr>(E)->getSubExpr());
+  case Stmt::SubstNonTypeTemplateParmExprClass:
+    return compileExpr(
+        cast<SubstNonTypeTemplateParmExpr>(E)->getReplacement());
+  case Stmt::CXXDefaultArgExprClass:
+    return compileExpr(cast<CXXDefaultArgExpr>(E)->getExpr());
+
+  case Stmt::IntegerLiteralClass:
+    emitConst(normalize(cast<IntegerLiteral>(E)->getValue().getZExtValue(),
+                        T.Width, T.Signed));
+    return true;
+  case Stmt::CharacterLiteralClass:
+    emitConst(
+        normalize(cast<CharacterLiteral>(E)->getValue(), T.Width, T.Signed));
+    return true;
+  case Stmt::CXXBoolLiteralExprClass:
+    emitConst(cast<CXXBoolLiteralExpr>(E)->getValue());
+    return true;
+  case Stmt::ImplicitValueInitExprClass:
+    emitConst(0);
+    return true;
+
+  case Stmt::InitListExprClass: {
+    const auto *ILE = cast<InitListExpr>(E);
+    if (ILE->getNumInits() > 1)
+      return false;
+    if (!ILE->getNumInits()) {
+      emitConst(0);
+      return true;
+    }
+    return compileExpr(ILE->getInit(0));
+  }
+
+  case Stmt::DeclRefExprClass: {
+    const auto *ECD =
+        dyn_cast<EnumConstantDecl>(cast<DeclRefExpr>(E)->getDecl());
+    if (!ECD)
+      return false;
+    emitConst(normalize(getRawValue(ECD->getInitVal()), T.Width, T.Signed));
+    return true;
+  }
+
+  case Stmt::UnaryOperatorClass:
+    return compileUnary(cast<UnaryOperator>(E), T);
+  case Stmt::BinaryOperatorClass:
+  case Stmt::CompoundAssignOperatorClass:
+    return compileBinary(cast<BinaryOperator>(E), T);
+
+  case Stmt::ConditionalOperatorClass: {
+    const auto *CO = cast<ConditionalOperator>(E);
+    if (!compileExpr(CO->getCond()))
+      return false;
+    unsigned ToFalse = emit(Opcode::JmpIfFalse);
+    if (!compileExpr(CO->getTrueExpr()))
+      return false;
+    unsigned ToEnd = emit(Opcode::Jmp);
+    patch(ToFalse);
+    if (!compileExpr(CO->getFalseExpr()))
+      return false;
+    patch(ToEnd);
+    return true;
+  }
+
+  case Stmt::CallExprClass:
+    return compileCall(cast<CallExpr>(E));
+
+  default:
+    if (const auto *CE = dyn_cast<CastExpr>(E))
+      return compileCast(CE, T);
+    return false;
+  }
+}
+
+bool Compiler::compileCast(const CastExpr *E, IntType T) {
+  switch (E->getCastKind()) {
+  case CK_LValueToRValue:
+    return compileLoad(E->getSubExpr());
+  case CK_NoOp:
+    return compileExpr(E->getSubExpr());
+  case CK_IntegralCast:
+    if (!compileExpr(E->getSubExpr()))
+      return false;
+    emit(Opcode::Cast, T);
+    return true;
+  case CK_IntegralToBoolean:
+    if (!compileExpr(E->getSubExpr()))
+      return false;
+    emit(Opcode::ToBool);
+    return true;
+  default:
+    return false;
+  }
+}
+
+/// Compiles a read of the glvalue \p E.
+bool Compiler::compileLoad(const Expr *E) {
+  if (E->getType().isVolatileQualified())
+    return false;
+  unsigned Slot;
+  IntType T;
+  if (getSlot(E, Slot, T)) {
+    emit(Opcode::Load, T, Slot);
+    return true;
+  }
+
+  // Read constexpr variables other than local ones through their evaluated
+  // value, which the interpreter checks for when it reads them.
+  if (const auto *DRE = dyn_cast<DeclRefExpr>(E->IgnoreParens())) {
+    const auto *VD = dyn_cast<VarDecl>(DRE->getDecl());
+    if (!VD || !VD->isConstexpr() || VD->hasLocalStorage() || VD->isWeak() ||
+        DRE->refersToEnclosingVariableOrCapture() ||
+        !getType(DRE->getType(), T))
+      return false;
+    F.Globals.push_back(VD);
+    emit(Opcode::LoadGlobal, T, F.Globals.size() - 1);
+    return true;
+  }
+
+  // The result of an assignment is the variable it assigns to.
+  return compileUpdate(E);
+}
+
+bool Compiler::compileUnary(const UnaryOperator *E, IntType T) {
+  switch (E->getOpcode()) {
+  case UO_Plus:
+  case UO_Extension:
+    return compileExpr(E->getSubExpr());
+  case UO_Minus:
+    if (!compileExpr(E->getSubExpr()))
+      return false;
+    emit(Opcode::Neg, T, 0, E->canOverflow());
+    return true;
+  case UO_Not:
+    if (!compileExpr(E->getSubExpr()))
+      return false;
+    emit(Opcode::Not, T);
+    return true;
+  case UO_LNot:
+    if (!compileExpr(E->getSubExpr()))
+      return false;
+    emit(Opcode::LNot);
+    return true;
+  case UO_PostInc:
+  case UO_PostDec: {
+    unsigned Slot;
+    IntType VarType;
+    if (!getSlot(E->getSubExpr(), Slot, VarType) ||
+        !E->getSubExpr()->getType()->isIntegerType() ||
+        E->getSubExpr()->getType()->isBooleanType())
+      return false;
+    emit(E->isIncrementOp() ? Opcode::PostInc : Opcode::PostDec, VarType,
+         Slot, E->canOverflow());
+    return true;
+  }
+  case UO_PreInc:
+  case UO_PreDec:
+    return compileUpdate(E);
+  default:
+    return false;
+  }
+}
+
+bool Compiler::compileBinary(const BinaryOperator *E, IntType T) {
+  if (E->isAssignmentOp())
+    return compileUpdate(E);
+
+  switch (E->getOpcode()) {
+  case BO_Comma:
+    return compileDiscarded(E->getLHS()) && compileExpr(E->getRHS());
+
+  case BO_LAnd:
+  case BO_LOr: {
+    bool IsAnd = E->getOpcode() == BO_LAnd;
+    if (!compileExpr(E->getLHS()))
+      return false;
+    unsigned ToShortCircuit =
+        emit(IsAnd ? Opcode::JmpIfFalse : Opcode::JmpIfTrue);
+    if (!compileExpr(E->getRHS()))
+      return false;
+    if (!E->getRHS()->getType()->isBooleanType())
+      emit(Opcode::ToBool);
+    unsigned ToEnd = emit(Opcode::Jmp);
+    patch(ToShortCircuit);
+    emitConst(IsAnd ? 0 : 1);
+    patch(ToEnd);
+    return true;
+  }
+
+  default:
+    break;
+  }
+
+  Opcode Op;
+  switch (E->getOpcode()) {
+  case BO_Add: Op = Opcode::Add; break;
+  case BO_Sub: Op = Opcode::Sub; break;
+  case BO_Mul: Op = Opcode::Mul; break;
+  case BO_Div: Op = Opcode::Div; break;
+  case BO_Rem: Op = Opcode::Rem; break;
+  case BO_Shl: Op = Opcode::Shl; break;
+  case BO_Shr: Op = Opcode::Shr; break;
+  case BO_And: Op = Opcode::And; break;
+  case BO_Or: Op = Opcode::Or; break;
+  case BO_Xor: Op = Opcode::Xor; break;
+  case BO_LT: Op = Opcode::LT; break;
+  case BO_GT: Op = Opcode::GT; break;
+  case BO_LE: Op = Opcode::LE; break;
+  case BO_GE: Op = Opcode::GE; break;
+  case BO_EQ: Op = Opcode::EQ; break;
+  case BO_NE: Op = Opcode::NE; break;
+  default:
+    return false;
+  }
+
+  // Comparisons are performed in the type of their operands, and shifts in
+  // the type of their left operand.
+  IntType LHSType, RHSType;
+  if (!getType(E->getLHS()->getType(), LHSType) ||
+      !getType(E->getRHS()->getType(), RHSType) ||
+      !compileExpr(E->getLHS()) || !compileExpr(E->getRHS()))
+    return false;
+  emit(Op, E->isComparisonOp() ? LHSType : T, 0, RHSType.Signed);
+  return true;
+}
+
+bool Compiler::compileCall(const CallExpr *E) {
+  const FunctionDecl *FD = E->getDirectCallee();
+  if (!FD || isa<CXXMethodDecl>(FD) || FD->isVariadic() ||
+      FD->getBuiltinID() || E->getNumArgs() != FD->getNumParams())
+    return false;
+  for (const Expr *Arg : E->arguments())
+    if (!compileExpr(Arg))
+      return false;
+  F.Callees.push_back(FD);
+  emit(Opcode::Call, {64, true}, F.Callees.size() - 1);
+  return true;
+}
+
+/// Performs the binary operation \p I. Returns false if the operation isn't a
+/// constant expression.
+static bool evaluateBinary(const Instr &I, uint64_t L, uint64_t R,
+                           uint64_t &Result) {
+  unsigned W = I.Width;
+  int64_t SL = static_cast<int64_t>(L), SR = static_cast<int64_t>(R);
+
+  switch (I.Op) {
+  case Opcode::Add:
+  case Opcode::Sub:
+  case Opcode::Mul:
+    if (!I.Signed) {
+      Result = normalize(I.Op == Opcode::Add   ? L + R
+                         : I.Op == Opcode::Sub ? L - R
+                                               : L * R,
+                         W, false);
+      return true;
+    }
+    if (W <= 32) {
+      // The operation can't overflow 64 bits.
+      int64_t V = I.Op == Opcode::Add   ? SL + SR
+                  : I.Op == Opcode::Sub ? SL - SR
+                                        : SL * SR;
+      if (V < getMinValue(W) || V > getMaxValue(W))
+        return false;
+      Result = static_cast<uint64_t>(V);
+      return true;
+    } else {
+      llvm::APInt A(W, L, true), B(W, R, true);
+      bool Overflow;
+      llvm::APInt V = I.Op == Opcode::Add   ? A.sadd_ov(B, Overflow)
+                      : I.Op == Opcode::Sub ? A.ssub_ov(B, Overflow)
+                                            : A.smul_ov(B, Overflow);
+      if (Overflow)
+        return false;
+      Result = static_cast<uint64_t>(V.getSExtValue());
+      return true;
+    }
+
+  case Opcode::Div:
+  case Opcode::Rem:
+    if (!R)
+      return false;
+    if (!I.Signed) {
+      Result = I.Op == Opcode::Div ? L / R : L % R;
+      return true;
+    }
+    if (SL == getMinValue(W) && SR == -1)
+      return false;
+    Result = static_cast<uint64_t>(I.Op == Opcode::Div ? SL / SR : SL % SR);
+    return true;
+
+  case Opcode::Shl:
+  case Opcode::Shr:
+    if ((I.Flag && SR < 0) || R >= W)
+      return false;
+    if (I.Op == Opcode::Shr) {
+      Result = I.Signed ? static_cast<uint64_t>(SL >> R) : L >> R;
+      return true;
+    }
+    // Shifting a negative value, or shifting bits out of a signed value, isn't
+    // a constant expression.
+    if (I.Signed &&
+        (SL < 0 || llvm::countLeadingZeros(L) - (64 - W) < R))
+      return false;
+    Result = normalize(L << R, W, I.Signed);
+    return true;
+
+  case Opcode::And: Result = L & R; return true;
+  case Opcode::Or: Result = L | R; return true;
+  case Opcode::Xor: Result = L ^ R; return true;
+
+  case Opcode::LT: Result = I.Signed ? SL < SR : L < R; return true;
+  case Opcode::GT: Result = I.Signed ? SL > SR : L > R; return true;
+  case Opcode::LE: Result = I.Signed ? SL <= SR : L <= R; return true;
+  case Opcode::GE: Result = I.Signed ? SL >= SR : L >= R; return true;
+  case Opcode::EQ: Result = L == R; return true;
+  case Opcode::NE: Result = L != R; return true;
+
+  default:
+    llvm_unreachable("not a binary operation");
+  }
+}
+
+ConstexprBytecode::ConstexprBytecode(ASTContext &Ctx) : Ctx(Ctx) {}
+
+ConstexprBytecode::~ConstexprBytecode() = default;
+
+const ConstexprBytecode::Function *
+ConstexprBytecode::getFunction(const FunctionDecl *FD, const Stmt *Body) {
+  auto It = Functions.find(FD);
+  if (It != Functions.end())
+    return It->second.get();
+
+  auto F = llvm::make_unique<Function>();
+  if (Compiler(Ctx, *F).compileFunction(FD, Body)) {
+    ++NumCompiled;
+  } else {
+    F.reset();
+    ++NumUnsupported;
+  }
+  return (Functions[FD] = std::move(F)).get();
+}
+
+bool ConstexprBytecode::call(const FunctionDecl *Callee, const Stmt *Body,
+                             ArrayRef<APValue> Args, unsigned StepLimit,
+                             unsigned DepthLimit, APValue &Result,
+                             Usage &Used) {
+  ++NumCalls;
+  const Function *F = getFunction(Callee, Body);
+  if (!F || Args.size() != F->NumParams || !DepthLimit) {
+    ++NumFailedCalls;
+    return false;
+  }
+
+  Stack.clear();
+  for (const APValue &Arg : Args) {
+    if (!Arg.isInt()) {
+      ++NumFailedCalls;
+      return false;
+    }
+    Stack.push_back(getRawValue(Arg.getInt()));
+  }
+
+  uint64_t Value;
+  if (!run(F, StepLimit, DepthLimit, Value, Used)) {
+    ++NumFailedCalls;
+    return false;
+  }
+  Result = APValue(llvm::APSInt(llvm::APInt(F->Result.Width, Value),
+                                !F->Result.Signed));
+  return true;
+}
+
+bool ConstexprBytecode::run(const Function *F, unsigned StepLimit,
+                            unsigned DepthLimit, uint64_t &Result,
+                            Usage &Used) {
+  struct Frame {
+    const Function *F;
+    const Instr *PC;
+    /// The index of the first slot of the call on the stack.
+    size_t Base;
+  };
+  SmallVector<Frame, 16> Callers;
+  Frame Cur = {F, F->Code.data(), 0};
+  Stack.resize(F->NumSlots);
+  unsigned Steps = 0, Depth = 1, MaxDepth = 1;
+
+  while (true) {
+    const Instr &I = *Cur.PC++;
+    switch (I.Op) {
+    case Opcode::Step:
+      if (Steps == StepLimit)
+        return false;
+      ++Steps;
+      break;
+
+    case Opcode::Const:
+      Stack.push_back(Cur.F->Constants[I.Arg]);
+      break;
+    case Opcode::Load:
+      Stack.push_back(Stack[Cur.Base + I.Arg]);
+      break;
+    case Opcode::Store:
+      Stack[Cur.Base + I.Arg] = Stack.back();
+      break;
+    case Opcode::LoadGlobal: {
+      // The initializer of the variable hasn't been evaluated yet, or is
+      // being evaluated.
+      const VarDecl *VD = Cur.F->Globals[I.Arg];
+      const APValue *V = VD->getEvaluatedValue();
+      if (!V || !V->isInt() || !VD->isInitKnownICE() || !VD->isInitICE())
+        return false;
+      Stack.push_back(normalize(getRawValue(V->getInt()), I.Width, I.Signed));
+      break;
+    }
+    case Opcode::Pop:
+      Stack.pop_back();
+      break;
+
+    case Opcode::Cast:
+      Stack.back() = normalize(Stack.back(), I.Width, I.Signed);
+      break;
+    case Opcode::ToBool:
+      Stack.back() = Stack.back() != 0;
+      break;
+
+    case Opcode::Add: case Opcode::Sub: case Opcode::Mul: case Opcode::Div:
+    case Opcode::Rem: case Opcode::Shl: case Opcode::Shr: case Opcode::And:
+    case Opcode::Or: case Opcode::Xor: case Opcode::LT: case Opcode::GT:
+    case Opcode::LE: case Opcode::GE: case Opcode::EQ: case Opcode::NE: {
+      uint64_t R = Stack.back();
+      Stack.pop_back();
+      if (!evaluateBinary(I, Stack.back(), R, Stack.back()))
+        return false;
+      break;
+    }
+
+    case Opcode::Neg: {
+      uint64_t &V = Stack.back();
+      if (I.Signed && I.Flag &&
+          static_cast<int64_t>(V) == getMinValue(I.Width))
+        return false;
+      V = normalize(0 - V, I.Width, I.Signed);
+      break;
+    }
+    case Opcode::Not:
+      Stack.back() = normalize(~Stack.back(), I.Width, I.Signed);
+      break;
+    case Opcode::LNot:
+      Stack.back() = Stack.back() == 0;
+      break;
+
+    case Opcode::PreInc: case Opcode::PreDec:
+    case Opcode::PostInc: case Opcode::PostDec: {
+      bool Inc = I.Op == Opcode::PreInc || I.Op == Opcode::PostInc;
+      uint64_t Old = Stack[Cur.Base + I.Arg];
+      if (I.Signed && I.Flag &&
+          static_cast<int64_t>(Old) ==
+              (Inc ? getMaxValue(I.Width) : getMinValue(I.Width)))
+        return false;
+      uint64_t New = normalize(Inc ? Old + 1 : Old - 1, I.Width, I.Signed);
+      Stack[Cur.Base + I.Arg] = New;
+      Stack.push_back(I.Op == Opcode::PreInc || I.Op == Opcode::PreDec ? New
+                                                                       : Old);
+      break;
+    }
+
+    case Opcode::Jmp:
+      Cur.PC = Cur.F->Code.data() + I.Arg;
+      break;
+    case Opcode::JmpIfFalse:
+    case Opcode::JmpIfTrue: {
+      bool Cond = Stack.back() != 0;
+      Stack.pop_back();
+      if (Cond == (I.Op == Opcode::JmpIfTrue))
+        Cur.PC = Cur.F->Code.data() + I.Arg;
+      break;
+    }
+
+    case Opcode::Call: {
+      // Only constexpr functions that are defined can be called.
+      const FunctionDecl *Definition = nullptr;
+      const Stmt *Body = Cur.F->Callees[I.Arg]->getBody(Definition);
+      if (!Definition || !Definition->isConstexpr() ||
+          Definition->isInvalidDecl() || !Body || Depth == DepthLimit)
+        return false;
+      const Function *Callee = getFunction(Definition, Body);
+      if (!Callee)
+        return false;
+      Callers.push_back(Cur);
+      MaxDepth = std::max(MaxDepth, ++Depth);
+      size_t Base = Stack.size() - Callee->NumParams;
+      Stack.resize(Base + Callee->NumSlots);
+      Cur = {Callee, Callee->Code.data(), Base};
+      break;
+    }
+
+    case Opcode::Ret: {
+      uint64_t V = Stack.back();
+      if (Callers.empty()) {
+        Result = V;
+        Used = {Steps, MaxDepth};
+        return true;
+      }
+      Stack.resize(Cur.Base);
+      Stack.push_back(V);
+      Cur = Callers.pop_back_val();
+      --Depth;
+      break;
+    }
+
+    case Opcode::Fail:
+      return false;
+    }
+  }
+}
+
+void ConstexprBytecode::PrintStats() const {
+  llvm::errs() << "\n*** Constexpr Bytecode Stats:\n";
+  llvm::errs() << "  " << NumCompiled << " functions compiled, "
+               << NumUnsupported << " unsupported\n";
+  llvm::errs() << "  " << NumCalls << " calls, " << NumFailedCalls
+               << " evaluated from the AST\n";
+}
@@ -0,0 +1,46 @@
+//===--- ConstexprCallCache.cpp - Cache of constexpr call results ---------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the ConstexprCallCache class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/AST/ConstexprCallCache.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace clang;
+
+const ConstexprCallCache::Entry *ConstexprCallCache::lookup(StringRef Key) {
+  auto It = Entries.find(Key);
+  if (It == Entries.end()) {
+    ++NumMisses;
+    return nullptr;
+  }
+  ++NumHits;
+  return &It->second;
+}
+
+void ConstexprCallCache::insert(StringRef Key, Entry E, unsigned Size) {
+  if (Size > Limit)
+    return;
+  if (this->Size + Size > Limit) {
+    Entries.clear();
+    this->Size = 0;
+    ++NumFlushes;
+  }
+  if (Entries.try_emplace(Key, std::move(E)).second)
+    this->Size += Size;
+}
+
+void ConstexprCallCache::PrintStats() const {
+  llvm::errs() << "\n*** Constexpr Call Cache Stats:\n";
+  llvm::errs() << "  " << Entries.size() << " cached calls, " << Size << "/"
+               << Limit << " values\n";
+  llvm::errs() << "  " << NumHits << " hits, " << NumMisses << " misses, "
+               << NumFlushes << " flushes\n";
+}
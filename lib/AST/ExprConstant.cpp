@@ -37,6 +37,8 @@
 #include "clang/AST/ASTDiagnostic.h"
 #include "clang/AST/ASTLambda.h"
 #include "clang/AST/CharUnits.h"
+#include "clang/AST/ConstexprBytecode.h"
+#include "clang/AST/ConstexprCallCache.h"
 #include "clang/AST/CurrentSourceLocExprScope.h"
 #include "clang/AST/CXXInheritance.h"
 #include "clang/AST/Expr.h"
@@ -48,6 +50,7 @@
 #include "clang/Basic/FixedPoint.h"
 #include "clang/Basic/TargetInfo.h"
 #include "llvm/Support/SaveAndRestore.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cstring>
 #include <functional>
@@ -694,6 +697,10 @@ namespace {
     /// CallStackDepth - The number of calls in the call stack right now.
     unsigned CallStackDepth;
 
+    /// MaxCallStackDepth - The largest number of calls that have been in the
+    /// call stack since this was last reset.
+    unsigned MaxCallStackDepth;
+
     /// NextCallIndex - The next call index to assign.
     unsigned NextCallIndex;
 
@@ -718,6 +725,11 @@ namespace {
     /// declaration whose initializer is being evaluated, if any.
     APValue *EvaluatingDeclValue;
 
+    /// EvaluatingDeclReads - The number of times that the value being
+    /// constructed for EvaluatingDecl, or a temporary that it extends, has
+    /// been read.
+    unsigned EvaluatingDeclReads = 0;
+
     /// Set of objects that are currently being constructed.
     llvm::DenseMap<ObjectUnderConstruction, ConstructionPhase>
         ObjectsUnderConstruction;
@@ -824,7 +836,7 @@ namespace {
 
     EvalInfo(const ASTContext &C, Expr::EvalStatus &S, EvaluationMode Mode)
       : Ctx(const_cast<ASTContext &>(C)), EvalStatus(S), CurrentCall(nullptr),
-        CallStackDepth(0), NextCallIndex(1),
+        CallStackDepth(0), MaxCallStackDepth(0), NextCallIndex(1),
         StepsLeft(getLangOpts().ConstexprStepLimit),
         BottomFrame(*this, SourceLocation(), nullptr, nullptr, nullptr),
         EvaluatingDecl((const ValueDecl *)nullptr),
@@ -1279,6 +1291,8 @@ CallStackFrame::CallStackFrame(EvalInfo &Info, SourceLocation CallLoc,
       Arguments(Arguments), CallLoc(CallLoc), Index(Info.NextCallIndex++) {
   Info.CurrentCall = this;
   ++Info.CallStackDepth;
+  Info.MaxCallStackDepth =
+      std::max(Info.MaxCallStackDepth, Info.CallStackDepth);
 }
 
 CallStackFrame::~CallStackFrame() {
@@ -2694,6 +2708,7 @@ static bool evaluateVarDeclInit(EvalInfo &Info, const Expr *E,
   // in-flight value.
   if (Info.EvaluatingDecl.dyn_cast<const ValueDecl*>() == VD) {
     Result = Info.EvaluatingDeclValue;
+    ++Info.EvaluatingDeclReads;
     return true;
   }
 
@@ -3448,6 +3463,8 @@ static CompleteObject findCompleteObject(EvalInfo &Info, const Expr *E,
 
         BaseVal = Info.Ctx.getMaterializedTemporaryValue(MTE, false);
         assert(BaseVal && "got reference to unevaluated temporary");
+        if (VD && VD->getCanonicalDecl() == ED->getCanonicalDecl())
+          ++Info.EvaluatingDeclReads;
       } else {
         if (!IsAccess)
           return CompleteObject(LVal.getLValueBase(), nullptr, BaseType);
@@ -4924,12 +4941,194 @@ static bool EvaluateArgs(ArrayRef<const Expr*> Args, ArgVector &ArgValues,
   return Success;
 }
 
+namespace {
+/// Records a call made directly by the expression being evaluated, including
+/// the calls that it makes in turn, in the time trace.
+class CallTimeTraceScope {
+  Optional<llvm::TimeTraceScope> TimeScope;
+
+public:
+  CallTimeTraceScope(EvalInfo &Info, SourceLocation CallLoc,
+                     const FunctionDecl *Callee) {
+    if (Info.CallStackDepth != 1 || !llvm::timeTraceProfilerEnabled())
+      return;
+    TimeScope.emplace("EvaluateConstexprCall", [&]() {
+      std::string Name;
+      llvm::raw_string_ostream OS(Name);
+      Callee->getNameForDiagnostic(OS, Info.Ctx.getPrintingPolicy(),
+                                   /*Qualified=*/true);
+      OS << " (";
+      CallLoc.print(OS, Info.Ctx.getSourceManager());
+      OS << ')';
+      return OS.str();
+    });
+  }
+};
+
+/// Builds the key of a constexpr function call in the cache of call results,
+/// out of the function and the values of its arguments.
+class CallMemoKeyBuilder {
+  EvalInfo &Info;
+  SmallVectorImpl<char> &Key;
+
+public:
+  /// The number of values added to the key, counting subobjects.
+  unsigned NumValues = 0;
+
+  CallMemoKeyBuilder(EvalInfo &Info, SmallVectorImpl<char> &Key)
+      : Info(Info), Key(Key) {}
+
+  template <typename T> void addBytes(const T &Value) {
+    const char *Bytes = reinterpret_cast<const char *>(&Value);
+    Key.append(Bytes, Bytes + sizeof(T));
+  }
+
+  void addInt(const llvm::APInt &Value) {
+    addBytes(Value.getBitWidth());
+    const char *Bytes = reinterpret_cast<const char *>(Value.getRawData());
+    Key.append(Bytes, Bytes + Value.getNumWords() * sizeof(uint64_t));
+  }
+
+  void addFloat(const llvm::APFloat &Value) {
+    addBytes(&Value.getSemantics());
+    addInt(Value.bitcastToAPInt());
+  }
+
+  /// Adds \p Value to the key. Returns false if the value could refer to
+  /// state other than the value itself, which could change between calls.
+  bool addValue(const APValue &Value) {
+    ++NumValues;
+    addBytes(static_cast<unsigned char>(Value.getKind()));
+    switch (Value.getKind()) {
+    case APValue::Uninitialized:
+      return true;
+    case APValue::Int:
+      addBytes(Value.getInt().isUnsigned());
+      addInt(Value.getInt());
+      return true;
+    case APValue::Float:
+      addFloat(Value.getFloat());
+      return true;
+    case APValue::ComplexInt:
+      addBytes(Value.getComplexIntReal().isUnsigned());
+      addInt(Value.getComplexIntReal());
+      addInt(Value.getComplexIntImag());
+      return true;
+    case APValue::ComplexFloat:
+      addFloat(Value.getComplexFloatReal());
+      addFloat(Value.getComplexFloatImag());
+      return true;
+    case APValue::LValue:
+      return addLValue(Value);
+    case APValue::Vector:
+      addBytes(Value.getVectorLength());
+      for (unsigned I = 0, N = Value.getVectorLength(); I != N; ++I)
+        if (!addValue(Value.getVectorElt(I)))
+          return false;
+      return true;
+    case APValue::Array:
+      addBytes(Value.getArraySize());
+      addBytes(Value.getArrayInitializedElts());
+      for (unsigned I = 0, N = Value.getArrayInitializedElts(); I != N; ++I)
+        if (!addValue(Value.getArrayInitializedElt(I)))
+          return false;
+      return !Value.hasArrayFiller() || addValue(Value.getArrayFiller());
+    case APValue::Struct:
+      addBytes(Value.getStructNumBases());
+      addBytes(Value.getStructNumFields());
+      for (unsigned I = 0, N = Value.getStructNumBases(); I != N; ++I)
+        if (!addValue(Value.getStructBase(I)))
+          return false;
+      for (unsigned I = 0, N = Value.getStructNumFields(); I != N; ++I)
+        if (!addValue(Value.getStructField(I)))
+          return false;
+      return true;
+    case APValue::Union:
+      addBytes(Value.getUnionField());
+      return !Value.getUnionField() || addValue(Value.getUnionValue());
+    case APValue::FixedPoint:
+    case APValue::MemberPointer:
+    case APValue::AddrLabelDiff:
+      return false;
+    }
+    llvm_unreachable("unknown APValue kind");
+  }
+
+private:
+  bool addLValue(const APValue &Value) {
+    // Only pointers and references to objects whose values can't change
+    // during the evaluation are allowed: string literals, and variables other
+    // than the one being initialized.
+    APValue::LValueBase Base = Value.getLValueBase();
+    if (Base) {
+      if (Base.getCallIndex() || Base.is<TypeInfoLValue>())
+        return false;
+      if (const Expr *E = Base.dyn_cast<const Expr *>()) {
+        if (!isa<StringLiteral>(E))
+          return false;
+      } else if (Base == Info.EvaluatingDecl) {
+        return false;
+      }
+    }
+    addBytes(Base.getOpaqueValue());
+    addBytes(Value.getLValueOffset().getQuantity());
+    addBytes(Value.isNullPointer());
+    if (!Value.hasLValuePath()) {
+      addBytes(false);
+      return true;
+    }
+    addBytes(true);
+    addBytes(Value.isLValueOnePastTheEnd());
+    ArrayRef<APValue::LValuePathEntry> Path = Value.getLValuePath();
+    addBytes(Path.size());
+    for (APValue::LValuePathEntry Entry : Path)
+      addBytes(Entry.getAsArrayIndex());
+    return true;
+  }
+};
+}
+
+/// Computes the key of the call to \p Callee with the arguments \p Args in
+/// the cache of constexpr call results. Returns false if the call can't be
+/// cached.
+static bool getCallMemoKey(EvalInfo &Info, const FunctionDecl *Callee,
+                           ArrayRef<APValue> Args, SmallVectorImpl<char> &Key,
+                           unsigned &NumValues) {
+  // Calls made while checking a potential constant expression have arguments
+  // whose values are unknown.
+  if (!Info.getLangOpts().ConstexprCallCacheSize ||
+      Info.checkingPotentialConstantExpression() ||
+      Callee->getReturnType()->isVoidType())
+    return false;
+
+  CallMemoKeyBuilder Builder(Info, Key);
+  Builder.addBytes(Callee->getCanonicalDecl());
+  Builder.addBytes(static_cast<unsigned char>(Info.EvalMode));
+  Builder.addBytes(Info.InConstantContext);
+  Builder.addBytes(Args.size());
+  for (const APValue &Arg : Args)
+    if (!Builder.addValue(Arg))
+      return false;
+  NumValues = Builder.NumValues;
+  return true;
+}
+
+static bool evaluateFunctionBody(SourceLocation CallLoc,
+                                 const FunctionDecl *Callee,
+                                 const LValue *This,
+                                 ArrayRef<const Expr *> Args,
+                                 ArgVector &ArgValues, const Stmt *Body,
+                                 EvalInfo &Info, APValue &Result,
+                                 const LValue *ResultSlot);
+
 /// Evaluate a function call.
 static bool HandleFunctionCall(SourceLocation CallLoc,
                                const FunctionDecl *Callee, const LValue *This,
                                ArrayRef<const Expr*> Args, const Stmt *Body,
                                EvalInfo &Info, APValue &Result,
                                const LValue *ResultSlot) {
+  CallTimeTraceScope TimeScope(Info, CallLoc, Callee);
+
   ArgVector ArgValues(Args.size());
   if (!EvaluateArgs(Args, ArgValues, Info))
     return false;
@@ -4937,6 +5136,64 @@ static bool HandleFunctionCall(SourceLocation CallLoc,
   if (!Info.CheckCallLimit(CallLoc))
     return false;
 
+  // The result of a call to a function other than a member function depends
+  // only on the arguments, unless the call reads the variable being
+  // initialized, so reuse the results of earlier calls with the same
+  // arguments.
+  SmallVector<char, 128> Key;
+  unsigned KeyValues;
+  if (This || !getCallMemoKey(Info, Callee, ArgValues, Key, KeyValues))
+    return evaluateFunctionBody(CallLoc, Callee, This, Args, ArgValues, Body,
+                                Info, Result, ResultSlot);
+
+  ConstexprCallCache &Cache = Info.Ctx.getConstexprCallCache();
+  StringRef KeyStr(Key.data(), Key.size());
+  if (const ConstexprCallCache::Entry *Cached = Cache.lookup(KeyStr)) {
+    // Evaluating the call again would have exceeded the step or depth limits
+    // if there aren't enough of them left; evaluate it to diagnose that.
+    if (Cached->Steps <= Info.StepsLeft &&
+        Info.CallStackDepth + Cached->Depth <=
+            Info.getLangOpts().ConstexprCallDepth + 1) {
+      Info.StepsLeft -= Cached->Steps;
+      Info.MaxCallStackDepth = std::max(Info.MaxCallStackDepth,
+                                        Info.CallStackDepth + Cached->Depth);
+      Result = Cached->Result;
+      return true;
+    }
+  }
+
+  Expr::EvalStatus &Status = Info.EvalStatus;
+  bool CanCache = Status.Diag && Status.Diag->empty() &&
+                  !Status.HasSideEffects && !Status.HasUndefinedBehavior;
+  unsigned StepsLeft = Info.StepsLeft;
+  unsigned EvaluatingDeclReads = Info.EvaluatingDeclReads;
+  unsigned MaxCallStackDepth = Info.MaxCallStackDepth;
+  Info.MaxCallStackDepth = 0;
+
+  bool Success = evaluateFunctionBody(CallLoc, Callee, This, Args, ArgValues,
+                                      Body, Info, Result, ResultSlot);
+
+  unsigned Depth = Info.MaxCallStackDepth - Info.CallStackDepth;
+  Info.MaxCallStackDepth = std::max(MaxCallStackDepth, Info.MaxCallStackDepth);
+  if (!Success || !CanCache || !Status.Diag->empty() ||
+      Status.HasSideEffects || Status.HasUndefinedBehavior ||
+      Info.EvaluatingDeclReads != EvaluatingDeclReads)
+    return Success;
+
+  SmallVector<char, 64> ResultKey;
+  CallMemoKeyBuilder ResultBuilder(Info, ResultKey);
+  if (ResultBuilder.addValue(Result))
+    Cache.insert(KeyStr, {Result, StepsLeft - Info.StepsLeft, Depth},
+                 KeyValues + ResultBuilder.NumValues);
+  return Success;
+}
+
+/// Evaluate the body of a function that is being called by walking it.
+static bool walkFunctionBody(SourceLocation CallLoc, const FunctionDecl *Callee,
+                             const LValue *This, ArrayRef<const Expr *> Args,
+                             ArgVector &ArgValues, const Stmt *Body,
+                             EvalInfo &Info, APValue &Result,
+                             const LValue *ResultSlot) {
   CallStackFrame Frame(Info, CallLoc, Callee, This, ArgValues.data());
 
   // For a trivial copy or move assignment, perform an APValue copy. This is
@@ -4984,12 +5241,64 @@ static bool HandleFunctionCall(SourceLocation CallLoc,
   return ESR == ESR_Returned;
 }
 
+/// Evaluate the body of a function that is being called, after its arguments
+/// have been evaluated.
+static bool evaluateFunctionBody(SourceLocation CallLoc,
+                                 const FunctionDecl *Callee,
+                                 const LValue *This,
+                                 ArrayRef<const Expr *> Args,
+                                 ArgVector &ArgValues, const Stmt *Body,
+                                 EvalInfo &Info, APValue &Result,
+                                 const LValue *ResultSlot) {
+  // Run the bytecode of the function, if it can be compiled. Calls that the
+  // bytecode can't evaluate are evaluated by walking the body, which
+  // diagnoses them.
+  APValue BytecodeResult;
+  ConstexprBytecode::Usage Used;
+  if (This || !Info.getLangOpts().ConstexprBytecode ||
+      Info.checkingPotentialConstantExpression() ||
+      !Info.Ctx.getConstexprBytecode().call(
+          Callee, Body, ArgValues, Info.StepsLeft,
+          Info.getLangOpts().ConstexprCallDepth + 1 - Info.CallStackDepth,
+          BytecodeResult, Used))
+    return walkFunctionBody(CallLoc, Callee, This, Args, ArgValues, Body,
+                            Info, Result, ResultSlot);
+
+  if (!Info.getLangOpts().ConstexprBytecodeVerify) {
+    Info.StepsLeft -= Used.Steps;
+    Info.MaxCallStackDepth =
+        std::max(Info.MaxCallStackDepth, Info.CallStackDepth + Used.Depth);
+    Result = std::move(BytecodeResult);
+    return true;
+  }
+
+  // Check that walking the body produces the same value in the same number of
+  // steps.
+  unsigned StepsLeft = Info.StepsLeft;
+  bool Success = walkFunctionBody(CallLoc, Callee, This, Args, ArgValues, Body,
+                                  Info, Result, ResultSlot);
+  unsigned Steps = StepsLeft - Info.StepsLeft;
+  QualType ResultType = Callee->getReturnType();
+  if (!Success || !Result.isInt() || Steps != Used.Steps ||
+      Result.getInt().getBitWidth() != BytecodeResult.getInt().getBitWidth() ||
+      Result.getInt().isSigned() != BytecodeResult.getInt().isSigned() ||
+      Result.getInt() != BytecodeResult.getInt())
+    Info.Ctx.getDiagnostics().Report(CallLoc,
+                                     diag::err_constexpr_bytecode_mismatch)
+        << Callee << BytecodeResult.getAsString(Info.Ctx, ResultType)
+        << Used.Steps
+        << (Success ? Result.getAsString(Info.Ctx, ResultType) : "no value")
+        << Steps;
+  return Success;
+}
+
 /// Evaluate a constructor call.
 static bool HandleConstructorCall(const Expr *E, const LValue &This,
                                   APValue *ArgValues,
                                   const CXXConstructorDecl *Definition,
                                   EvalInfo &Info, APValue &Result) {
   SourceLocation CallLoc = E->getExprLoc();
+  CallTimeTraceScope TimeScope(Info, CallLoc, Definition);
   if (!Info.CheckCallLimit(CallLoc))
     return false;
 
@@ -11746,6 +12055,16 @@ bool Expr::EvaluateAsInitializer(APValue &Value, const ASTContext &Ctx,
   assert(!isValueDependent() &&
          "Expression evaluator can't be called on a dependent expression.");
 
+  llvm::TimeTraceScope TimeScope("EvaluateAsInitializer", [&]() {
+    std::string Name;
+    llvm::raw_string_ostream OS(Name);
+    VD->printQualifiedName(OS);
+    OS << " (";
+    VD->getLocation().print(OS, Ctx.getSourceManager());
+    OS << ')';
+    return OS.str();
+  });
+
   // FIXME: Evaluating initializers for large array and record types can cause
   // performance problems. Only do so in C++11 for now.
   if (isRValue() && (getType()->isArrayType() || getType()->isRecordType()) &&
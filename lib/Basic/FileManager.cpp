@@ -24,6 +24,7 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
@@ -45,6 +46,7 @@ FileManager::FileManager(const FileSystemOptions &FSO,
       SeenFileEntries(64), NextFileUID(0) {
   NumDirLookups = NumFileLookups = 0;
   NumDirCacheMisses = NumFileCacheMisses = 0;
+  NumPrefetchedStats = NumPrefetchedStatHits = 0;
 
   // If the caller doesn't provide a virtual file system, just grab the real
   // file system.
@@ -61,6 +63,43 @@ void FileManager::setStatCache(std::unique_ptr<FileSystemStatCache> statCache) {
 
 void FileManager::clearStatCache() { StatCache.reset(); }
 
+void FileManager::prefetchFileStats(ArrayRef<std::string> Filenames,
+                                    llvm::ThreadPool &Pool) {
+  if (StatCache)
+    return;
+
+  std::vector<std::string> Paths;
+  for (const std::string &Filename : Filenames) {
+    if (SeenFileEntries.count(Filename))
+      continue;
+    SmallString<128> Path(Filename);
+    if (!FileSystemOpts.WorkingDir.empty())
+      FixupRelativePath(Path);
+    if (!PrefetchedStats.count(Path))
+      Paths.push_back(Path.str());
+  }
+  if (Paths.empty())
+    return;
+
+  // Stat the paths in batches rather than scheduling one task per path, as a
+  // stat() is cheap compared to scheduling a task.
+  const size_t BatchSize = 32;
+  std::vector<llvm::ErrorOr<llvm::vfs::Status>> Results(
+      Paths.size(), std::make_error_code(std::errc::no_such_file_or_directory));
+  for (size_t Begin = 0; Begin < Paths.size(); Begin += BatchSize) {
+    size_t End = std::min(Begin + BatchSize, Paths.size());
+    Pool.async([this, &Paths, &Results, Begin, End] {
+      for (size_t I = Begin; I != End; ++I)
+        Results[I] = FS->status(Paths[I]);
+    });
+  }
+  Pool.wait();
+
+  for (size_t I = 0, E = Paths.size(); I != E; ++I)
+    PrefetchedStats.insert(std::make_pair(Paths[I], std::move(Results[I])));
+  NumPrefetchedStats += Paths.size();
+}
+
 /// Retrieve the directory that the given file name resides in.
 /// Filename can point to either a real file or a virtual file.
 static const DirectoryEntry *getDirectoryFromFile(FileManager &FileMgr,
@@ -376,7 +415,8 @@ void FileManager::fillRealPathName(FileEntry *UFE, llvm::StringRef FileName) {
 
 llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
 FileManager::getBufferForFile(const FileEntry *Entry, bool isVolatile,
-                              bool ShouldCloseOpenFile) {
+                              bool ShouldCloseOpenFile,
+                              bool RequiresNullTerminator) {
   uint64_t FileSize = Entry->getSize();
   // If there's a high enough chance that the file have changed since we
   // got its size, force a stat before opening it.
@@ -387,8 +427,8 @@ FileManager::getBufferForFile(const FileEntry *Entry, bool isVolatile,
   // If the file is already open, use the open file descriptor.
   if (Entry->File) {
     auto Result =
-        Entry->File->getBuffer(Filename, FileSize,
-                               /*RequiresNullTerminator=*/true, isVolatile);
+        Entry->File->getBuffer(Filename, FileSize, RequiresNullTerminator,
+                               isVolatile);
     // FIXME: we need a set of APIs that can make guarantees about whether a
     // FileEntry is open or not.
     if (ShouldCloseOpenFile)
@@ -399,23 +439,26 @@ FileManager::getBufferForFile(const FileEntry *Entry, bool isVolatile,
   // Otherwise, open the file.
 
   if (FileSystemOpts.WorkingDir.empty())
-    return FS->getBufferForFile(Filename, FileSize,
-                                /*RequiresNullTerminator=*/true, isVolatile);
+    return FS->getBufferForFile(Filename, FileSize, RequiresNullTerminator,
+                                isVolatile);
 
   SmallString<128> FilePath(Entry->getName());
   FixupRelativePath(FilePath);
-  return FS->getBufferForFile(FilePath, FileSize,
-                              /*RequiresNullTerminator=*/true, isVolatile);
+  return FS->getBufferForFile(FilePath, FileSize, RequiresNullTerminator,
+                              isVolatile);
 }
 
 llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
-FileManager::getBufferForFile(StringRef Filename, bool isVolatile) {
+FileManager::getBufferForFile(StringRef Filename, bool isVolatile,
+                              bool RequiresNullTerminator) {
   if (FileSystemOpts.WorkingDir.empty())
-    return FS->getBufferForFile(Filename, -1, true, isVolatile);
+    return FS->getBufferForFile(Filename, -1, RequiresNullTerminator,
+                                isVolatile);
 
   SmallString<128> FilePath(Filename);
   FixupRelativePath(FilePath);
-  return FS->getBufferForFile(FilePath.c_str(), -1, true, isVolatile);
+  return FS->getBufferForFile(FilePath.c_str(), -1, RequiresNullTerminator,
+                              isVolatile);
 }
 
 /// getStatValue - Get the 'stat' information for the specified path,
@@ -428,14 +471,28 @@ bool FileManager::getStatValue(StringRef Path, llvm::vfs::Status &Status,
                                std::unique_ptr<llvm::vfs::File> *F) {
   // FIXME: FileSystemOpts shouldn't be passed in here, all paths should be
   // absolute!
-  if (FileSystemOpts.WorkingDir.empty())
-    return bool(FileSystemStatCache::get(Path, Status, isFile, F,
-                                         StatCache.get(), *FS));
+  SmallString<128> FilePath;
+  if (!FileSystemOpts.WorkingDir.empty()) {
+    FilePath = Path;
+    FixupRelativePath(FilePath);
+    Path = FilePath;
+  }
 
-  SmallString<128> FilePath(Path);
-  FixupRelativePath(FilePath);
+  // A prefetched status can only stand in for a plain stat() of a file.
+  if (isFile && !F && !PrefetchedStats.empty()) {
+    auto Prefetched = PrefetchedStats.find(Path);
+    if (Prefetched != PrefetchedStats.end()) {
+      llvm::ErrorOr<llvm::vfs::Status> Result = std::move(Prefetched->second);
+      PrefetchedStats.erase(Prefetched);
+      ++NumPrefetchedStatHits;
+      if (!Result || Result->isDirectory())
+        return true;
+      Status = *Result;
+      return false;
+    }
+  }
 
-  return bool(FileSystemStatCache::get(FilePath.c_str(), Status, isFile, F,
+  return bool(FileSystemStatCache::get(Path, Status, isFile, F,
                                        StatCache.get(), *FS));
 }
 
@@ -455,6 +512,7 @@ void FileManager::invalidateCache(const FileEntry *Entry) {
   assert(Entry && "Cannot invalidate a NULL FileEntry");
 
   SeenFileEntries.erase(Entry->getName());
+  PrefetchedStats.erase(Entry->getName());
 
   // FileEntry invalidation should not block future optimizations in the file
   // caches. Possible alternatives are cache truncation (invalidate last N) or
@@ -515,6 +573,12 @@ void FileManager::PrintStats() const {
                << NumDirCacheMisses << " dir cache misses.\n";
   llvm::errs() << NumFileLookups << " file lookups, "
                << NumFileCacheMisses << " file cache misses.\n";
+  if (NumPrefetchedStats)
+    llvm::errs() << NumPrefetchedStats << " prefetched stats, "
+                 << NumPrefetchedStatHits << " used.\n";
+
+  if (StatCache)
+    StatCache->PrintStats();
 
   //llvm::errs() << PagesMapped << BytesOfPagesMapped << FSLookups;
 }
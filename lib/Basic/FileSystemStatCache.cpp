@@ -11,10 +11,17 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/Basic/FileSystemStatCache.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/Support/Chrono.h"
+#include "llvm/Support/DJB.h"
+#include "llvm/Support/EndianStream.h"
 #include "llvm/Support/ErrorOr.h"
+#include "llvm/Support/OnDiskHashTable.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/VirtualFileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+#include <chrono>
+#include <cstring>
 #include <utility>
 
 using namespace clang;
@@ -118,3 +125,292 @@ MemorizeStatCalls::getStat(StringRef Path, llvm::vfs::Status &Status,
 
   return std::error_code();
 }
+
+//===----------------------------------------------------------------------===//
+// PersistentStatCache
+//===----------------------------------------------------------------------===//
+
+namespace {
+
+/// The magic number at the start of a stat cache file.
+const char StatCacheMagic[4] = {'C', 'S', 'T', 'C'};
+
+/// The version of the stat cache file format.
+const uint32_t StatCacheVersion = 2;
+
+/// The size of the header: the magic number, the version and the offset of
+/// the hash table buckets.
+const unsigned StatCacheHeaderSize = 12;
+
+/// The size of the data of each entry.
+const unsigned StatCacheEntrySize = 24;
+
+int64_t toNanoseconds(llvm::sys::TimePoint<> Time) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             Time.time_since_epoch())
+      .count();
+}
+
+class StatCacheReaderTrait {
+public:
+  typedef StringRef external_key_type;
+  typedef StringRef internal_key_type;
+  typedef PersistentStatCache::Entry data_type;
+  typedef unsigned hash_value_type;
+  typedef unsigned offset_type;
+
+  static bool EqualKey(const internal_key_type &a, const internal_key_type &b) {
+    return a == b;
+  }
+
+  static hash_value_type ComputeHash(const internal_key_type &a) {
+    return llvm::djbHash(a);
+  }
+
+  static std::pair<unsigned, unsigned>
+  ReadKeyDataLength(const unsigned char *&d) {
+    using namespace llvm::support;
+    unsigned KeyLen = endian::readNext<uint16_t, little, unaligned>(d);
+    unsigned DataLen = endian::readNext<uint16_t, little, unaligned>(d);
+    return std::make_pair(KeyLen, DataLen);
+  }
+
+  static const internal_key_type &
+  GetInternalKey(const external_key_type &x) { return x; }
+
+  static const external_key_type &
+  GetExternalKey(const internal_key_type &x) { return x; }
+
+  static internal_key_type ReadKey(const unsigned char *d, unsigned n) {
+    return StringRef((const char *)d, n);
+  }
+
+  static data_type ReadData(const internal_key_type &k, const unsigned char *d,
+                            unsigned DataLen) {
+    using namespace llvm::support;
+    assert(DataLen == StatCacheEntrySize && "unexpected entry size");
+    (void)DataLen;
+
+    data_type Result;
+    uint64_t ParentDevice = endian::readNext<uint64_t, little, unaligned>(d);
+    uint64_t ParentFile = endian::readNext<uint64_t, little, unaligned>(d);
+    Result.ParentID = llvm::sys::fs::UniqueID(ParentDevice, ParentFile);
+    Result.ParentMTime = endian::readNext<int64_t, little, unaligned>(d);
+    return Result;
+  }
+};
+
+typedef llvm::OnDiskIterableChainedHashTable<StatCacheReaderTrait>
+    StatCacheTable;
+
+class StatCacheWriterTrait {
+public:
+  typedef StringRef key_type;
+  typedef StringRef key_type_ref;
+  typedef PersistentStatCache::Entry data_type;
+  typedef const PersistentStatCache::Entry &data_type_ref;
+  typedef unsigned hash_value_type;
+  typedef unsigned offset_type;
+
+  static hash_value_type ComputeHash(key_type_ref Key) {
+    return llvm::djbHash(Key);
+  }
+
+  std::pair<unsigned, unsigned>
+  EmitKeyDataLength(raw_ostream &Out, key_type_ref Key, data_type_ref Data) {
+    using namespace llvm::support;
+    endian::Writer LE(Out, little);
+    unsigned KeyLen = Key.size();
+    unsigned DataLen = StatCacheEntrySize;
+    LE.write<uint16_t>(KeyLen);
+    LE.write<uint16_t>(DataLen);
+    return std::make_pair(KeyLen, DataLen);
+  }
+
+  void EmitKey(raw_ostream &Out, key_type_ref Key, unsigned KeyLen) {
+    Out.write(Key.data(), KeyLen);
+  }
+
+  void EmitData(raw_ostream &Out, key_type_ref Key, data_type_ref Data,
+                unsigned DataLen) {
+    using namespace llvm::support;
+    endian::Writer LE(Out, little);
+    LE.write<uint64_t>(Data.ParentID.getDevice());
+    LE.write<uint64_t>(Data.ParentID.getFile());
+    LE.write<int64_t>(Data.ParentMTime);
+  }
+};
+
+} // namespace
+
+PersistentStatCache::PersistentStatCache(StringRef CachePath,
+                                         ArrayRef<std::string> Prefixes)
+    : CachePath(CachePath), Prefixes(Prefixes.begin(), Prefixes.end()) {
+  auto BufferOrErr = llvm::MemoryBuffer::getFile(
+      CachePath, /*FileSize=*/-1, /*RequiresNullTerminator=*/false);
+  if (!BufferOrErr)
+    return;
+
+  // A cache with an unexpected header is ignored, and replaced by the next
+  // save().
+  const unsigned char *Data =
+      reinterpret_cast<const unsigned char *>((*BufferOrErr)->getBufferStart());
+  size_t Size = (*BufferOrErr)->getBufferSize();
+  if (Size < StatCacheHeaderSize ||
+      std::memcmp(Data, StatCacheMagic, sizeof(StatCacheMagic)) != 0 ||
+      llvm::support::endian::read32le(Data + 4) != StatCacheVersion)
+    return;
+  uint32_t BucketOffset = llvm::support::endian::read32le(Data + 8);
+  if (BucketOffset < StatCacheHeaderSize || BucketOffset >= Size ||
+      BucketOffset % 4 != 0)
+    return;
+
+  Buffer = std::move(*BufferOrErr);
+  Table = StatCacheTable::Create(Data + BucketOffset,
+                                 Data + StatCacheHeaderSize, Data);
+}
+
+PersistentStatCache::~PersistentStatCache() {
+  save();
+  delete static_cast<StatCacheTable *>(Table);
+}
+
+bool PersistentStatCache::isCacheable(StringRef Path) const {
+  if (!llvm::sys::path::is_absolute(Path))
+    return false;
+  for (StringRef Prefix : Prefixes) {
+    if (!Path.startswith(Prefix))
+      continue;
+    if (Path.size() == Prefix.size() ||
+        llvm::sys::path::is_separator(Prefix.back()) ||
+        llvm::sys::path::is_separator(Path[Prefix.size()]))
+      return true;
+  }
+  return false;
+}
+
+const PersistentStatCache::DirectoryStamp *
+PersistentStatCache::getParentStamp(StringRef Parent,
+                                    llvm::vfs::FileSystem &FS) {
+  auto Known = ParentStamps.find(Parent);
+  if (Known == ParentStamps.end()) {
+    Optional<DirectoryStamp> Stamp;
+    llvm::ErrorOr<llvm::vfs::Status> Status = FS.status(Parent);
+    if (Status && Status->isDirectory()) {
+      Stamp.emplace();
+      Stamp->ID = Status->getUniqueID();
+      Stamp->MTime = toNanoseconds(Status->getLastModificationTime());
+    }
+    Known = ParentStamps.insert(std::make_pair(Parent, Stamp)).first;
+  }
+  return Known->second ? Known->second.getPointer() : nullptr;
+}
+
+std::error_code
+PersistentStatCache::getStat(StringRef Path, llvm::vfs::Status &Status,
+                             bool isFile, std::unique_ptr<llvm::vfs::File> *F,
+                             llvm::vfs::FileSystem &FS) {
+  if (!isCacheable(Path))
+    return get(Path, Status, isFile, F, nullptr, FS);
+
+  StringRef Parent = llvm::sys::path::parent_path(Path);
+  const DirectoryStamp *Stamp = getParentStamp(Parent, FS);
+  if (!Stamp)
+    return get(Path, Status, isFile, F, nullptr, FS);
+
+  if (auto *Cache = static_cast<StatCacheTable *>(Table)) {
+    auto Known = Cache->find(Path);
+    if (Known != Cache->end()) {
+      Entry Cached = *Known;
+      if (Cached.ParentID == Stamp->ID && Cached.ParentMTime == Stamp->MTime) {
+        ++NumHits;
+        return std::make_error_code(std::errc::no_such_file_or_directory);
+      }
+    }
+  }
+
+  ++NumMisses;
+  std::error_code EC = get(Path, Status, isFile, F, nullptr, FS);
+
+  // Only remember that the path doesn't exist. The status of a path which
+  // exists, or the failure to look it up for another reason, such as a
+  // permission problem, isn't cached.
+  if (EC != std::errc::no_such_file_or_directory)
+    return EC;
+  Entry New;
+  New.ParentID = Stamp->ID;
+  New.ParentMTime = Stamp->MTime;
+  NewEntries[Path] = New;
+  return EC;
+}
+
+std::error_code PersistentStatCache::save() {
+  if (NewEntries.empty())
+    return std::error_code();
+
+  llvm::OnDiskChainedHashTableGenerator<StatCacheWriterTrait> Generator;
+  StatCacheWriterTrait Trait;
+
+  // Keep the entries of the current cache file, unless they were looked up
+  // again or their parent directory is known to have changed.
+  if (auto *Cache = static_cast<StatCacheTable *>(Table)) {
+    for (StringRef Path : Cache->keys()) {
+      if (NewEntries.count(Path))
+        continue;
+      Entry Cached = *Cache->find(Path);
+      auto Stamp = ParentStamps.find(llvm::sys::path::parent_path(Path));
+      if (Stamp != ParentStamps.end() &&
+          (!Stamp->second || Stamp->second->ID != Cached.ParentID ||
+           Stamp->second->MTime != Cached.ParentMTime))
+        continue;
+      Generator.insert(Path, Cached, Trait);
+    }
+  }
+  for (const auto &New : NewEntries)
+    Generator.insert(New.first(), New.second, Trait);
+
+  SmallString<0> Contents;
+  {
+    using namespace llvm::support;
+    llvm::raw_svector_ostream Out(Contents);
+    endian::Writer LE(Out, little);
+    Out.write(StatCacheMagic, sizeof(StatCacheMagic));
+    LE.write<uint32_t>(StatCacheVersion);
+    LE.write<uint32_t>(0); // Patched below.
+    uint32_t BucketOffset = Generator.Emit(Out, Trait);
+    endian::write32le(&Contents[8], BucketOffset);
+  }
+
+  // Write the new cache next to the old one, then move it into place, so that
+  // other compilers reading the cache never see a partial file.
+  SmallString<128> TempPath(CachePath);
+  TempPath += "-%%%%%%%%";
+  int FD;
+  if (std::error_code EC = llvm::sys::fs::createUniqueFile(TempPath, FD,
+                                                           TempPath))
+    return EC;
+  {
+    llvm::raw_fd_ostream Out(FD, /*shouldClose=*/true);
+    Out << Contents;
+    Out.close();
+    if (Out.has_error()) {
+      Out.clear_error();
+      llvm::sys::fs::remove(TempPath);
+      return std::make_error_code(std::errc::io_error);
+    }
+  }
+  if (std::error_code EC = llvm::sys::fs::rename(TempPath, CachePath)) {
+    llvm::sys::fs::remove(TempPath);
+    return EC;
+  }
+
+  NewEntries.clear();
+  return std::error_code();
+}
+
+void PersistentStatCache::PrintStats() const {
+  llvm::errs() << "\n*** Persistent Stat Cache Stats:\n";
+  llvm::errs() << NumHits << " cache hits, " << NumMisses
+               << " cache misses.\n";
+  llvm::errs() << ParentStamps.size() << " directories validated.\n";
+}
@@ -22,9 +22,9 @@
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
-#include <fstream>
 #include <sstream>
 
 namespace clang {
@@ -43,6 +43,9 @@ STATISTIC(NumGetCTUSuccess,
 STATISTIC(NumTripleMismatch, "The # of triple mismatches");
 STATISTIC(NumLangMismatch, "The # of language mismatches");
 STATISTIC(NumLangDialectMismatch, "The # of language dialect mismatches");
+STATISTIC(NumASTLoaded, "The # of AST files loaded");
+STATISTIC(NumASTUnloaded,
+          "The # of AST files unloaded to stay within the memory limit");
 
 // Same as Triple's equality operator, but we check a field only if that is
 // known in both instances.
@@ -122,26 +125,30 @@ std::error_code IndexError::convertToErrorCode() const {
 
 llvm::Expected<llvm::StringMap<std::string>>
 parseCrossTUIndex(StringRef IndexPath, StringRef CrossTUDir) {
-  std::ifstream ExternalMapFile(IndexPath);
-  if (!ExternalMapFile)
+  // The index of a large project can have millions of lines, so split the
+  // lines in place instead of copying each of them.
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> BufferOrErr =
+      llvm::MemoryBuffer::getFile(IndexPath, /*FileSize=*/-1,
+                                  /*RequiresNullTerminator=*/false);
+  if (!BufferOrErr)
     return llvm::make_error<IndexError>(index_error_code::missing_index_file,
                                         IndexPath.str());
 
   llvm::StringMap<std::string> Result;
-  std::string Line;
+  StringRef Rest = (*BufferOrErr)->getBuffer();
   unsigned LineNo = 1;
-  while (std::getline(ExternalMapFile, Line)) {
-    const size_t Pos = Line.find(" ");
-    if (Pos > 0 && Pos != std::string::npos) {
-      StringRef LineRef{Line};
-      StringRef LookupName = LineRef.substr(0, Pos);
-      if (Result.count(LookupName))
-        return llvm::make_error<IndexError>(
-            index_error_code::multiple_definitions, IndexPath.str(), LineNo);
-      StringRef FileName = LineRef.substr(Pos + 1);
+  while (!Rest.empty()) {
+    StringRef Line;
+    std::tie(Line, Rest) = Rest.split('\n');
+    const size_t Pos = Line.find(' ');
+    if (Pos > 0 && Pos != StringRef::npos) {
+      StringRef LookupName = Line.substr(0, Pos);
+      StringRef FileName = Line.substr(Pos + 1);
       SmallString<256> FilePath = CrossTUDir;
       llvm::sys::path::append(FilePath, FileName);
-      Result[LookupName] = FilePath.str().str();
+      if (!Result.try_emplace(LookupName, FilePath.str()).second)
+        return llvm::make_error<IndexError>(
+            index_error_code::multiple_definitions, IndexPath.str(), LineNo);
     } else
       return llvm::make_error<IndexError>(
           index_error_code::invalid_index_format, IndexPath.str(), LineNo);
@@ -192,28 +199,45 @@ std::string CrossTranslationUnitContext::getLookupName(const NamedDecl *ND) {
   return DeclUSR.str();
 }
 
-/// Recursively visits the decls of a DeclContext, and returns one with the
-/// given USR.
 template <typename T>
-const T *
-CrossTranslationUnitContext::findDefInDeclContext(const DeclContext *DC,
-                                                  StringRef LookupName) {
+static void addDefinition(const Decl *D,
+                          llvm::StringMap<const Decl *> &Definitions) {
+  const auto *ND = dyn_cast<T>(D);
+  const T *ResultDecl;
+  if (!ND || !hasBodyOrInit(ND, ResultDecl))
+    return;
+  // Keep the first definition with a given USR, like a lookup visiting the
+  // decls in order would.
+  Definitions.try_emplace(
+      CrossTranslationUnitContext::getLookupName(ResultDecl), ResultDecl);
+}
+
+/// Recursively visits the decls of a DeclContext, and collects the definitions
+/// of functions and variables by their USR.
+static void collectDefinitions(const DeclContext *DC,
+                               llvm::StringMap<const Decl *> &Definitions) {
   assert(DC && "Declaration Context must not be null");
   for (const Decl *D : DC->decls()) {
-    const auto *SubDC = dyn_cast<DeclContext>(D);
-    if (SubDC)
-      if (const auto *ND = findDefInDeclContext<T>(SubDC, LookupName))
-        return ND;
-
-    const auto *ND = dyn_cast<T>(D);
-    const T *ResultDecl;
-    if (!ND || !hasBodyOrInit(ND, ResultDecl))
-      continue;
-    if (getLookupName(ResultDecl) != LookupName)
-      continue;
-    return ResultDecl;
+    if (const auto *SubDC = dyn_cast<DeclContext>(D))
+      collectDefinitions(SubDC, Definitions);
+    addDefinition<FunctionDecl>(D, Definitions);
+    addDefinition<VarDecl>(D, Definitions);
   }
-  return nullptr;
+}
+
+/// Returns the definition with the given USR in the unit. All the definitions
+/// are collected the first time, as visiting the decls of the unit and
+/// generating their USRs is expensive, and the analysis usually looks up
+/// many definitions in the same unit.
+template <typename T>
+const T *CrossTranslationUnitContext::findDefinition(LoadedAST &AST,
+                                                     StringRef LookupName) {
+  if (!AST.HasDefinitions) {
+    collectDefinitions(AST.Unit->getASTContext().getTranslationUnitDecl(),
+                       AST.Definitions);
+    AST.HasDefinitions = true;
+  }
+  return dyn_cast_or_null<T>(AST.Definitions.lookup(LookupName));
 }
 
 template <typename T>
@@ -228,11 +252,11 @@ llvm::Expected<const T *> CrossTranslationUnitContext::getCrossTUDefinitionImpl(
   if (LookupName.empty())
     return llvm::make_error<IndexError>(
         index_error_code::failed_to_generate_usr);
-  llvm::Expected<ASTUnit *> ASTUnitOrError =
-      loadExternalAST(LookupName, CrossTUDir, IndexName, DisplayCTUProgress);
-  if (!ASTUnitOrError)
-    return ASTUnitOrError.takeError();
-  ASTUnit *Unit = *ASTUnitOrError;
+  llvm::Expected<LoadedAST *> ASTOrError = loadExternalASTImpl(
+      LookupName, CrossTUDir, IndexName, DisplayCTUProgress);
+  if (!ASTOrError)
+    return ASTOrError.takeError();
+  ASTUnit *Unit = (*ASTOrError)->Unit.get();
   assert(&Unit->getFileManager() ==
          &Unit->getASTContext().getSourceManager().getFileManager());
 
@@ -284,8 +308,7 @@ llvm::Expected<const T *> CrossTranslationUnitContext::getCrossTUDefinitionImpl(
         index_error_code::lang_dialect_mismatch);
   }
 
-  TranslationUnitDecl *TU = Unit->getASTContext().getTranslationUnitDecl();
-  if (const T *ResultDecl = findDefInDeclContext<T>(TU, LookupName))
+  if (const T *ResultDecl = findDefinition<T>(**ASTOrError, LookupName))
     return importDefinition(ResultDecl);
   return llvm::make_error<IndexError>(index_error_code::failed_import);
 }
@@ -334,11 +357,23 @@ void CrossTranslationUnitContext::emitCrossTUDiagnostics(const IndexError &IE) {
 llvm::Expected<ASTUnit *> CrossTranslationUnitContext::loadExternalAST(
     StringRef LookupName, StringRef CrossTUDir, StringRef IndexName,
     bool DisplayCTUProgress) {
+  llvm::Expected<LoadedAST *> ASTOrError = loadExternalASTImpl(
+      LookupName, CrossTUDir, IndexName, DisplayCTUProgress);
+  if (!ASTOrError)
+    return ASTOrError.takeError();
+  return (*ASTOrError)->Unit.get();
+}
+
+llvm::Expected<CrossTranslationUnitContext::LoadedAST *>
+CrossTranslationUnitContext::loadExternalASTImpl(StringRef LookupName,
+                                                 StringRef CrossTUDir,
+                                                 StringRef IndexName,
+                                                 bool DisplayCTUProgress) {
   // FIXME: The current implementation only supports loading decls with
   //        a lookup name from a single translation unit. If multiple
   //        translation units contains decls with the same lookup name an
   //        error will be returned.
-  ASTUnit *Unit = nullptr;
+  LoadedAST *AST = nullptr;
   auto NameUnitCacheEntry = NameASTUnitMap.find(LookupName);
   if (NameUnitCacheEntry == NameASTUnitMap.end()) {
     if (NameFileMap.empty()) {
@@ -350,7 +385,7 @@ llvm::Expected<ASTUnit *> CrossTranslationUnitContext::loadExternalAST(
       llvm::Expected<llvm::StringMap<std::string>> IndexOrErr =
           parseCrossTUIndex(IndexFile, CrossTUDir);
       if (IndexOrErr)
-        NameFileMap = *IndexOrErr;
+        NameFileMap = std::move(*IndexOrErr);
       else
         return IndexOrErr.takeError();
     }
@@ -370,26 +405,85 @@ llvm::Expected<ASTUnit *> CrossTranslationUnitContext::loadExternalAST(
       IntrusiveRefCntPtr<DiagnosticsEngine> Diags(
           new DiagnosticsEngine(DiagID, &*DiagOpts, DiagClient));
 
-      std::unique_ptr<ASTUnit> LoadedUnit(ASTUnit::LoadFromASTFile(
+      AST = &FileASTUnitMap[ASTFileName];
+      AST->Unit = ASTUnit::LoadFromASTFile(
           ASTFileName, CI.getPCHContainerOperations()->getRawReader(),
-          ASTUnit::LoadEverything, Diags, CI.getFileSystemOpts()));
-      Unit = LoadedUnit.get();
-      FileASTUnitMap[ASTFileName] = std::move(LoadedUnit);
+          ASTUnit::LoadEverything, Diags, CI.getFileSystemOpts());
+      ++NumASTLoaded;
       if (DisplayCTUProgress) {
         llvm::errs() << "CTU loaded AST file: "
                      << ASTFileName << "\n";
       }
+      unloadLeastRecentlyUsedASTs(AST, DisplayCTUProgress);
     } else {
-      Unit = ASTCacheEntry->second.get();
+      AST = &ASTCacheEntry->second;
     }
-    NameASTUnitMap[LookupName] = Unit;
+    NameASTUnitMap[LookupName] = AST;
   } else {
-    Unit = NameUnitCacheEntry->second;
+    AST = NameUnitCacheEntry->second;
   }
-  if (!Unit)
+  if (!AST->Unit)
     return llvm::make_error<IndexError>(
         index_error_code::failed_to_get_external_ast);
-  return Unit;
+  AST->LastUse = ++UseCounter;
+  return AST;
+}
+
+/// Returns the heap memory used by the unit, which grows as more of its decls
+/// are deserialized.
+static uint64_t getLoadedASTMemory(ASTUnit &Unit) {
+  const ASTContext &Ctx = Unit.getASTContext();
+  const SourceManager &SM = Unit.getSourceManager();
+  return Ctx.getASTAllocatedMemory() + Ctx.getSideTableAllocatedMemory() +
+         SM.getContentCacheSize() + SM.getDataStructureSizes();
+}
+
+unsigned CrossTranslationUnitContext::getNumLoadedASTs() const {
+  unsigned NumLoaded = 0;
+  for (const auto &E : FileASTUnitMap)
+    if (E.second.Unit)
+      ++NumLoaded;
+  return NumLoaded;
+}
+
+void CrossTranslationUnitContext::unloadLeastRecentlyUsedASTs(
+    const LoadedAST *Keep, bool DisplayCTUProgress) {
+  if (!MaxLoadedASTMemory)
+    return;
+
+  uint64_t LoadedMemory = 0;
+  for (const auto &E : FileASTUnitMap)
+    if (E.second.Unit)
+      LoadedMemory += getLoadedASTMemory(*E.second.Unit);
+
+  while (LoadedMemory > MaxLoadedASTMemory) {
+    auto Victim = FileASTUnitMap.end();
+    for (auto I = FileASTUnitMap.begin(), E = FileASTUnitMap.end(); I != E;
+         ++I) {
+      if (!I->second.Unit || &I->second == Keep)
+        continue;
+      if (Victim == E || I->second.LastUse < Victim->second.LastUse)
+        Victim = I;
+    }
+    if (Victim == FileASTUnitMap.end())
+      return;
+
+    // The imported definitions are copies owned by the current AST, so only
+    // the importer and the caches refer to the unit.
+    LoadedAST *AST = &Victim->second;
+    LoadedMemory -= getLoadedASTMemory(*AST->Unit);
+    ASTUnitImporterMap.erase(
+        AST->Unit->getASTContext().getTranslationUnitDecl());
+    for (auto I = NameASTUnitMap.begin(), E = NameASTUnitMap.end(); I != E;) {
+      auto Cur = I++;
+      if (Cur->second == AST)
+        NameASTUnitMap.erase(Cur);
+    }
+    ++NumASTUnloaded;
+    if (DisplayCTUProgress)
+      llvm::errs() << "CTU unloaded AST file: " << Victim->getKey() << "\n";
+    FileASTUnitMap.erase(Victim);
+  }
 }
 
 template <typename T>
@@ -17,14 +17,23 @@
 #include "clang/Driver/Util.h"
 #include "llvm/ADT/None.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Option/ArgList.h"
 #include "llvm/Option/OptSpecifier.h"
 #include "llvm/Option/Option.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <cassert>
+#include <condition_variable>
+#include <mutex>
 #include <string>
 #include <system_error>
 #include <utility>
@@ -148,8 +157,7 @@ bool Compilation::CleanupFileMap(const ArgStringMap &Files,
   return Success;
 }
 
-int Compilation::ExecuteCommand(const Command &C,
-                                const Command *&FailingCommand) const {
+bool Compilation::PrintCommand(const Command &C) const {
   if ((getDriver().CCPrintOptions ||
        getArgs().hasArg(options::OPT_v)) && !getDriver().CCGenDiagnostics) {
     raw_ostream *OS = &llvm::errs();
@@ -164,9 +172,8 @@ int Compilation::ExecuteCommand(const Command &C,
       if (EC) {
         getDriver().Diag(diag::err_drv_cc_print_options_failure)
             << EC.message();
-        FailingCommand = &C;
         delete OS;
-        return 1;
+        return false;
       }
     }
 
@@ -178,6 +185,15 @@ int Compilation::ExecuteCommand(const Command &C,
     if (OS != &llvm::errs())
       delete OS;
   }
+  return true;
+}
+
+int Compilation::ExecuteCommand(const Command &C,
+                                const Command *&FailingCommand) const {
+  if (!PrintCommand(C)) {
+    FailingCommand = &C;
+    return 1;
+  }
 
   std::string Error;
   bool ExecutionFailed;
@@ -224,6 +240,17 @@ static bool InputsOk(const Command &C,
 
 void Compilation::ExecuteJobs(const JobList &Jobs,
                               FailingCommandList &FailingCommands) const {
+  unsigned NumThreads = TheDriver.ParallelJobs;
+  if (NumThreads == 0)
+    NumThreads = llvm::hardware_concurrency();
+  // clang-cl prints the input file names from Command::Execute and falls back
+  // to cl.exe from there as well, so it always executes its jobs serially.
+  if (LLVM_ENABLE_THREADS && NumThreads > 1 && Jobs.size() > 1 &&
+      !TheDriver.IsCLMode()) {
+    ExecuteJobsInParallel(Jobs, NumThreads, FailingCommands);
+    return;
+  }
+
   // According to UNIX standard, driver need to continue compiling all the
   // inputs on the command line even one of them failed.
   // In all but CLMode, execute all the jobs unless the necessary inputs for the
@@ -241,6 +268,172 @@ void Compilation::ExecuteJobs(const JobList &Jobs,
   }
 }
 
+/// Collect \p A and all of the actions it (transitively) consumes.
+static void CollectActionInputs(const Action *A,
+                                llvm::SmallPtrSetImpl<const Action *> &Set) {
+  if (!Set.insert(A).second)
+    return;
+  for (const auto *AI : A->inputs())
+    CollectActionInputs(AI, Set);
+}
+
+/// Copy the contents of the file \p Path to \p OS and remove the file.
+static void ReplayCapturedOutput(StringRef Path, raw_ostream &OS) {
+  if (Path.empty())
+    return;
+  if (auto Buffer = llvm::MemoryBuffer::getFile(Path)) {
+    OS << (*Buffer)->getBuffer();
+    OS.flush();
+  }
+  llvm::sys::fs::remove(Path);
+}
+
+namespace {
+/// The scheduling state of one job in Compilation::ExecuteJobsInParallel.
+struct ParallelJob {
+  enum StateKind { Waiting, Running, Finished, Skipped };
+
+  const Command *Cmd = nullptr;
+  StateKind State = Waiting;
+
+  /// Indices of the jobs which must finish before this one can start.
+  SmallVector<unsigned, 4> Dependencies;
+
+  /// Files capturing the output of the job, so that it can be printed
+  /// without interleaving with the output of other jobs.
+  SmallString<128> StdoutPath, StderrPath;
+  Optional<StringRef> Redirects[3];
+
+  int Result = 0;
+  std::string Error;
+  bool ExecutionFailed = false;
+};
+} // namespace
+
+void Compilation::ExecuteJobsInParallel(
+    const JobList &Jobs, unsigned NumThreads,
+    FailingCommandList &FailingCommands) const {
+  NumThreads = std::min<unsigned>(NumThreads, Jobs.size());
+  std::vector<ParallelJob> Work(Jobs.size());
+  {
+    unsigned I = 0;
+    for (const auto &Job : Jobs)
+      Work[I++].Cmd = &Job;
+  }
+
+  // A job depends on every earlier job whose action it consumes, directly or
+  // through intermediate actions. Commands created for the same action keep
+  // their relative order.
+  for (unsigned I = 0, E = Work.size(); I != E; ++I) {
+    llvm::SmallPtrSet<const Action *, 16> Inputs;
+    CollectActionInputs(&Work[I].Cmd->getSource(), Inputs);
+    for (unsigned J = 0; J != I; ++J)
+      if (Inputs.count(&Work[J].Cmd->getSource()))
+        Work[I].Dependencies.push_back(J);
+  }
+
+  // Unless the output of the compilation is already redirected, capture the
+  // output of every job and print it once the job is done.
+  bool CaptureOutput = Redirects.empty();
+
+  std::mutex Mutex;
+  std::condition_variable JobFinished;
+  SmallVector<unsigned, 8> FinishedJobs;
+  llvm::ThreadPool Pool(NumThreads);
+
+  unsigned NumRunning = 0;
+  unsigned NextToReplay = 0;
+  while (true) {
+    // Start every job whose dependencies are done, as long as there is a
+    // free thread for it.
+    for (ParallelJob &PJ : Work) {
+      if (NumRunning == NumThreads)
+        break;
+      if (PJ.State != ParallelJob::Waiting)
+        continue;
+      if (llvm::any_of(PJ.Dependencies, [&](unsigned Dep) {
+            return Work[Dep].State == ParallelJob::Waiting ||
+                   Work[Dep].State == ParallelJob::Running;
+          }))
+        continue;
+
+      if (!InputsOk(*PJ.Cmd, FailingCommands)) {
+        PJ.State = ParallelJob::Skipped;
+        continue;
+      }
+
+      if (!PrintCommand(*PJ.Cmd)) {
+        PJ.State = ParallelJob::Skipped;
+        FailingCommands.push_back(std::make_pair(1, PJ.Cmd));
+        continue;
+      }
+
+      ArrayRef<Optional<StringRef>> JobRedirects = Redirects;
+      if (CaptureOutput &&
+          !llvm::sys::fs::createTemporaryFile("clang-job", "out",
+                                              PJ.StdoutPath) &&
+          !llvm::sys::fs::createTemporaryFile("clang-job", "err",
+                                              PJ.StderrPath)) {
+        PJ.Redirects[1] = StringRef(PJ.StdoutPath);
+        PJ.Redirects[2] = StringRef(PJ.StderrPath);
+        JobRedirects = PJ.Redirects;
+      }
+
+      PJ.State = ParallelJob::Running;
+      ++NumRunning;
+      unsigned Index = &PJ - Work.data();
+      Pool.async([&, Index, JobRedirects] {
+        ParallelJob &Job = Work[Index];
+        Job.Result =
+            Job.Cmd->Execute(JobRedirects, &Job.Error, &Job.ExecutionFailed);
+        std::lock_guard<std::mutex> Lock(Mutex);
+        FinishedJobs.push_back(Index);
+        JobFinished.notify_one();
+      });
+    }
+
+    if (NumRunning == 0)
+      break;
+
+    SmallVector<unsigned, 8> Done;
+    {
+      std::unique_lock<std::mutex> Lock(Mutex);
+      JobFinished.wait(Lock, [&] { return !FinishedJobs.empty(); });
+      Done.swap(FinishedJobs);
+    }
+
+    for (unsigned Index : Done) {
+      ParallelJob &PJ = Work[Index];
+      PJ.State = ParallelJob::Finished;
+      --NumRunning;
+      if (!PJ.Error.empty()) {
+        assert(PJ.Result && "Error string set with 0 result code!");
+        getDriver().Diag(diag::err_drv_command_failure) << PJ.Error;
+      }
+      if (int Res = PJ.ExecutionFailed ? 1 : PJ.Result)
+        FailingCommands.push_back(std::make_pair(Res, PJ.Cmd));
+    }
+
+    // Print the output of the finished jobs in job order.
+    for (; NextToReplay != Work.size(); ++NextToReplay) {
+      ParallelJob &PJ = Work[NextToReplay];
+      if (PJ.State == ParallelJob::Waiting || PJ.State == ParallelJob::Running)
+        break;
+      ReplayCapturedOutput(PJ.StdoutPath, llvm::outs());
+      ReplayCapturedOutput(PJ.StderrPath, llvm::errs());
+    }
+  }
+
+  Pool.wait();
+
+  // Jobs skipped in the last scheduling pass have nothing to print, but
+  // finished ones queued behind them still do.
+  for (; NextToReplay != Work.size(); ++NextToReplay) {
+    ReplayCapturedOutput(Work[NextToReplay].StdoutPath, llvm::outs());
+    ReplayCapturedOutput(Work[NextToReplay].StderrPath, llvm::errs());
+  }
+}
+
 void Compilation::initCompilationForDiagnostics() {
   ForDiagnostics = true;
 
@@ -1017,6 +1017,18 @@ Compilation *Driver::BuildCompilation(ArrayRef<const char *> ArgList) {
   // Ignore -pipe.
   Args.ClaimAllArgs(options::OPT_pipe);
 
+  // -fparallel-jobs only controls how the jobs are scheduled.
+  if (const Arg *A = Args.getLastArg(options::OPT_fparallel_jobs_EQ)) {
+    StringRef Value = A->getValue();
+    if (Value.getAsInteger(10, ParallelJobs)) {
+      Diag(diag::err_drv_invalid_int_value) << A->getAsString(Args) << Value;
+      ParallelJobs = 1;
+    }
+  }
+
+  IntegratedCC1 = Args.hasFlag(options::OPT_fintegrated_cc1,
+                               options::OPT_fno_integrated_cc1, false);
+
   // Extract -ccc args.
   //
   // FIXME: We need to figure out where this behavior should live. Most of it
@@ -3518,6 +3530,14 @@ void Driver::BuildJobs(Compilation &C) const {
                        /*TargetDeviceOffloadKind*/ Action::OFK_None);
   }
 
+  // cc1 leaves global state such as -mllvm options behind, so only a lone cc1
+  // job may run inside the driver process.
+  if (llvm::count_if(C.getJobs(), [](const Command &Job) {
+        return Job.isInProcess();
+      }) > 1)
+    for (auto &Job : C.getJobs())
+      Job.setInProcess(false);
+
   // If the user passed -Qunused-arguments or there were errors, don't warn
   // about any unused arguments.
   if (Diags.hasErrorOccurred() ||
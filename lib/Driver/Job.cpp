@@ -14,13 +14,17 @@
 #include "clang/Driver/Tool.h"
 #include "clang/Driver/ToolChain.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/StringSwitch.h"
+#include "llvm/Support/CrashRecoveryContext.h"
+#include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
@@ -313,13 +317,17 @@ void Command::setEnvironment(llvm::ArrayRef<const char *> NewEnvironment) {
   Environment.push_back(nullptr);
 }
 
-int Command::Execute(ArrayRef<llvm::Optional<StringRef>> Redirects,
-                     std::string *ErrMsg, bool *ExecutionFailed) const {
+void Command::PrintFileNames() const {
   if (PrintInputFilenames) {
     for (const char *Arg : InputFilenames)
       llvm::outs() << llvm::sys::path::filename(Arg) << "\n";
     llvm::outs().flush();
   }
+}
+
+int Command::Execute(ArrayRef<llvm::Optional<StringRef>> Redirects,
+                     std::string *ErrMsg, bool *ExecutionFailed) const {
+  PrintFileNames();
 
   SmallVector<const char*, 128> Argv;
 
@@ -370,6 +378,83 @@ int Command::Execute(ArrayRef<llvm::Optional<StringRef>> Redirects,
                                    /*memoryLimit*/ 0, ErrMsg, ExecutionFailed);
 }
 
+/// Where the cc1 job running inside the driver process on this thread, if
+/// any, stores the exit status it fails with.
+static LLVM_THREAD_LOCAL int *InProcessRetCode = nullptr;
+
+CC1Command::CC1Command(const Action &Source, const Tool &Creator,
+                       const char *Executable,
+                       const llvm::opt::ArgStringList &Arguments,
+                       ArrayRef<InputInfo> Inputs)
+    : Command(Source, Creator, Executable, Arguments, Inputs) {
+  // Jobs re-run to generate crash diagnostics always use a fresh process, as
+  // the state of this one may be what made the original job crash.
+  const Driver &D = Creator.getToolChain().getDriver();
+  setInProcess(D.CC1Main && D.IntegratedCC1 && !D.CCGenDiagnostics);
+}
+
+void CC1Command::Print(raw_ostream &OS, const char *Terminator, bool Quote,
+                       CrashReportInfo *CrashInfo) const {
+  if (isInProcess())
+    OS << " (in-process)\n";
+  Command::Print(OS, Terminator, Quote, CrashInfo);
+}
+
+int CC1Command::Execute(ArrayRef<llvm::Optional<StringRef>> Redirects,
+                        std::string *ErrMsg, bool *ExecutionFailed) const {
+  // The standard streams of the driver can't be redirected for a single job,
+  // so fall back to a new process if that was requested.
+  if (!isInProcess() ||
+      llvm::any_of(Redirects,
+                   [](const Optional<StringRef> &R) { return R.hasValue(); }))
+    return Command::Execute(Redirects, ErrMsg, ExecutionFailed);
+
+  PrintFileNames();
+
+  SmallVector<const char *, 128> Argv;
+  Argv.push_back(getExecutable());
+  Argv.append(getArguments().begin(), getArguments().end());
+
+  // This flag indicates that the program couldn't be started, which can't
+  // happen here.
+  if (ExecutionFailed)
+    *ExecutionFailed = false;
+
+  llvm::CrashRecoveryContext::Enable();
+  llvm::CrashRecoveryContext CRC;
+  const void *PrettyState = llvm::SavePrettyStackState();
+  const Driver &D = getCreator().getToolChain().getDriver();
+
+  // A crash is reported like a child process killed by a signal, so that the
+  // driver still generates the crash reproducer.
+  int RetCode = -2;
+  int *OuterRetCode = InProcessRetCode;
+  InProcessRetCode = &RetCode;
+
+  int Res = 0;
+  bool Finished = CRC.RunSafely([&]() { Res = D.CC1Main(Argv); });
+  InProcessRetCode = OuterRetCode;
+  if (!Finished) {
+    llvm::RestorePrettyStackState(PrettyState);
+    // cc1 didn't get to remove its fatal error handler, which refers to its
+    // now destroyed diagnostics engine.
+    llvm::remove_fatal_error_handler();
+    return RetCode;
+  }
+  return Res;
+}
+
+bool CC1Command::isRunningInProcess() {
+  return InProcessRetCode && llvm::CrashRecoveryContext::GetCurrent();
+}
+
+void CC1Command::exitInProcess(int RetCode) {
+  assert(isRunningInProcess() && "no cc1 job is running in-process");
+  *InProcessRetCode = RetCode;
+  llvm::CrashRecoveryContext::GetCurrent()->HandleCrash();
+  llvm_unreachable("HandleCrash returned");
+}
+
 FallbackCommand::FallbackCommand(const Action &Source_, const Tool &Creator_,
                                  const char *Executable_,
                                  const llvm::opt::ArgStringList &Arguments_,
@@ -31,6 +31,7 @@
 #include "clang/Lex/Lexer.h"
 #include "clang/Tooling/Inclusions/HeaderIncludes.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/Debug.h"
@@ -38,6 +39,7 @@
 #include "llvm/Support/Regex.h"
 #include "llvm/Support/VirtualFileSystem.h"
 #include "llvm/Support/YAMLTraits.h"
+#include "llvm/Support/xxhash.h"
 #include <algorithm>
 #include <memory>
 #include <mutex>
@@ -1239,8 +1241,8 @@ private:
 class Formatter : public TokenAnalyzer {
 public:
   Formatter(const Environment &Env, const FormatStyle &Style,
-            FormattingAttemptStatus *Status)
-      : TokenAnalyzer(Env, Style), Status(Status) {}
+            FormattingAttemptStatus *Status, LineFormattingCache *Cache)
+      : TokenAnalyzer(Env, Style), Status(Status), Cache(Cache) {}
 
   std::pair<tooling::Replacements, unsigned>
   analyze(TokenAnnotator &Annotator,
@@ -1260,10 +1262,18 @@ public:
     ContinuationIndenter Indenter(Style, Tokens.getKeywords(),
                                   Env.getSourceManager(), Whitespaces, Encoding,
                                   BinPackInconclusiveFunctions);
+    // The cached line breaks also depend on the local style derived from the
+    // file.
+    std::string CacheKeyPrefix;
+    if (Cache)
+      CacheKeyPrefix =
+          llvm::utohexstr(llvm::xxHash64(configurationAsText(Style))) + ' ' +
+          llvm::utostr(Encoding) + ' ' +
+          llvm::utostr(BinPackInconclusiveFunctions);
     unsigned Penalty =
         UnwrappedLineFormatter(&Indenter, &Whitespaces, Style,
                                Tokens.getKeywords(), Env.getSourceManager(),
-                               Status)
+                               Status, Cache, CacheKeyPrefix)
             .format(AnnotatedLines, /*DryRun=*/false,
                     /*AdditionalIndent=*/0,
                     /*FixBadIndentation=*/false,
@@ -1350,6 +1360,7 @@ private:
 
   bool BinPackInconclusiveFunctions;
   FormattingAttemptStatus *Status;
+  LineFormattingCache *Cache;
 };
 
 // This class clean up the erroneous/redundant code around the given ranges in
@@ -2247,7 +2258,7 @@ std::pair<tooling::Replacements, unsigned>
 reformat(const FormatStyle &Style, StringRef Code,
          ArrayRef<tooling::Range> Ranges, unsigned FirstStartColumn,
          unsigned NextStartColumn, unsigned LastStartColumn, StringRef FileName,
-         FormattingAttemptStatus *Status) {
+         FormattingAttemptStatus *Status, LineFormattingCache *Cache) {
   FormatStyle Expanded = expandPresets(Style);
   if (Expanded.DisableFormat)
     return {tooling::Replacements(), 0};
@@ -2280,7 +2291,7 @@ reformat(const FormatStyle &Style, StringRef Code,
     });
 
   Passes.emplace_back([&](const Environment &Env) {
-    return Formatter(Env, Expanded, Status).process();
+    return Formatter(Env, Expanded, Status, Cache).process();
   });
 
   auto Env =
@@ -2313,11 +2324,12 @@ reformat(const FormatStyle &Style, StringRef Code,
 tooling::Replacements reformat(const FormatStyle &Style, StringRef Code,
                                ArrayRef<tooling::Range> Ranges,
                                StringRef FileName,
-                               FormattingAttemptStatus *Status) {
+                               FormattingAttemptStatus *Status,
+                               LineFormattingCache *Cache) {
   return internal::reformat(Style, Code, Ranges,
                             /*FirstStartColumn=*/0,
                             /*NextStartColumn=*/0,
-                            /*LastStartColumn=*/0, FileName, Status)
+                            /*LastStartColumn=*/0, FileName, Status, Cache)
       .first;
 }
 
@@ -69,11 +69,15 @@ namespace internal {
 ///
 /// If ``Status`` is non-null, its value will be populated with the status of
 /// this formatting attempt. See \c FormattingAttemptStatus.
+///
+/// If ``Cache`` is non-null, it is used for the line breaks of the formatted
+/// lines. See \c LineFormattingCache.
 std::pair<tooling::Replacements, unsigned>
 reformat(const FormatStyle &Style, StringRef Code,
          ArrayRef<tooling::Range> Ranges, unsigned FirstStartColumn,
          unsigned NextStartColumn, unsigned LastStartColumn, StringRef FileName,
-         FormattingAttemptStatus *Status);
+         FormattingAttemptStatus *Status,
+         LineFormattingCache *Cache = nullptr);
 
 } // namespace internal
 } // namespace format
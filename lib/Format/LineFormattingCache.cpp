@@ -0,0 +1,126 @@
+//===--- LineFormattingCache.cpp - Cache of line breaks -------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file implements LineFormattingCache, which remembers the line breaks
+/// chosen for formatted lines across calls to reformat().
+///
+//===----------------------------------------------------------------------===//
+
+#include "clang/Format/Format.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/raw_ostream.h"
+#include <mutex>
+
+namespace clang {
+namespace format {
+
+/// The first line of a saved cache. Bump the version when the format of the
+/// keys changes, so that the saved caches are discarded.
+static const char CacheHeader[] = "clang-format line cache 1\n";
+
+struct LineFormattingCache::Implementation {
+  struct CachedEntry {
+    Entry E;
+    /// Whether the entry was looked up or added since it was loaded.
+    bool Used = false;
+  };
+
+  mutable std::mutex Lock;
+  llvm::StringMap<CachedEntry> Entries;
+  unsigned NumHits = 0;
+  unsigned NumMisses = 0;
+};
+
+LineFormattingCache::LineFormattingCache() : Impl(new Implementation) {}
+
+LineFormattingCache::~LineFormattingCache() = default;
+
+llvm::Optional<LineFormattingCache::Entry>
+LineFormattingCache::lookup(StringRef Key) {
+  std::lock_guard<std::mutex> LockGuard(Impl->Lock);
+  auto It = Impl->Entries.find(Key);
+  if (It == Impl->Entries.end()) {
+    ++Impl->NumMisses;
+    return None;
+  }
+  ++Impl->NumHits;
+  It->second.Used = true;
+  return It->second.E;
+}
+
+void LineFormattingCache::insert(StringRef Key, Entry E) {
+  std::lock_guard<std::mutex> LockGuard(Impl->Lock);
+  Implementation::CachedEntry &Cached = Impl->Entries[Key];
+  Cached.E = std::move(E);
+  Cached.Used = true;
+}
+
+// Each entry is saved as a header line with the penalty, the line breaks and
+// the length of the key, followed by the key and a newline. The keys contain
+// source text, so they can't be delimited by newlines.
+bool LineFormattingCache::load(StringRef Buffer) {
+  if (!Buffer.consume_front(CacheHeader))
+    return false;
+
+  llvm::StringMap<Implementation::CachedEntry> Loaded;
+  while (!Buffer.empty()) {
+    StringRef Header;
+    std::tie(Header, Buffer) = Buffer.split('\n');
+    StringRef PenaltyText, NewLinesText, KeyLengthText;
+    std::tie(PenaltyText, Header) = Header.split(' ');
+    std::tie(NewLinesText, KeyLengthText) = Header.split(' ');
+
+    Implementation::CachedEntry Cached;
+    size_t KeyLength;
+    if (PenaltyText.getAsInteger(10, Cached.E.Penalty) ||
+        KeyLengthText.getAsInteger(10, KeyLength) ||
+        !NewLinesText.consume_front("+") || KeyLength >= Buffer.size() ||
+        Buffer[KeyLength] != '\n')
+      return false;
+    for (char C : NewLinesText) {
+      if (C != '0' && C != '1')
+        return false;
+      Cached.E.NewLines.push_back(C == '1');
+    }
+    Loaded[Buffer.take_front(KeyLength)] = std::move(Cached);
+    Buffer = Buffer.drop_front(KeyLength + 1);
+  }
+
+  std::lock_guard<std::mutex> LockGuard(Impl->Lock);
+  for (auto &E : Loaded)
+    Impl->Entries.try_emplace(E.getKey(), std::move(E.second));
+  return true;
+}
+
+void LineFormattingCache::save(raw_ostream &OS) const {
+  std::lock_guard<std::mutex> LockGuard(Impl->Lock);
+  OS << CacheHeader;
+  for (const auto &E : Impl->Entries) {
+    if (!E.second.Used)
+      continue;
+    // The line breaks are prefixed so that they are never empty.
+    OS << E.second.E.Penalty << " +";
+    for (bool NewLine : E.second.E.NewLines)
+      OS << (NewLine ? '1' : '0');
+    OS << ' ' << E.getKey().size() << '\n' << E.getKey() << '\n';
+  }
+}
+
+unsigned LineFormattingCache::getNumHits() const {
+  std::lock_guard<std::mutex> LockGuard(Impl->Lock);
+  return Impl->NumHits;
+}
+
+unsigned LineFormattingCache::getNumMisses() const {
+  std::lock_guard<std::mutex> LockGuard(Impl->Lock);
+  return Impl->NumMisses;
+}
+
+} // namespace format
+} // namespace clang
@@ -10,6 +10,7 @@
 #include "NamespaceEndCommentsFixer.h"
 #include "WhitespaceManager.h"
 #include "llvm/Support/Debug.h"
+#include <chrono>
 #include <queue>
 
 #define DEBUG_TYPE "format-formatter"
@@ -832,11 +833,18 @@ public:
 /// Finds the best way to break lines.
 class OptimizingLineFormatter : public LineFormatter {
 public:
+  /// If \p Cache is non-null, the line breaks of the lines are looked up
+  /// in it with \p CacheKey before searching for them. If \p Status is
+  /// non-null, the searches are counted in it.
   OptimizingLineFormatter(ContinuationIndenter *Indenter,
                           WhitespaceManager *Whitespaces,
                           const FormatStyle &Style,
-                          UnwrappedLineFormatter *BlockFormatter)
-      : LineFormatter(Indenter, Whitespaces, Style, BlockFormatter) {}
+                          UnwrappedLineFormatter *BlockFormatter,
+                          LineFormattingCache *Cache = nullptr,
+                          StringRef CacheKey = "",
+                          FormattingAttemptStatus *Status = nullptr)
+      : LineFormatter(Indenter, Whitespaces, Style, BlockFormatter),
+        Cache(Cache), CacheKey(CacheKey), Status(Status) {}
 
   /// Formats the line by finding the best line breaks with line lengths
   /// below the column limit.
@@ -850,6 +858,14 @@ public:
     if (State.Line->Type == LT_ObjCMethodDecl)
       State.Stack.back().BreakBeforeParameter = true;
 
+    if (Cache) {
+      if (llvm::Optional<LineFormattingCache::Entry> Cached =
+              Cache->lookup(CacheKey)) {
+        if (DryRun || applyLineBreaks(State, Cached->NewLines))
+          return Cached->Penalty;
+      }
+    }
+
     // Find best solution in solution space.
     return analyzeSolutionSpace(State, DryRun);
   }
@@ -887,6 +903,9 @@ private:
                               std::greater<QueueItem>>
       QueueType;
 
+  /// The states that have been expanded.
+  typedef std::set<LineState *, CompareLineStatePointers> SeenSet;
+
   /// Analyze the entire solution space starting from \p InitialState.
   ///
   /// This implements a variant of Dijkstra's algorithm on the graph that spans
@@ -896,7 +915,7 @@ private:
   ///
   /// If \p DryRun is \c false, directly applies the changes.
   unsigned analyzeSolutionSpace(LineState &InitialState, bool DryRun) {
-    std::set<LineState *, CompareLineStatePointers> Seen;
+    SeenSet Seen;
 
     // Increasing count of \c StateNode items we have created. This is used to
     // create a deterministic order independent of the container.
@@ -904,12 +923,12 @@ private:
     QueueType Queue;
 
     // Insert start element into queue.
-    StateNode *Node =
-        new (Allocator.Allocate()) StateNode(InitialState, false, nullptr);
+    StateNode *Node = createNode(InitialState, false, nullptr);
     Queue.push(QueueItem(OrderedPenalty(0, Count), Node));
     ++Count;
 
     unsigned Penalty = 0;
+    bool CutOff = false;
 
     // While not empty, take first element and follow edges.
     while (!Queue.empty()) {
@@ -924,18 +943,33 @@ private:
 
       // Cut off the analysis of certain solutions if the analysis gets too
       // complex. See description of IgnoreStackForComparison.
-      if (Count > 50000)
+      if (Count > 50000) {
         Node->State.IgnoreStackForComparison = true;
+        CutOff = true;
+      }
 
-      if (!Seen.insert(&Node->State).second)
+      if (!Seen.insert(&Node->State).second) {
         // State already examined with lower penalty.
+        ++NumPrunedStates;
         continue;
+      }
+      ++NumExpandedStates;
 
       FormatDecision LastFormat = Node->State.NextToken->Decision;
       if (LastFormat == FD_Unformatted || LastFormat == FD_Continue)
-        addNextStateToQueue(Penalty, Node, /*NewLine=*/false, &Count, &Queue);
+        addNextStateToQueue(Penalty, Node, /*NewLine=*/false, &Count, &Queue,
+                            Seen);
       if (LastFormat == FD_Unformatted || LastFormat == FD_Break)
-        addNextStateToQueue(Penalty, Node, /*NewLine=*/true, &Count, &Queue);
+        addNextStateToQueue(Penalty, Node, /*NewLine=*/true, &Count, &Queue,
+                            Seen);
+    }
+
+    if (Status) {
+      ++Status->NumSearchedLines;
+      Status->NumExpandedStates += NumExpandedStates;
+      Status->NumPrunedStates += NumPrunedStates;
+      if (CutOff)
+        ++Status->NumCutOffSearches;
     }
 
     if (Queue.empty()) {
@@ -945,35 +979,72 @@ private:
       return 0;
     }
 
+    if (Cache) {
+      LineFormattingCache::Entry Solved;
+      Solved.Penalty = Penalty;
+      for (StateNode *Node = Queue.top().second; Node->Previous;
+           Node = Node->Previous)
+        Solved.NewLines.push_back(Node->NewLine);
+      std::reverse(Solved.NewLines.begin(), Solved.NewLines.end());
+      Cache->insert(CacheKey, std::move(Solved));
+    }
+
     // Reconstruct the solution.
     if (!DryRun)
       reconstructPath(InitialState, Queue.top().second);
 
     LLVM_DEBUG(llvm::dbgs()
                << "Total number of analyzed states: " << Count << "\n");
+    LLVM_DEBUG(llvm::dbgs() << "Expanded states: " << NumExpandedStates
+                            << ", pruned states: " << NumPrunedStates << "\n");
     LLVM_DEBUG(llvm::dbgs() << "---\n");
 
     return Penalty;
   }
 
+  /// Returns a new node, reusing the node of the last state that was
+  /// dropped before it was queued, if any.
+  StateNode *createNode(const LineState &State, bool NewLine,
+                        StateNode *Previous) {
+    if (!SpareNode)
+      return new (Allocator.Allocate()) StateNode(State, NewLine, Previous);
+    StateNode *Node = SpareNode;
+    SpareNode = nullptr;
+    Node->State = State;
+    Node->NewLine = NewLine;
+    Node->Previous = Previous;
+    return Node;
+  }
+
   /// Add the following state to the analysis queue \c Queue.
   ///
   /// Assume the current state is \p PreviousNode and has been reached with a
   /// penalty of \p Penalty. Insert a line break if \p NewLine is \c true.
   void addNextStateToQueue(unsigned Penalty, StateNode *PreviousNode,
-                           bool NewLine, unsigned *Count, QueueType *Queue) {
+                           bool NewLine, unsigned *Count, QueueType *Queue,
+                           const SeenSet &Seen) {
     if (NewLine && !Indenter->canBreak(PreviousNode->State))
       return;
     if (!NewLine && Indenter->mustBreak(PreviousNode->State))
       return;
 
-    StateNode *Node = new (Allocator.Allocate())
-        StateNode(PreviousNode->State, NewLine, PreviousNode);
-    if (!formatChildren(Node->State, NewLine, /*DryRun=*/true, Penalty))
+    StateNode *Node = createNode(PreviousNode->State, NewLine, PreviousNode);
+    if (!formatChildren(Node->State, NewLine, /*DryRun=*/true, Penalty)) {
+      SpareNode = Node;
       return;
+    }
 
     Penalty += Indenter->addTokenToState(Node->State, NewLine, true);
 
+    // The expanded states were all reached with a penalty that is not higher
+    // than this one, so an equal state can't lead to a better solution. Drop
+    // it now instead of when it is taken out of the queue.
+    if (Seen.count(&Node->State)) {
+      ++NumPrunedStates;
+      SpareNode = Node;
+      return;
+    }
+
     Queue->push(QueueItem(OrderedPenalty(Penalty, *Count), Node));
     ++(*Count);
   }
@@ -1003,7 +1074,44 @@ private:
     }
   }
 
+  /// Applies the line breaks \p NewLines that were cached for a line with
+  /// the same key, and returns \c true. Returns \c false without changing
+  /// anything if they are not a valid solution for the line.
+  bool applyLineBreaks(LineState &State, ArrayRef<bool> NewLines) {
+    // The changes can't be undone, so check the line breaks on a copy of the
+    // state first.
+    LineState CheckState = State;
+    for (bool NewLine : NewLines) {
+      if (!CheckState.NextToken)
+        return false;
+      FormatDecision Decision = CheckState.NextToken->Decision;
+      if (NewLine ? Decision == FD_Continue || !Indenter->canBreak(CheckState)
+                  : Decision == FD_Break || Indenter->mustBreak(CheckState))
+        return false;
+      unsigned Penalty = 0;
+      if (!formatChildren(CheckState, NewLine, /*DryRun=*/true, Penalty))
+        return false;
+      Indenter->addTokenToState(CheckState, NewLine, /*DryRun=*/true);
+    }
+    if (CheckState.NextToken)
+      return false;
+
+    for (bool NewLine : NewLines) {
+      unsigned Penalty = 0;
+      formatChildren(State, NewLine, /*DryRun=*/false, Penalty);
+      Indenter->addTokenToState(State, NewLine, /*DryRun=*/false);
+    }
+    return true;
+  }
+
   llvm::SpecificBumpPtrAllocator<StateNode> Allocator;
+  /// A node that was allocated for a state that was then dropped.
+  StateNode *SpareNode = nullptr;
+  LineFormattingCache *Cache;
+  StringRef CacheKey;
+  FormattingAttemptStatus *Status;
+  unsigned NumExpandedStates = 0;
+  unsigned NumPrunedStates = 0;
 };
 
 } // anonymous namespace
@@ -1084,10 +1192,34 @@ unsigned UnwrappedLineFormatter::format(
         Penalty += NoLineBreakFormatter(Indenter, Whitespaces, Style, this)
                        .formatLine(TheLine, NextStartColumn + Indent,
                                    FirstLine ? FirstStartColumn : 0, DryRun);
-      else
-        Penalty += OptimizingLineFormatter(Indenter, Whitespaces, Style, this)
-                       .formatLine(TheLine, NextStartColumn + Indent,
-                                   FirstLine ? FirstStartColumn : 0, DryRun);
+      else {
+        unsigned FirstIndent = NextStartColumn + Indent;
+        unsigned LineStartColumn = FirstLine ? FirstStartColumn : 0;
+        std::string CacheKey;
+        if (Cache)
+          CacheKey = getLineCacheKey(TheLine, FirstIndent, LineStartColumn);
+        // The searches for the lines of nested blocks run within the search
+        // for the enclosing line, so only the outermost searches are timed.
+        bool TimeSearch = Status && SearchDepth == 0;
+        auto SearchStart = std::chrono::steady_clock::now();
+        ++SearchDepth;
+        Penalty += OptimizingLineFormatter(Indenter, Whitespaces, Style, this,
+                                           Cache, CacheKey, Status)
+                       .formatLine(TheLine, FirstIndent, LineStartColumn,
+                                   DryRun);
+        --SearchDepth;
+        if (TimeSearch) {
+          double Seconds = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - SearchStart)
+                               .count();
+          Status->SearchTime += Seconds;
+          if (Seconds > Status->SlowestSearchTime) {
+            Status->SlowestSearchTime = Seconds;
+            Status->SlowestSearchLine = SourceMgr.getSpellingLineNumber(
+                TheLine.First->Tok.getLocation());
+          }
+        }
+      }
       RangeMinLevel = std::min(RangeMinLevel, TheLine.Level);
     } else {
       // If no token in the current line is affected, we still need to format
@@ -1131,6 +1263,33 @@ unsigned UnwrappedLineFormatter::format(
   return Penalty;
 }
 
+std::string
+UnwrappedLineFormatter::getLineCacheKey(const AnnotatedLine &Line,
+                                        unsigned FirstIndent,
+                                        unsigned FirstStartColumn) const {
+  std::string Key;
+  llvm::raw_string_ostream OS(Key);
+  OS << CacheKeyPrefix << ' ' << FirstIndent << ' ' << FirstStartColumn << ' '
+     << Line.Type << ' ' << Line.Level << ' ' << Line.InPPDirective
+     << Line.MustBeDeclaration << ' ' << Line.First->OriginalColumn;
+  // The annotations of the tokens depend on the context the line was parsed
+  // in, not only on its text.
+  for (const FormatToken *Tok = Line.First; Tok; Tok = Tok->Next)
+    OS << ' ' << Tok->Type << ',' << Tok->Decision << ',' << Tok->BlockKind
+       << ',' << Tok->MustBreakBefore << Tok->CanBreakBefore << ','
+       << Tok->SplitPenalty;
+  // The text of the line, including the whitespace before it and the nested
+  // blocks in it.
+  const char *Begin =
+      SourceMgr.getCharacterData(Line.First->WhitespaceRange.getBegin());
+  const char *End = SourceMgr.getCharacterData(Line.Last->Tok.getLocation()) +
+                    Line.Last->TokenText.size();
+  OS << '\n';
+  if (Begin < End)
+    OS << StringRef(Begin, End - Begin);
+  return OS.str();
+}
+
 void UnwrappedLineFormatter::formatFirstToken(
     const AnnotatedLine &Line, const AnnotatedLine *PreviousLine,
     const SmallVectorImpl<AnnotatedLine *> &Lines, unsigned Indent,
@@ -32,9 +32,12 @@ public:
                          const FormatStyle &Style,
                          const AdditionalKeywords &Keywords,
                          const SourceManager &SourceMgr,
-                         FormattingAttemptStatus *Status)
+                         FormattingAttemptStatus *Status,
+                         LineFormattingCache *Cache = nullptr,
+                         StringRef CacheKeyPrefix = "")
       : Indenter(Indenter), Whitespaces(Whitespaces), Style(Style),
-        Keywords(Keywords), SourceMgr(SourceMgr), Status(Status) {}
+        Keywords(Keywords), SourceMgr(SourceMgr), Status(Status), Cache(Cache),
+        CacheKeyPrefix(CacheKeyPrefix) {}
 
   /// Format the current block and return the penalty.
   unsigned format(const SmallVectorImpl<AnnotatedLine *> &Lines,
@@ -55,6 +58,11 @@ private:
   unsigned getColumnLimit(bool InPPDirective,
                           const AnnotatedLine *NextLine) const;
 
+  /// Returns the key of \p Line in the \c LineFormattingCache. It consists
+  /// of everything the line breaks chosen for the line depend on.
+  std::string getLineCacheKey(const AnnotatedLine &Line, unsigned FirstIndent,
+                              unsigned FirstStartColumn) const;
+
   // Cache to store the penalty of formatting a vector of AnnotatedLines
   // starting from a specific additional offset. Improves performance if there
   // are many nested blocks.
@@ -68,6 +76,11 @@ private:
   const AdditionalKeywords &Keywords;
   const SourceManager &SourceMgr;
   FormattingAttemptStatus *Status;
+  LineFormattingCache *Cache;
+  /// Describes the style the lines are formatted with, see \c getLineCacheKey.
+  StringRef CacheKeyPrefix;
+  /// The number of searches for line breaks that are currently running.
+  unsigned SearchDepth = 0;
 };
 } // end namespace format
 } // end namespace clang
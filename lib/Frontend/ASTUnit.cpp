@@ -62,8 +62,10 @@
 #include "clang/Serialization/InMemoryModuleCache.h"
 #include "clang/Serialization/Module.h"
 #include "clang/Serialization/PCHContainerOperations.h"
+#include "llvm/ADT/APInt.h"
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/None.h"
 #include "llvm/ADT/Optional.h"
@@ -94,7 +96,9 @@
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <list>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <tuple>
 #include <utility>
@@ -1078,6 +1082,8 @@ bool ASTUnit::Parse(std::shared_ptr<PCHContainerOperations> PCHContainerOps,
   if (!Invocation)
     return true;
 
+  ParseCancelled = false;
+
   if (VFS && FileMgr)
     assert(VFS == &FileMgr->getVirtualFileSystem() &&
            "VFS passed to Parse and VFS in FileMgr are different");
@@ -1186,13 +1192,19 @@ bool ASTUnit::Parse(std::shared_ptr<PCHContainerOperations> PCHContainerOps,
   if (!Act->Execute())
     goto error;
 
+  // The token may have been cancelled too late to make a difference, but the
+  // translation unit can't be trusted to be complete anyway.
+  ParseCancelled = Clang->getPreprocessor().isCancellationRequested();
+
   transferASTDataFromCompilerInstance(*Clang);
 
   Act->EndSourceFile();
 
   FailedParseDiagnostics.clear();
 
-  return false;
+  // Keep the partial translation unit for the client, but report the parse
+  // as failed.
+  return ParseCancelled;
 
 error:
   // Remove the overridden buffer we used for the preamble.
@@ -1252,6 +1264,162 @@ makeStandaloneDiagnostic(const LangOptions &LangOpts,
   return OutDiag;
 }
 
+namespace {
+
+/// A precompiled preamble together with the state that an ASTUnit derives
+/// from building it, so that another ASTUnit can adopt it without rebuilding.
+struct SharedPreamble {
+  std::shared_ptr<const PrecompiledPreamble> Preamble;
+  std::vector<serialization::DeclID> TopLevelDeclsInPreamble;
+  unsigned TopLevelHashValue;
+  unsigned NumWarnings;
+  SmallVector<ASTUnit::StandaloneDiagnostic, 4> Diagnostics;
+};
+
+/// The process-wide cache of the preambles built by ASTUnits.
+///
+/// The entries are keyed by the main file and the options that affect the
+/// preamble; whether the preamble still matches the contents of the main
+/// file and of the files it includes is checked on every lookup. The cache
+/// only drops its own reference when an entry is evicted, the ASTUnits that
+/// use the preamble keep it alive.
+class SharedPreambleCache {
+public:
+  bool isEnabled() {
+    std::lock_guard<std::mutex> LockGuard(Lock);
+    return SizeLimit != 0;
+  }
+
+  void setSizeLimit(uint64_t Limit) {
+    std::lock_guard<std::mutex> LockGuard(Lock);
+    SizeLimit = Limit;
+    evict();
+  }
+
+  std::shared_ptr<const SharedPreamble>
+  lookup(StringRef Key, const CompilerInvocation &Invocation,
+         const llvm::MemoryBuffer *MainFileBuffer, PreambleBounds Bounds,
+         llvm::vfs::FileSystem *VFS) {
+    std::shared_ptr<const SharedPreamble> Result;
+    {
+      std::lock_guard<std::mutex> LockGuard(Lock);
+      auto It = find(Key);
+      if (It == Entries.end())
+        return nullptr;
+      Result = It->Value;
+    }
+
+    // Stat the files of the preamble without holding the lock.
+    if (!Result->Preamble->CanReuse(Invocation, MainFileBuffer, Bounds, VFS))
+      return nullptr;
+
+    std::lock_guard<std::mutex> LockGuard(Lock);
+    auto It = find(Key);
+    if (It != Entries.end() && It->Value == Result)
+      Entries.splice(Entries.begin(), Entries, It);
+    return Result;
+  }
+
+  void insert(std::string Key, std::shared_ptr<const SharedPreamble> Value) {
+    uint64_t ValueSize = Value->Preamble->getSize();
+    std::lock_guard<std::mutex> LockGuard(Lock);
+    if (SizeLimit == 0 || ValueSize > SizeLimit)
+      return;
+    auto It = find(Key);
+    if (It != Entries.end()) {
+      Size -= It->Size;
+      Entries.erase(It);
+    }
+    Entries.push_front(Entry{std::move(Key), std::move(Value), ValueSize});
+    Size += ValueSize;
+    evict();
+  }
+
+private:
+  struct Entry {
+    std::string Key;
+    std::shared_ptr<const SharedPreamble> Value;
+    uint64_t Size;
+  };
+
+  std::list<Entry>::iterator find(StringRef Key) {
+    return std::find_if(Entries.begin(), Entries.end(),
+                        [&](const Entry &E) { return E.Key == Key; });
+  }
+
+  /// Drop the least recently used entries until the cache fits its limit.
+  void evict() {
+    while (Size > SizeLimit) {
+      Size -= Entries.back().Size;
+      Entries.pop_back();
+    }
+  }
+
+  std::mutex Lock;
+  /// The entries, most recently used first.
+  std::list<Entry> Entries;
+  uint64_t Size = 0;
+  uint64_t SizeLimit = 0;
+};
+
+} // namespace
+
+static SharedPreambleCache &getSharedPreambleCache() {
+  static SharedPreambleCache Cache;
+  return Cache;
+}
+
+void ASTUnit::setSharedPreambleCacheSize(uint64_t Size) {
+  getSharedPreambleCache().setSizeLimit(Size);
+}
+
+/// Compute the key of the preamble of \p MainFilePath in the shared preamble
+/// cache.
+///
+/// The preamble records the main file it was built for, so it is never shared
+/// between different main files. The options are hashed conservatively: two
+/// ASTUnits with slightly different options simply don't share a preamble.
+static std::string getSharedPreambleKey(const CompilerInvocation &Invocation,
+                                        StringRef MainFilePath,
+                                        llvm::vfs::FileSystem &VFS,
+                                        SkipFunctionBodiesScope SkipBodies,
+                                        bool CaptureDiagnostics) {
+  using llvm::hash_combine;
+
+  llvm::hash_code Code = llvm::hash_value(Invocation.getModuleHash());
+  Code = hash_combine(Code, static_cast<unsigned>(SkipBodies),
+                      CaptureDiagnostics);
+  if (llvm::ErrorOr<std::string> CWD = VFS.getCurrentWorkingDirectory())
+    Code = hash_combine(Code, *CWD);
+  Code = hash_combine(Code, Invocation.getFileSystemOpts().WorkingDir);
+
+  const HeaderSearchOptions &HSOpts = Invocation.getHeaderSearchOpts();
+  for (const auto &E : HSOpts.UserEntries)
+    Code = hash_combine(Code, E.Path, static_cast<unsigned>(E.Group),
+                        E.IsFramework, E.IgnoreSysRoot);
+  for (const auto &P : HSOpts.SystemHeaderPrefixes)
+    Code = hash_combine(Code, P.Prefix, P.IsSystemHeader);
+
+  const PreprocessorOptions &PPOpts = Invocation.getPreprocessorOpts();
+  for (const auto &Include : PPOpts.Includes)
+    Code = hash_combine(Code, Include);
+  for (const auto &Include : PPOpts.MacroIncludes)
+    Code = hash_combine(Code, Include);
+  Code = hash_combine(Code, PPOpts.ImplicitPCHInclude);
+
+  // The diagnostics of the preamble are stored with it.
+  const DiagnosticOptions &DiagOpts = Invocation.getDiagnosticOpts();
+  Code = hash_combine(Code, DiagOpts.IgnoreWarnings);
+  for (const auto &Warning : DiagOpts.Warnings)
+    Code = hash_combine(Code, Warning);
+  for (const auto &Remark : DiagOpts.Remarks)
+    Code = hash_combine(Code, Remark);
+
+  return (MainFilePath + ":" +
+          llvm::APInt(64, Code).toString(36, /*Signed=*/false))
+      .str();
+}
+
 /// Attempt to build or re-use a precompiled preamble when (re-)parsing
 /// the source file.
 ///
@@ -1293,8 +1461,25 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
     return nullptr;
 
   if (Preamble) {
-    if (Preamble->CanReuse(PreambleInvocationIn, MainFileBuffer.get(), Bounds,
-                           VFS.get())) {
+    bool CanReuse = Preamble->CanReuse(PreambleInvocationIn,
+                                       MainFileBuffer.get(), Bounds, VFS.get());
+    // If lines were only added at the end of the preamble, e.g. a new
+    // #include, parse them as part of the main file on top of the current
+    // preamble, and only rebuild it once the end of the preamble stopped
+    // changing between reparses. Code completion never drops the preamble
+    // for that reason, since it can't rebuild it.
+    if (!CanReuse &&
+        (!AllowRebuild || Bounds.Size != DeferredPreambleSize) &&
+        Preamble->CanReuseAsPrefix(PreambleInvocationIn, MainFileBuffer.get(),
+                                   Bounds, VFS.get())) {
+      CanReuse = true;
+      if (AllowRebuild)
+        DeferredPreambleSize = Bounds.Size;
+    } else if (AllowRebuild) {
+      DeferredPreambleSize = 0;
+    }
+
+    if (CanReuse) {
       // Okay! We can re-use the precompiled preamble.
 
       // Set the state of the diagnostic object to mimic its state
@@ -1329,6 +1514,38 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
   if (!AllowRebuild)
     return nullptr;
 
+  // Adopt the preamble that another ASTUnit built for this file, if it is
+  // still valid.
+  SharedPreambleCache &Cache = getSharedPreambleCache();
+  std::string SharedKey;
+  if (Cache.isEnabled()) {
+    SharedKey =
+        getSharedPreambleKey(PreambleInvocationIn, MainFilePath, *VFS,
+                             SkipFunctionBodies, CaptureDiagnostics);
+    if (std::shared_ptr<const SharedPreamble> Shared =
+            Cache.lookup(SharedKey, PreambleInvocationIn, MainFileBuffer.get(),
+                         Bounds, VFS.get())) {
+      Preamble = Shared->Preamble;
+      PreambleRebuildCountdown = 1;
+
+      TopLevelDecls.clear();
+      TopLevelDeclsInPreamble = Shared->TopLevelDeclsInPreamble;
+      NumWarningsInPreamble = Shared->NumWarnings;
+      checkAndRemoveNonDriverDiags(StoredDiagnostics);
+      PreambleDiagnostics = Shared->Diagnostics;
+
+      getDiagnostics().Reset();
+      ProcessWarningOptions(getDiagnostics(),
+                            PreambleInvocationIn.getDiagnosticOpts());
+      getDiagnostics().setNumWarnings(NumWarningsInPreamble);
+
+      if (CurrentTopLevelHashValue != Shared->TopLevelHashValue)
+        CompletionCacheTopLevelHashValue = 0;
+      PreambleTopLevelHashValue = CurrentTopLevelHashValue;
+      return MainFileBuffer;
+    }
+  }
+
   ++PreambleCounter;
 
   SmallVector<StandaloneDiagnostic, 4> NewPreambleDiagsStandalone;
@@ -1357,7 +1574,7 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
         PreviousSkipFunctionBodies;
 
     if (NewPreamble) {
-      Preamble = std::move(*NewPreamble);
+      Preamble = std::make_shared<PrecompiledPreamble>(std::move(*NewPreamble));
       PreambleRebuildCountdown = 1;
     } else {
       switch (static_cast<BuildPreambleError>(NewPreamble.getError().value())) {
@@ -1388,6 +1605,16 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
   StoredDiagnostics = std::move(NewPreambleDiags);
   PreambleDiagnostics = std::move(NewPreambleDiagsStandalone);
 
+  if (!SharedKey.empty()) {
+    auto Shared = std::make_shared<SharedPreamble>();
+    Shared->Preamble = Preamble;
+    Shared->TopLevelDeclsInPreamble = TopLevelDeclsInPreamble;
+    Shared->TopLevelHashValue = PreambleTopLevelHashValue;
+    Shared->NumWarnings = NumWarningsInPreamble;
+    Shared->Diagnostics = PreambleDiagnostics;
+    Cache.insert(std::move(SharedKey), std::move(Shared));
+  }
+
   // If the hash of top-level entities differs from the hash of the top-level
   // entities the last time we rebuilt the preamble, clear out the completion
   // cache.
@@ -1849,6 +2076,58 @@ bool ASTUnit::Reparse(std::shared_ptr<PCHContainerOperations> PCHContainerOps,
   return Result;
 }
 
+std::unique_ptr<ASTUnit> ASTUnit::createUnparsedCopy() const {
+  if (!Invocation || !FileMgr)
+    return nullptr;
+
+  std::unique_ptr<ASTUnit> AST(new ASTUnit(false));
+  IntrusiveRefCntPtr<DiagnosticsEngine> Diags =
+      CompilerInstance::createDiagnostics(
+          new DiagnosticOptions(Diagnostics->getDiagnosticOptions()));
+  Diags->setFatalsAsError(Diagnostics->getFatalsAsError());
+  ConfigureDiags(Diags, *AST, CaptureDiagnostics);
+  AST->Diagnostics = Diags;
+  AST->Invocation = std::make_shared<CompilerInvocation>(*Invocation);
+  // The remapped file buffers are owned by this unit, the new one gets its
+  // own when it is reparsed.
+  AST->Invocation->getPreprocessorOpts().clearRemappedFiles();
+  AST->FileSystemOpts = FileSystemOpts;
+  AST->FileMgr =
+      new FileManager(FileSystemOpts, &FileMgr->getVirtualFileSystem());
+  AST->ModuleCache = new InMemoryModuleCache;
+  AST->OnlyLocalDecls = OnlyLocalDecls;
+  AST->CaptureDiagnostics = CaptureDiagnostics;
+  AST->TUKind = TUKind;
+  AST->ShouldCacheCodeCompletionResults = ShouldCacheCodeCompletionResults;
+  AST->IncludeBriefCommentsInCodeCompletion =
+      IncludeBriefCommentsInCodeCompletion;
+  AST->UserFilesAreVolatile = UserFilesAreVolatile;
+  AST->SkipFunctionBodies = SkipFunctionBodies;
+  if (WriterData)
+    AST->WriterData.reset(new ASTWriterData(*AST->ModuleCache));
+
+  // Keep the diagnostics from the driver, they are retained across parses.
+  AST->StoredDiagnostics = StoredDiagnostics;
+  checkAndRemoveNonDriverDiags(AST->StoredDiagnostics);
+  AST->NumStoredDiagnosticsFromDriver = NumStoredDiagnosticsFromDriver;
+
+  // The preamble is immutable, so it can be shared.
+  AST->Preamble = Preamble;
+  AST->PreambleRebuildCountdown = PreambleRebuildCountdown;
+  AST->DeferredPreambleSize = DeferredPreambleSize;
+  AST->PreambleDiagnostics = PreambleDiagnostics;
+  AST->PreambleSrcLocCache = PreambleSrcLocCache;
+  AST->NumWarningsInPreamble = NumWarningsInPreamble;
+  AST->TopLevelDeclsInPreamble = TopLevelDeclsInPreamble;
+  AST->PreambleTopLevelHashValue = PreambleTopLevelHashValue;
+  return AST;
+}
+
+void ASTUnit::setCancellationToken(std::shared_ptr<CancellationToken> Token) {
+  if (Invocation)
+    Invocation->getPreprocessorOpts().Cancellation = std::move(Token);
+}
+
 void ASTUnit::ResetForParse() {
   SavedMainFileBuffer.reset();
 
@@ -2261,7 +2540,7 @@ void ASTUnit::CodeComplete(
 }
 
 bool ASTUnit::Save(StringRef File) {
-  if (HadModuleLoaderFatalFailure)
+  if (HadModuleLoaderFatalFailure || ParseCancelled)
     return true;
 
   // Write to a temporary file and later rename it to the actual file, to avoid
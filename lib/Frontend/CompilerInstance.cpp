@@ -13,6 +13,7 @@
 #include "clang/Basic/CharInfo.h"
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/FileManager.h"
+#include "clang/Basic/FileSystemStatCache.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Basic/Stack.h"
 #include "clang/Basic/TargetInfo.h"
@@ -27,6 +28,7 @@
 #include "clang/Frontend/TextDiagnosticPrinter.h"
 #include "clang/Frontend/Utils.h"
 #include "clang/Frontend/VerifyDiagnosticConsumer.h"
+#include "clang/Lex/DependencyDirectivesSourceMinimizer.h"
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Lex/PreprocessorOptions.h"
@@ -35,10 +37,13 @@
 #include "clang/Serialization/ASTReader.h"
 #include "clang/Serialization/GlobalModuleIndex.h"
 #include "clang/Serialization/InMemoryModuleCache.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Support/BuryPointer.h"
 #include "llvm/Support/CrashRecoveryContext.h"
 #include "llvm/Support/Errc.h"
+#include "llvm/Support/Errno.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Host.h"
 #include "llvm/Support/LockFileManager.h"
@@ -46,16 +51,38 @@
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
+#include <chrono>
 #include <sys/stat.h>
 #include <system_error>
+#include <thread>
 #include <time.h>
 #include <utility>
 
+#ifdef LLVM_ON_UNIX
+#include <fcntl.h>
+#include <sys/file.h> // For flock().
+#include <unistd.h>
+#endif
+
 using namespace clang;
 
+#define DEBUG_TYPE "modules"
+
+STATISTIC(NumModuleLockWaits,
+          "Number of waits for modules that another compiler was building");
+STATISTIC(NumModuleLockWaitsPolled,
+          "Number of waits for modules that fell back to polling the lock");
+STATISTIC(ModuleLockWaitMilliseconds,
+          "Time spent waiting for modules that another compiler was building "
+          "(ms)");
+STATISTIC(NumModulesPrebuilt,
+          "Number of modules imported by the main file that were built in "
+          "the background");
+
 CompilerInstance::CompilerInstance(
     std::shared_ptr<PCHContainerOperations> PCHContainerOps,
     InMemoryModuleCache *SharedModuleCache)
@@ -67,6 +94,7 @@ CompilerInstance::CompilerInstance(
 
 CompilerInstance::~CompilerInstance() {
   assert(OutputFiles.empty() && "Still output files in flight?");
+  waitForModuleBuilds();
 }
 
 void CompilerInstance::setInvocation(
@@ -294,6 +322,28 @@ CompilerInstance::createDiagnostics(DiagnosticOptions *Opts,
 
 // File Manager
 
+/// Create the stat cache requested by -fstat-cache-file, which covers the
+/// directories that are not expected to change during a build: the sysroot,
+/// the resource directory and the system header search paths.
+static std::unique_ptr<FileSystemStatCache>
+createPersistentStatCache(const CompilerInvocation &Invocation) {
+  const HeaderSearchOptions &HSOpts = Invocation.getHeaderSearchOpts();
+  std::vector<std::string> Prefixes;
+  if (!HSOpts.Sysroot.empty() && HSOpts.Sysroot != "/")
+    Prefixes.push_back(HSOpts.Sysroot);
+  if (!HSOpts.ResourceDir.empty())
+    Prefixes.push_back(HSOpts.ResourceDir);
+  for (const auto &Entry : HSOpts.UserEntries) {
+    if (Entry.Group == frontend::Quoted || Entry.Group == frontend::Angled ||
+        Entry.Group == frontend::IndexHeaderMap)
+      continue;
+    Prefixes.push_back(Entry.Path);
+  }
+
+  return llvm::make_unique<PersistentStatCache>(
+      Invocation.getFileSystemOpts().StatCacheFile, Prefixes);
+}
+
 FileManager *CompilerInstance::createFileManager(
     IntrusiveRefCntPtr<llvm::vfs::FileSystem> VFS) {
   if (!VFS)
@@ -301,7 +351,13 @@ FileManager *CompilerInstance::createFileManager(
                   : createVFSFromCompilerInvocation(getInvocation(),
                                                     getDiagnostics());
   assert(VFS && "FileManager has no VFS?");
+  // The stat cache is keyed by the paths on the real file system, so it is
+  // not used when overlays may map them to other files.
+  bool UseStatCache = !getFileSystemOpts().StatCacheFile.empty() &&
+                      VFS == llvm::vfs::getRealFileSystem();
   FileMgr = new FileManager(getFileSystemOpts(), std::move(VFS));
+  if (UseStatCache)
+    FileMgr->setStatCache(createPersistentStatCache(getInvocation()));
   return FileMgr.get();
 }
 
@@ -946,6 +1002,9 @@ bool CompilerInstance::ExecuteAction(FrontendAction &Act) {
     }
   }
 
+  // Don't leave modules half-built when the process exits.
+  waitForModuleBuilds();
+
   // Notify the diagnostic client that all files were processed.
   getDiagnostics().getClient()->finish();
 
@@ -1221,6 +1280,113 @@ static bool compileModuleImpl(CompilerInstance &ImportingInstance,
   return Result;
 }
 
+namespace {
+
+/// While a module is built, the builder holds an exclusive flock() on the
+/// file behind the lock file of the module. Compilers that wait for the
+/// module try to take a shared flock() of the same file, so they wake up as
+/// soon as the builder is done, or dies, instead of waiting for the lock
+/// file to go away with an exponential backoff.
+class ModuleBuildNotifier {
+public:
+  ~ModuleBuildNotifier() { notify(); }
+
+  /// Makes the compilers that wait on the lock file \p LockFileName, which
+  /// must be owned by this compiler, wait until \c notify is called.
+  void lock(StringRef LockFileName) {
+#ifdef LLVM_ON_UNIX
+    FD = ::open(LockFileName.str().c_str(), O_RDONLY | O_CLOEXEC);
+    if (FD >= 0 && ::flock(FD, LOCK_EX | LOCK_NB) != 0) {
+      ::close(FD);
+      FD = -1;
+    }
+#endif
+  }
+
+  /// Lets the waiting compilers go.
+  void notify() {
+#ifdef LLVM_ON_UNIX
+    if (FD >= 0)
+      ::close(FD);
+    FD = -1;
+#endif
+  }
+
+private:
+#ifdef LLVM_ON_UNIX
+  int FD = -1;
+#endif
+};
+
+} // end anonymous namespace
+
+#ifdef LLVM_ON_UNIX
+/// Waits for a shared flock() of \p FD for at most \p Timeout. Returns false
+/// if the lock couldn't be taken in time.
+///
+/// A blocking flock() can't time out, and a builder that hangs would block
+/// us forever, so retry a non-blocking one after short, bounded intervals.
+static bool waitForSharedLock(int FD, std::chrono::milliseconds Timeout) {
+  using namespace std::chrono;
+  const milliseconds MaxInterval(20);
+  auto Deadline = steady_clock::now() + Timeout;
+  milliseconds Interval(1);
+  while (true) {
+    if (llvm::sys::RetryAfterSignal(-1, ::flock, FD, LOCK_SH | LOCK_NB) == 0)
+      return true;
+    if (errno != EWOULDBLOCK)
+      return false;
+    auto Now = steady_clock::now();
+    if (Now >= Deadline)
+      return false;
+    std::this_thread::sleep_for(
+        std::min<steady_clock::duration>(Interval, Deadline - Now));
+    Interval = std::min(Interval * 2, MaxInterval);
+  }
+}
+#endif
+
+/// Waits for the compiler that owns the lock \p Locked to build the module
+/// file \p ModuleFileName.
+static llvm::LockFileManager::WaitForUnlockResult
+waitForModuleBuild(llvm::LockFileManager &Locked, StringRef ModuleFileName) {
+  ++NumModuleLockWaits;
+  auto Start = std::chrono::steady_clock::now();
+  auto RecordWait = [&] {
+    ModuleLockWaitMilliseconds +=
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - Start)
+            .count();
+  };
+
+#ifdef LLVM_ON_UNIX
+  std::string LockFileName = (ModuleFileName + ".lock").str();
+  int FD = ::open(LockFileName.c_str(), O_RDONLY | O_CLOEXEC);
+  if (FD >= 0) {
+    // Give up on the notification as late as LockFileManager would give up
+    // on the builder.
+    waitForSharedLock(FD, std::chrono::seconds(40));
+    ::close(FD);
+  }
+  // A builder removes the lock file before it lets the waiters go. If the
+  // lock file is still there, the builder either died, hangs, doesn't notify
+  // its waiters, or hasn't taken its flock() yet.
+  if (!llvm::sys::fs::exists(LockFileName)) {
+    RecordWait();
+    // Like LockFileManager, assume that the builder failed if there is no
+    // module file.
+    return llvm::sys::fs::exists(ModuleFileName)
+               ? llvm::LockFileManager::Res_Success
+               : llvm::LockFileManager::Res_OwnerDied;
+  }
+#endif
+
+  ++NumModuleLockWaitsPolled;
+  llvm::LockFileManager::WaitForUnlockResult Result = Locked.waitForUnlock();
+  RecordWait();
+  return Result;
+}
+
 static bool compileAndLoadModule(CompilerInstance &ImportingInstance,
                                  SourceLocation ImportLoc,
                                  SourceLocation ModuleNameLoc, Module *Module,
@@ -1239,30 +1405,42 @@ static bool compileAndLoadModule(CompilerInstance &ImportingInstance,
 
   while (1) {
     unsigned ModuleLoadCapabilities = ASTReader::ARR_Missing;
-    llvm::LockFileManager Locked(ModuleFileName);
-    switch (Locked) {
+    // The lock is released as soon as the module is built, before it's read.
+    llvm::Optional<llvm::LockFileManager> Locked;
+    Locked.emplace(ModuleFileName);
+    llvm::LockFileManager::LockFileState LockState = *Locked;
+    switch (LockState) {
     case llvm::LockFileManager::LFS_Error:
       // ModuleCache takes care of correctness and locks are only necessary for
       // performance. Fallback to building the module in case of any lock
       // related errors.
       Diags.Report(ModuleNameLoc, diag::remark_module_lock_failure)
-          << Module->Name << Locked.getErrorMessage();
+          << Module->Name << Locked->getErrorMessage();
       // Clear out any potential leftover.
-      Locked.unsafeRemoveLockFile();
+      Locked->unsafeRemoveLockFile();
       LLVM_FALLTHROUGH;
-    case llvm::LockFileManager::LFS_Owned:
+    case llvm::LockFileManager::LFS_Owned: {
       // We're responsible for building the module ourselves.
+      ModuleBuildNotifier Notifier;
+      if (LockState == llvm::LockFileManager::LFS_Owned)
+        Notifier.lock((ModuleFileName + ".lock").str());
       if (!compileModuleImpl(ImportingInstance, ModuleNameLoc, Module,
                              ModuleFileName)) {
         diagnoseBuildFailure();
         return false;
       }
+      // The module file is in place, so the waiting compilers can load it
+      // while we do. Releasing the lock removes the lock file, which tells
+      // the waiters that the build is done once they're woken up.
+      Locked.reset();
+      Notifier.notify();
       break;
+    }
 
     case llvm::LockFileManager::LFS_Shared:
       // Someone else is responsible for building the module. Wait for them to
       // finish.
-      switch (Locked.waitForUnlock()) {
+      switch (waitForModuleBuild(*Locked, ModuleFileName)) {
       case llvm::LockFileManager::Res_Success:
         ModuleLoadCapabilities |= ASTReader::ARR_OutOfDate;
         break;
@@ -1275,7 +1453,7 @@ static bool compileAndLoadModule(CompilerInstance &ImportingInstance,
         Diags.Report(ModuleNameLoc, diag::remark_module_lock_timeout)
             << Module->Name;
         // Clear the lock file so that future invocations can make progress.
-        Locked.unsafeRemoveLockFile();
+        Locked->unsafeRemoveLockFile();
         continue;
       }
       break;
@@ -1288,7 +1466,7 @@ static bool compileAndLoadModule(CompilerInstance &ImportingInstance,
             ModuleLoadCapabilities);
 
     if (ReadResult == ASTReader::OutOfDate &&
-        Locked == llvm::LockFileManager::LFS_Shared) {
+        LockState == llvm::LockFileManager::LFS_Shared) {
       // The module may be out of date in the presence of file system races,
       // or if one of its imports depends on header search paths that are not
       // consistent with this ImportingInstance.  Try again...
@@ -1591,6 +1769,181 @@ bool CompilerInstance::loadModuleFile(StringRef FileName) {
   }
 }
 
+/// Collects the top-level modules that the main file of \p CI imports,
+/// found by scanning its minimized directives. An include of a header that
+/// belongs to a module counts as an import of that module. Directives whose
+/// argument is a macro are skipped.
+static void collectMainFileImports(CompilerInstance &CI,
+                                   llvm::SetVector<Module *> &Imports) {
+  namespace minimize = minimize_source_to_dependency_directives;
+  SourceManager &SourceMgr = CI.getSourceManager();
+  FileID MainFileID = SourceMgr.getMainFileID();
+  const FileEntry *MainFile = SourceMgr.getFileEntryForID(MainFileID);
+  if (!MainFile)
+    return;
+
+  SmallString<1024> Minimized;
+  SmallVector<minimize::Token, 32> Tokens;
+  if (minimizeSourceToDependencyDirectives(SourceMgr.getBufferData(MainFileID),
+                                           Minimized, Tokens))
+    return;
+
+  HeaderSearch &HS = CI.getPreprocessor().getHeaderSearchInfo();
+  std::pair<const FileEntry *, const DirectoryEntry *> Includer(
+      MainFile, MainFile->getDir());
+  for (const minimize::Token &Tok : Tokens) {
+    StringRef Directive =
+        StringRef(Minimized).substr(Tok.Offset).split('\n').first;
+    Module *M = nullptr;
+    switch (Tok.K) {
+    case minimize::decl_at_import:
+    case minimize::pp_pragma_import: {
+      // '@import A.B;' or '#pragma clang module import A.B'.
+      StringRef Path =
+          Directive.substr(Directive.find("import") + strlen("import")).ltrim();
+      StringRef Name = Path.take_until(
+          [](char C) { return C == '.' || C == ';' || isWhitespace(C); });
+      if (!Name.empty())
+        M = HS.lookupModule(Name);
+      break;
+    }
+    case minimize::pp_include:
+    case minimize::pp_import: {
+      StringRef Header = Directive.split(' ').second;
+      bool IsAngled = Header.startswith("<") && Header.endswith(">");
+      if (Header.size() < 2 ||
+          (!IsAngled && !(Header.startswith("\"") && Header.endswith("\""))))
+        break;
+      const DirectoryLookup *CurDir = nullptr;
+      ModuleMap::KnownHeader Suggested;
+      if (HS.LookupFile(Header.drop_front().drop_back(), SourceLocation(),
+                        IsAngled, /*FromDir=*/nullptr, CurDir, Includer,
+                        /*SearchPath=*/nullptr, /*RelativePath=*/nullptr,
+                        /*RequestingModule=*/nullptr, &Suggested,
+                        /*IsMapped=*/nullptr, /*IsFrameworkFound=*/nullptr) &&
+          Suggested && !(Suggested.getRole() & ModuleMap::TextualHeader))
+        M = Suggested.getModule();
+      break;
+    }
+    default:
+      break;
+    }
+    if (M)
+      Imports.insert(M->getTopLevelModule());
+  }
+}
+
+void CompilerInstance::prebuildMainFileImports(StringRef Building) {
+  if (PrebuildAttempted)
+    return;
+  PrebuildAttempted = true;
+
+  // The background builds can't report to this instance, so they are only
+  // started when nothing here needs to observe them: remapped files, module
+  // dependency collection and time traces are all tied to this instance.
+  const PreprocessorOptions &PPOpts = getPreprocessorOpts();
+  unsigned NumThreads = getHeaderSearchOpts().ModulesBuildThreads;
+  if (NumThreads < 2 || getFrontendOpts().BuildingImplicitModule ||
+      !PPOpts.RemappedFiles.empty() || !PPOpts.RemappedFileBuffers.empty() ||
+      ModuleDepCollector || llvm::timeTraceProfilerEnabled())
+    return;
+
+  llvm::SetVector<Module *> Imports;
+  collectMainFileImports(*this, Imports);
+
+  HeaderSearch &HS = getPreprocessor().getHeaderSearchInfo();
+  std::vector<std::pair<std::string, std::string>> Missing;
+  for (Module *M : Imports) {
+    if (M->Name == Building || M->Name == getLangOpts().CurrentModule ||
+        !M->isAvailable() || !HS.getPrebuiltModuleFileName(M->Name).empty())
+      continue;
+    std::string ModuleFileName = HS.getCachedModuleFileName(M);
+    if (ModuleFileName.empty() || llvm::sys::fs::exists(ModuleFileName))
+      continue;
+    Missing.emplace_back(M->Name, std::move(ModuleFileName));
+  }
+  if (Missing.empty())
+    return;
+
+  // The module that is being imported is built on this thread, as before.
+  NumModulesPrebuilt += Missing.size();
+  ModuleBuildPool = llvm::make_unique<llvm::ThreadPool>(
+      std::min<size_t>(NumThreads - 1, Missing.size()));
+  InputKind IK(getLanguageFromOptions(getLangOpts()));
+  std::shared_ptr<PCHContainerOperations> PCHContainerOps =
+      getPCHContainerOperations();
+  IntrusiveRefCntPtr<llvm::vfs::FileSystem> VFS =
+      &getFileManager().getVirtualFileSystem();
+  for (const auto &ModuleAndFile : Missing) {
+    // Each module is built by importing it from a source file of its own,
+    // in an instance that only shares the module cache directory with this
+    // one. The module file locks keep the builds of a module that is
+    // imported from several places from running twice.
+    auto Invocation = std::make_shared<CompilerInvocation>(getInvocation());
+    Invocation->getPreprocessorOpts().resetNonModularOptions();
+    Invocation->getHeaderSearchOpts().ModulesBuildThreads = 0;
+    Invocation->getDependencyOutputOpts() = DependencyOutputOptions();
+    DiagnosticOptions &DiagOpts = Invocation->getDiagnosticOpts();
+    DiagOpts.VerifyDiagnostics = false;
+    DiagOpts.DiagnosticLogFile.clear();
+    DiagOpts.DiagnosticSerializationFile.clear();
+    FrontendOptions &FEOpts = Invocation->getFrontendOpts();
+    FEOpts.CodeCompletionAt = ParsedSourceLocation();
+    FEOpts.GenerateGlobalModuleIndex = false;
+    FEOpts.ShowStats = false;
+    FEOpts.ShowTimers = false;
+    FEOpts.StatsFile.clear();
+
+    std::string Source =
+        "#pragma clang module import " + ModuleAndFile.first + "\n";
+    std::string ModuleFileName = ModuleAndFile.second;
+    ModuleBuildPool->async([=]() {
+      std::unique_ptr<llvm::MemoryBuffer> Buffer =
+          llvm::MemoryBuffer::getMemBuffer(Source, "<module-prebuild>");
+      Invocation->getFrontendOpts().Inputs = {
+          FrontendInputFile(Buffer.get(), IK)};
+
+      CompilerInstance Builder(PCHContainerOps);
+      Builder.setInvocation(Invocation);
+      Builder.createDiagnostics(new IgnoringDiagConsumer,
+                                /*ShouldOwnClient=*/true);
+      Builder.createFileManager(VFS);
+      SyntaxOnlyAction Action;
+      // A failed build is simply redone, with diagnostics, by the importer.
+      if (!Builder.ExecuteAction(Action))
+        return;
+      if (llvm::MemoryBuffer *Built =
+              Builder.getModuleCache().lookupPCM(ModuleFileName)) {
+        std::lock_guard<std::mutex> Lock(PrebuiltModulesLock);
+        PrebuiltModules.emplace_back(
+            ModuleFileName, llvm::MemoryBuffer::getMemBufferCopy(
+                                Built->getBuffer(), ModuleFileName));
+      }
+    });
+  }
+
+  // The global module index is out of date once the modules are built.
+  if (getFrontendOpts().GenerateGlobalModuleIndex)
+    setBuildGlobalModuleIndex(true);
+}
+
+void CompilerInstance::adoptPrebuiltModules() {
+  std::lock_guard<std::mutex> Lock(PrebuiltModulesLock);
+  for (auto &FileAndBuffer : PrebuiltModules) {
+    // Keep what this instance already read or built itself.
+    if (ModuleCache->getPCMState(FileAndBuffer.first) ==
+        InMemoryModuleCache::Unknown)
+      ModuleCache->addBuiltPCM(FileAndBuffer.first,
+                               std::move(FileAndBuffer.second));
+  }
+  PrebuiltModules.clear();
+}
+
+void CompilerInstance::waitForModuleBuilds() {
+  if (ModuleBuildPool)
+    ModuleBuildPool->wait();
+}
+
 ModuleLoadResult
 CompilerInstance::loadModule(SourceLocation ImportLoc,
                              ModuleIdPath Path,
@@ -1700,6 +2053,9 @@ CompilerInstance::loadModule(SourceLocation ImportLoc,
     llvm::TimeRegion TimeLoading(FrontendTimerGroup ? &Timer : nullptr);
     llvm::TimeTraceScope TimeScope("Module Load", ModuleName);
 
+    if (Source == ModuleCache && ModuleBuildPool)
+      adoptPrebuiltModules();
+
     // Try to load the module file. If we are not trying to load from the
     // module cache, we don't know how to rebuild modules.
     unsigned ARRFlags = Source == ModuleCache ?
@@ -1777,6 +2133,10 @@ CompilerInstance::loadModule(SourceLocation ImportLoc,
         return ModuleLoadResult();
       }
 
+      // Start building the other missing modules that the main file imports
+      // while this one is built.
+      prebuildMainFileImports(ModuleName);
+
       // Try to compile and then load the module.
       if (!compileAndLoadModule(*this, ImportLoc, ModuleNameLoc, Module,
                                 ModuleFileName)) {
@@ -465,6 +465,13 @@ static void parseAnalyzerConfigs(AnalyzerOptions &AnOpts,
       !llvm::sys::fs::is_directory(AnOpts.ModelPath))
     Diags->Report(diag::err_analyzer_config_invalid_input) << "model-path"
                                                            << "a filename";
+
+  if (AnOpts.ShardCount == 0)
+    Diags->Report(diag::err_analyzer_config_invalid_input) << "shard-count"
+                                                           << "a positive";
+  else if (AnOpts.ShardIndex >= AnOpts.ShardCount)
+    Diags->Report(diag::err_analyzer_config_invalid_input)
+        << "shard-index" << "a smaller than 'shard-count'";
 }
 
 static bool ParseMigratorArgs(MigratorOptions &Opts, ArgList &Args) {
@@ -1568,6 +1575,7 @@ bool clang::ParseDiagnosticArgs(DiagnosticOptions &Opts, ArgList &Args,
 
 static void ParseFileSystemArgs(FileSystemOptions &Opts, ArgList &Args) {
   Opts.WorkingDir = Args.getLastArgValue(OPT_working_directory);
+  Opts.StatCacheFile = Args.getLastArgValue(OPT_fstat_cache_file_EQ);
 }
 
 /// Parse the argument to the -ftest-module-file-extension
@@ -1671,6 +1679,10 @@ static InputKind ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
       Opts.ProgramAction = frontend::VerifyPCH; break;
     case OPT_print_preamble:
       Opts.ProgramAction = frontend::PrintPreamble; break;
+    case OPT_print_dependency_directives_minimized_source:
+      Opts.ProgramAction =
+          frontend::PrintDependencyDirectivesSourceMinimizerOutput;
+      break;
     case OPT_E:
       Opts.ProgramAction = frontend::PrintPreprocessedInput; break;
     case OPT_templight_dump:
@@ -1967,8 +1979,14 @@ static void ParseHeaderSearchArgs(HeaderSearchOptions &Opts, ArgList &Args,
       getLastArgIntValue(Args, OPT_fmodules_prune_interval, 7 * 24 * 60 * 60);
   Opts.ModuleCachePruneAfter =
       getLastArgIntValue(Args, OPT_fmodules_prune_after, 31 * 24 * 60 * 60);
+  Opts.ModulesBuildThreads =
+      getLastArgIntValue(Args, OPT_fmodules_build_threads, 0);
+  Opts.ModulesValidationThreads =
+      getLastArgIntValue(Args, OPT_fmodules_validation_threads, 0);
   Opts.ModulesValidateOncePerBuildSession =
       Args.hasArg(OPT_fmodules_validate_once_per_build_session);
+  Opts.ModulesValidateSignatureOncePerBuildSession =
+      Args.hasArg(OPT_fmodules_validate_signature_once_per_build_session);
   Opts.BuildSessionTimestamp =
       getLastArgUInt64Value(Args, OPT_fbuild_session_timestamp, 0);
   Opts.ModulesValidateSystemHeaders =
@@ -2682,6 +2700,11 @@ static void ParseLangArgs(LangOptions &Opts, ArgList &Args, InputKind IK,
       getLastArgIntValue(Args, OPT_fconstexpr_depth, 512, Diags);
   Opts.ConstexprStepLimit =
       getLastArgIntValue(Args, OPT_fconstexpr_steps, 1048576, Diags);
+  Opts.ConstexprCallCacheSize =
+      getLastArgIntValue(Args, OPT_fconstexpr_cache_size, 65536, Diags);
+  Opts.ConstexprBytecodeVerify = Args.hasArg(OPT_fconstexpr_bytecode_verify);
+  Opts.ConstexprBytecode =
+      Opts.ConstexprBytecodeVerify || Args.hasArg(OPT_fconstexpr_bytecode);
   Opts.BracketDepth = getLastArgIntValue(Args, OPT_fbracket_depth, 256, Diags);
   Opts.DelayedTemplateParsing = Args.hasArg(OPT_fdelayed_template_parsing);
   Opts.NumLargeByValueCopy =
@@ -3067,6 +3090,7 @@ static void ParseLangArgs(LangOptions &Opts, ArgList &Args, InputKind IK,
 
   Opts.CompleteMemberPointers = Args.hasArg(OPT_fcomplete_member_pointers);
   Opts.BuildingPCHWithObjectFile = Args.hasArg(OPT_building_pch_with_obj);
+  Opts.PCHInstantiateTemplates = Args.hasArg(OPT_fpch_instantiate_templates);
 }
 
 static bool isStrictlyPreprocessorAction(frontend::ActionKind Action) {
@@ -3103,6 +3127,7 @@ static bool isStrictlyPreprocessorAction(frontend::ActionKind Action) {
   case frontend::DumpTokens:
   case frontend::InitOnly:
   case frontend::PrintPreamble:
+  case frontend::PrintDependencyDirectivesSourceMinimizerOutput:
   case frontend::PrintPreprocessedInput:
   case frontend::RewriteMacros:
   case frontend::RunPreprocessorOnly:
@@ -3127,6 +3152,9 @@ static void ParsePreprocessorArgs(PreprocessorOptions &Opts, ArgList &Args,
   Opts.DumpDeserializedPCHDecls = Args.hasArg(OPT_dump_deserialized_pch_decls);
   for (const auto *A : Args.filtered(OPT_error_on_deserialized_pch_decl))
     Opts.DeserializedPCHDeclsToErrorOn.insert(A->getValue());
+  Opts.DeserializationProfileFile =
+      Args.getLastArgValue(OPT_deserialization_profile);
+  Opts.PCHLayoutProfile = Args.getLastArgValue(OPT_pch_layout_profile);
 
   if (const Arg *A = Args.getLastArg(OPT_preamble_bytes_EQ)) {
     StringRef Value(A->getValue());
@@ -24,6 +24,7 @@
 #include "clang/Parse/ParseAST.h"
 #include "clang/Serialization/ASTDeserializationListener.h"
 #include "clang/Serialization/ASTReader.h"
+#include "clang/Serialization/DeserializationProfile.h"
 #include "clang/Serialization/GlobalModuleIndex.h"
 #include "llvm/Support/BuryPointer.h"
 #include "llvm/Support/ErrorHandling.h"
@@ -126,6 +127,36 @@ public:
   }
 };
 
+/// Records the deserialized declarations and identifiers in a
+/// DeserializationProfile.
+class DeserializationProfileRecorder
+    : public DelegatingDeserializationListener {
+  std::shared_ptr<DeserializationProfile> Profile;
+
+public:
+  DeserializationProfileRecorder(
+      std::shared_ptr<DeserializationProfile> Profile,
+      ASTDeserializationListener *Previous, bool DeletePrevious)
+      : DelegatingDeserializationListener(Previous, DeletePrevious),
+        Profile(std::move(Profile)) {}
+
+  void ReaderInitialized(ASTReader *Reader) override {
+    Profile->setReader(Reader);
+    DelegatingDeserializationListener::ReaderInitialized(Reader);
+  }
+
+  void IdentifierRead(serialization::IdentID ID,
+                      IdentifierInfo *II) override {
+    Profile->addIdentifier(II);
+    DelegatingDeserializationListener::IdentifierRead(ID, II);
+  }
+
+  void DeclRead(serialization::DeclID ID, const Decl *D) override {
+    Profile->addDecl(D);
+    DelegatingDeserializationListener::DeclRead(ID, D);
+  }
+};
+
 } // end anonymous namespace
 
 FrontendAction::FrontendAction() : Instance(nullptr) {}
@@ -855,6 +886,12 @@ bool FrontendAction::BeginSourceFile(CompilerInstance &CI,
             DeserialListener, DeleteDeserialListener);
         DeleteDeserialListener = true;
       }
+      if (!CI.getPreprocessorOpts().DeserializationProfileFile.empty()) {
+        DeserialProfile = std::make_shared<DeserializationProfile>();
+        DeserialListener = new DeserializationProfileRecorder(
+            DeserialProfile, DeserialListener, DeleteDeserialListener);
+        DeleteDeserialListener = true;
+      }
       if (!CI.getPreprocessorOpts().ImplicitPCHInclude.empty()) {
         CI.createPCHExternalASTSource(
             CI.getPreprocessorOpts().ImplicitPCHInclude,
@@ -919,6 +956,7 @@ failure:
     CI.getDiagnosticClient().EndSourceFile();
   CI.clearOutputFiles(/*EraseFiles=*/true);
   CI.getLangOpts().setCompilingModule(LangOptions::CMK_None);
+  DeserialProfile.reset();
   setCurrentInput(FrontendInputFile());
   setCompilerInstance(nullptr);
   return false;
@@ -960,6 +998,19 @@ void FrontendAction::EndSourceFile() {
   // Finalize the action.
   EndSourceFileAction();
 
+  // Write the deserialization profile while the declarations still exist.
+  if (DeserialProfile) {
+    StringRef ProfileFile = CI.getPreprocessorOpts().DeserializationProfileFile;
+    std::error_code EC;
+    llvm::raw_fd_ostream OS(ProfileFile, EC, llvm::sys::fs::F_Text);
+    if (EC)
+      CI.getDiagnostics().Report(diag::err_fe_unable_to_open_output)
+          << ProfileFile << EC.message();
+    else
+      DeserialProfile->write(OS);
+    DeserialProfile.reset();
+  }
+
   // Sema references the ast consumer, so reset sema first.
   //
   // FIXME: There is more per-file stuff we could just drop here?
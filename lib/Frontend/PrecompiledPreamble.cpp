@@ -275,6 +275,8 @@ llvm::ErrorOr<PrecompiledPreamble> PrecompiledPreamble::Build(
   PreprocessorOpts.PrecompiledPreambleBytes.second = false;
   // Inform preprocessor to record conditional stack when building the preamble.
   PreprocessorOpts.GeneratePreamble = true;
+  // A preamble is reused by later parses, so it must never be cut short.
+  PreprocessorOpts.Cancellation.reset();
 
   // Create the compiler instance to use for building the precompiled preamble.
   std::unique_ptr<CompilerInstance> Clang(
@@ -504,6 +506,17 @@ bool PrecompiledPreamble::CanReuse(const CompilerInvocation &Invocation,
   return true;
 }
 
+bool PrecompiledPreamble::CanReuseAsPrefix(
+    const CompilerInvocation &Invocation,
+    const llvm::MemoryBuffer *MainFileBuffer, PreambleBounds Bounds,
+    llvm::vfs::FileSystem *VFS) const {
+  // The main file is lexed from the end of this preamble, which must be at
+  // the start of a line that is also part of the new preamble.
+  if (!PreambleEndsAtStartOfLine || PreambleBytes.size() >= Bounds.Size)
+    return false;
+  return CanReuse(Invocation, MainFileBuffer, getBounds(), VFS);
+}
+
 void PrecompiledPreamble::AddImplicitPreamble(
     CompilerInvocation &CI, IntrusiveRefCntPtr<llvm::vfs::FileSystem> &VFS,
     llvm::MemoryBuffer *MainFileBuffer) const {
@@ -90,6 +90,8 @@ CreateFrontendBaseAction(CompilerInstance &CI) {
   }
 
   case PrintPreamble:          return llvm::make_unique<PrintPreambleAction>();
+  case PrintDependencyDirectivesSourceMinimizerOutput:
+    return llvm::make_unique<PrintDependencyDirectivesSourceMinimizerAction>();
   case PrintPreprocessedInput: {
     if (CI.getPreprocessorOutputOpts().RewriteIncludes ||
         CI.getPreprocessorOutputOpts().RewriteImports)
@@ -271,6 +273,13 @@ bool ExecuteCompilerInvocation(CompilerInstance *Clang) {
   if (!Act)
     return false;
   bool Success = Clang->ExecuteAction(*Act);
+
+  // Flush a persistent stat cache now: with -disable-free, the FileManager
+  // owning it is never destroyed.
+  if (Clang->hasFileManager() &&
+      !Clang->getFileSystemOpts().StatCacheFile.empty())
+    Clang->getFileManager().clearStatCache();
+
   if (Clang->getFrontendOpts().DisableFree)
     llvm::BuryPointer(std::move(Act));
   return Success;
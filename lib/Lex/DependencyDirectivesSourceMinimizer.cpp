@@ -0,0 +1,475 @@
+//===- DependencyDirectivesSourceMinimizer.cpp -  -------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This is the implementation for minimizing header and source files to the
+/// minimum necessary preprocessor directives for evaluating includes. It
+/// reduces the source down to #define, #include, #import, @import, and any
+/// conditional preprocessor logic that contains one of those.
+///
+//===----------------------------------------------------------------------===//
+
+#include "clang/Lex/DependencyDirectivesSourceMinimizer.h"
+#include "clang/Basic/CharInfo.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringSwitch.h"
+
+using namespace llvm;
+using namespace clang;
+using namespace clang::minimize_source_to_dependency_directives;
+
+namespace {
+
+struct Minimizer {
+  /// Minimized output.
+  SmallVectorImpl<char> &Out;
+  /// The known tokens encountered during the minimization.
+  SmallVectorImpl<Token> &Tokens;
+
+  Minimizer(SmallVectorImpl<char> &Out, SmallVectorImpl<Token> &Tokens,
+            StringRef Input)
+      : Out(Out), Tokens(Tokens), Input(Input) {
+    Out.clear();
+    Tokens.clear();
+  }
+
+  /// Lex the provided source and emit the minimized output.
+  ///
+  /// \returns True on error.
+  bool minimize();
+
+private:
+  /// Skip over the rest of a line that isn't a directive of interest.
+  ///
+  /// \returns True on error.
+  bool skipLine(const char *&First, const char *const End);
+
+  /// Lex the directive that \p First points at the hash of.
+  ///
+  /// \returns True on error.
+  bool lexPPLine(const char *&First, const char *const End);
+
+  /// Lex an Objective-C '@import' declaration.
+  ///
+  /// \returns True on error.
+  bool lexAtImport(const char *&First, const char *const End);
+
+  /// Copy the remainder of the directive's logical line to the output,
+  /// dropping comments and surrounding whitespace, and terminate it with a
+  /// newline.
+  ///
+  /// \returns True on error.
+  bool printDirectiveBody(const char *&First, const char *const End,
+                          bool IsInclude);
+
+  /// Lex a string or raw string literal starting at \p First.
+  ///
+  /// \returns True on error.
+  bool skipStringLiteral(const char *&First, const char *const End);
+
+  bool isRawStringLiteralStart(const char *Quote) const;
+  bool isDigitSeparator(const char *Quote) const;
+
+  void makeToken(TokenKind K) { Tokens.emplace_back(K, Out.size()); }
+  void append(StringRef Str) { Out.append(Str.begin(), Str.end()); }
+
+  StringRef Input;
+};
+
+} // end anonymous namespace
+
+static bool isVerticalWS(char C) { return isVerticalWhitespace(C); }
+
+/// Returns the length of the escaped newline at \p First, or zero if \p First
+/// doesn't point at one. Clang accepts horizontal whitespace between the
+/// backslash and the newline, so do the same here.
+static unsigned getEscapedNewLineSize(const char *First, const char *End) {
+  if (First == End || *First != '\\')
+    return 0;
+  const char *Cur = First + 1;
+  while (Cur != End && isHorizontalWhitespace(*Cur))
+    ++Cur;
+  if (Cur == End || !isVerticalWS(*Cur))
+    return 0;
+  if (Cur + 1 != End && isVerticalWS(Cur[1]) && Cur[0] != Cur[1])
+    ++Cur;
+  return Cur + 1 - First;
+}
+
+static void skipNewline(const char *&First, const char *End) {
+  assert(isVerticalWS(*First) && "Expected a newline");
+  ++First;
+  // Treat "\r\n" and "\n\r" as a single newline.
+  if (First != End && isVerticalWS(*First) && First[-1] != First[0])
+    ++First;
+}
+
+/// Skip the block comment \p First points at.
+///
+/// \returns false if the comment is unterminated.
+static bool skipBlockComment(const char *&First, const char *End) {
+  assert(First + 1 != End && First[0] == '/' && First[1] == '*');
+  First += 2;
+  for (; First != End; ++First) {
+    if (First[0] == '*' && First + 1 != End && First[1] == '/') {
+      First += 2;
+      return true;
+    }
+  }
+  return false;
+}
+
+/// Skip the line comment \p First points at, up to but not including the
+/// newline that ends it. Escaped newlines continue the comment.
+static void skipLineComment(const char *&First, const char *End) {
+  assert(First + 1 != End && First[0] == '/' && First[1] == '/');
+  First += 2;
+  while (First != End) {
+    if (unsigned Size = getEscapedNewLineSize(First, End)) {
+      First += Size;
+      continue;
+    }
+    if (isVerticalWS(*First))
+      return;
+    ++First;
+  }
+}
+
+/// Skip a quoted string or character literal. Stops after the closing quote,
+/// or before the newline ending an unterminated literal.
+static void skipQuoted(const char *&First, const char *End) {
+  const char Terminator = *First++;
+  while (First != End) {
+    if (unsigned Size = getEscapedNewLineSize(First, End)) {
+      First += Size;
+      continue;
+    }
+    const char C = *First;
+    if (C == Terminator) {
+      ++First;
+      return;
+    }
+    if (isVerticalWS(C))
+      return;
+    // Step over the escaped character.
+    if (C == '\\' && First + 1 != End)
+      ++First;
+    ++First;
+  }
+}
+
+/// Skip the raw string literal whose opening quote \p First points at.
+///
+/// \returns false if the literal is unterminated.
+static bool skipRawString(const char *&First, const char *End) {
+  assert(*First == '"');
+  const char *Quote = First;
+  const char *DelimBegin = ++First;
+  while (First != End && *First != '(' && First - DelimBegin < 16 &&
+         !isWhitespace(*First) && *First != ')' && *First != '\\')
+    ++First;
+
+  // Not a valid raw string prefix; let it be lexed as an ordinary string.
+  if (First == End || *First != '(') {
+    First = Quote;
+    skipQuoted(First, End);
+    return true;
+  }
+
+  StringRef Delim(DelimBegin, First - DelimBegin);
+  for (++First; First != End; ++First) {
+    if (*First != ')')
+      continue;
+    StringRef Rest(First + 1, End - First - 1);
+    if (Rest.startswith(Delim) && Rest.size() > Delim.size() &&
+        Rest[Delim.size()] == '"') {
+      First += Delim.size() + 2;
+      return true;
+    }
+  }
+  return false;
+}
+
+/// Skip horizontal whitespace, escaped newlines and block comments.
+///
+/// \returns false if a block comment is unterminated.
+static bool skipHorizontalSpace(const char *&First, const char *End) {
+  while (First != End) {
+    if (isHorizontalWhitespace(*First)) {
+      ++First;
+      continue;
+    }
+    if (unsigned Size = getEscapedNewLineSize(First, End)) {
+      First += Size;
+      continue;
+    }
+    if (First[0] == '/' && First + 1 != End && First[1] == '*') {
+      if (!skipBlockComment(First, End))
+        return false;
+      continue;
+    }
+    break;
+  }
+  return true;
+}
+
+static StringRef lexIdentifier(const char *&First, const char *End) {
+  const char *Begin = First;
+  while (First != End && isIdentifierBody(*First))
+    ++First;
+  return StringRef(Begin, First - Begin);
+}
+
+bool Minimizer::isRawStringLiteralStart(const char *Quote) const {
+  const char *Prefix = Quote;
+  while (Prefix != Input.begin() && isIdentifierBody(Prefix[-1]))
+    --Prefix;
+  return StringSwitch<bool>(StringRef(Prefix, Quote - Prefix))
+      .Cases("R", "uR", "UR", "LR", "u8R", true)
+      .Default(false);
+}
+
+bool Minimizer::isDigitSeparator(const char *Quote) const {
+  // A quote is a C++14 digit separator if it's inside a pp-number, e.g.
+  // 1'000'000 or 0xFF'FF. Character literal prefixes (L, u, U, u8) start
+  // with a letter rather than a digit.
+  const char *Prefix = Quote;
+  while (Prefix != Input.begin() && isIdentifierBody(Prefix[-1]))
+    --Prefix;
+  return Prefix != Quote && isDigit(*Prefix);
+}
+
+bool Minimizer::skipStringLiteral(const char *&First, const char *const End) {
+  if (*First == '"' && isRawStringLiteralStart(First))
+    return !skipRawString(First, End);
+  skipQuoted(First, End);
+  return false;
+}
+
+bool Minimizer::skipLine(const char *&First, const char *const End) {
+  while (First != End) {
+    const char C = *First;
+    if (isVerticalWS(C)) {
+      skipNewline(First, End);
+      return false;
+    }
+    if (unsigned Size = getEscapedNewLineSize(First, End)) {
+      First += Size;
+      continue;
+    }
+    if (C == '/' && First + 1 != End) {
+      if (First[1] == '/') {
+        skipLineComment(First, End);
+        continue;
+      }
+      if (First[1] == '*') {
+        // A block comment spanning lines doesn't end the logical line.
+        if (!skipBlockComment(First, End))
+          return true;
+        continue;
+      }
+    }
+    if (C == '"' || (C == '\'' && !isDigitSeparator(First))) {
+      if (skipStringLiteral(First, End))
+        return true;
+      continue;
+    }
+    ++First;
+  }
+  return false;
+}
+
+bool Minimizer::printDirectiveBody(const char *&First, const char *const End,
+                                   bool IsInclude) {
+  SmallString<128> Body;
+  while (First != End) {
+    const char C = *First;
+    if (isVerticalWS(C)) {
+      skipNewline(First, End);
+      break;
+    }
+    if (unsigned Size = getEscapedNewLineSize(First, End)) {
+      First += Size;
+      continue;
+    }
+    if (C == '/' && First + 1 != End && First[1] == '/') {
+      skipLineComment(First, End);
+      continue;
+    }
+    if (C == '/' && First + 1 != End && First[1] == '*') {
+      if (!skipBlockComment(First, End))
+        return true;
+      Body.push_back(' ');
+      continue;
+    }
+    // The header name of an angled include is not tokenized, so '//' or a
+    // quote inside it must be copied verbatim.
+    if (C == '<' && IsInclude && StringRef(Body).trim().empty()) {
+      const char *Begin = First;
+      while (First != End && *First != '>' && !isVerticalWS(*First))
+        ++First;
+      if (First != End && *First == '>')
+        ++First;
+      Body.append(Begin, First);
+      continue;
+    }
+    if (C == '"' || (C == '\'' && !isDigitSeparator(First))) {
+      const char *Begin = First;
+      if (skipStringLiteral(First, End))
+        return true;
+      Body.append(Begin, First);
+      continue;
+    }
+    Body.push_back(C);
+    ++First;
+  }
+
+  StringRef Trimmed = StringRef(Body).trim();
+  if (!Trimmed.empty()) {
+    Out.push_back(' ');
+    append(Trimmed);
+  }
+  Out.push_back('\n');
+  return false;
+}
+
+bool Minimizer::lexAtImport(const char *&First, const char *const End) {
+  assert(*First == '@' && "Expected an '@import'");
+  makeToken(decl_at_import);
+  append("@import ");
+  First += strlen("@import");
+
+  // The declaration runs up to the semicolon and may span lines; only module
+  // names, dots and whitespace are expected in between.
+  bool NeedSpace = false;
+  while (First != End && *First != ';') {
+    if (isWhitespace(*First)) {
+      ++First;
+      NeedSpace = Out.back() != ' ';
+      continue;
+    }
+    if (First[0] == '/' && First + 1 != End && First[1] == '/') {
+      skipLineComment(First, End);
+      continue;
+    }
+    if (First[0] == '/' && First + 1 != End && First[1] == '*') {
+      if (!skipBlockComment(First, End))
+        return true;
+      continue;
+    }
+    if (NeedSpace)
+      Out.push_back(' ');
+    NeedSpace = false;
+    Out.push_back(*First++);
+  }
+  if (First == End)
+    return true;
+  ++First;
+  append(";\n");
+  return skipLine(First, End);
+}
+
+bool Minimizer::lexPPLine(const char *&First, const char *const End) {
+  assert(*First == '#' && "Expected a directive");
+  ++First;
+  if (!skipHorizontalSpace(First, End))
+    return true;
+
+  StringRef Name = lexIdentifier(First, End);
+  TokenKind Kind = StringSwitch<TokenKind>(Name)
+                       .Case("include", pp_include)
+                       .Case("__include_macros", pp___include_macros)
+                       .Case("define", pp_define)
+                       .Case("undef", pp_undef)
+                       .Case("import", pp_import)
+                       .Case("include_next", pp_include_next)
+                       .Case("if", pp_if)
+                       .Case("ifdef", pp_ifdef)
+                       .Case("ifndef", pp_ifndef)
+                       .Case("elif", pp_elif)
+                       .Case("else", pp_else)
+                       .Case("endif", pp_endif)
+                       .Default(pp_none);
+
+  if (Name == "pragma") {
+    // Only a few pragmas can affect which files get included.
+    const char *Cur = First;
+    if (!skipHorizontalSpace(Cur, End))
+      return true;
+    StringRef Pragma = lexIdentifier(Cur, End);
+    Kind = StringSwitch<TokenKind>(Pragma)
+               .Case("once", pp_pragma_once)
+               .Case("push_macro", pp_pragma_push_macro)
+               .Case("pop_macro", pp_pragma_pop_macro)
+               .Case("include_alias", pp_pragma_include_alias)
+               .Default(pp_none);
+    if (Pragma == "clang") {
+      // #pragma clang module import
+      if (!skipHorizontalSpace(Cur, End))
+        return true;
+      if (lexIdentifier(Cur, End) == "module") {
+        if (!skipHorizontalSpace(Cur, End))
+          return true;
+        if (lexIdentifier(Cur, End) == "import")
+          Kind = pp_pragma_import;
+      }
+    }
+  }
+
+  if (Kind == pp_none)
+    return skipLine(First, End);
+
+  makeToken(Kind);
+  Out.push_back('#');
+  append(Name);
+  bool IsInclude = Kind == pp_include || Kind == pp___include_macros ||
+                   Kind == pp_import || Kind == pp_include_next;
+  return printDirectiveBody(First, End, IsInclude);
+}
+
+bool Minimizer::minimize() {
+  const char *First = Input.begin();
+  const char *const End = Input.end();
+  while (First != End) {
+    // Find the first token on the line.
+    if (!skipHorizontalSpace(First, End))
+      return true;
+    if (First == End)
+      break;
+
+    if (isVerticalWS(*First)) {
+      skipNewline(First, End);
+      continue;
+    }
+
+    if (*First == '#') {
+      if (lexPPLine(First, End))
+        return true;
+      continue;
+    }
+
+    if (*First == '@' && StringRef(First, End - First).startswith("@import") &&
+        (End - First == 7 || !isIdentifierBody(First[7]))) {
+      if (lexAtImport(First, End))
+        return true;
+      continue;
+    }
+
+    if (skipLine(First, End))
+      return true;
+  }
+
+  makeToken(pp_eof);
+  return false;
+}
+
+bool clang::minimizeSourceToDependencyDirectives(
+    StringRef Input, SmallVectorImpl<char> &Output,
+    SmallVectorImpl<Token> &Tokens) {
+  return Minimizer(Output, Tokens, Input).minimize();
+}
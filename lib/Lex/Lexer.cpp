@@ -47,8 +47,129 @@
 #include <tuple>
 #include <utility>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif __ALTIVEC__
+#include <altivec.h>
+#undef bool
+#endif
+
 using namespace clang;
 
+//===----------------------------------------------------------------------===//
+// Character Scanning Helpers
+//===----------------------------------------------------------------------===//
+//
+// These skip runs of characters which need no special handling, 16 bytes at a
+// time when SSE2 is available. They never read at or past BufferEnd in the
+// vector loops, and the scalar loops rely on the buffer being nul-terminated.
+
+#ifdef __SSE2__
+/// Return a mask with the bits set for the bytes of \p Chunk which are equal
+/// to \p C.
+static inline unsigned matchByte(__m128i Chunk, char C) {
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(Chunk, _mm_set1_epi8(C)));
+}
+
+/// Return a mask with the bits set for the bytes of \p Chunk which lie in the
+/// ASCII range [\p Lo, \p Hi]. Bytes >= 0x80 compare as negative and are never
+/// in range.
+static inline unsigned matchRange(__m128i Chunk, char Lo, char Hi) {
+  __m128i AboveLo = _mm_cmpgt_epi8(Chunk, _mm_set1_epi8(Lo - 1));
+  __m128i BelowHi = _mm_cmplt_epi8(Chunk, _mm_set1_epi8(Hi + 1));
+  return _mm_movemask_epi8(_mm_and_si128(AboveLo, BelowHi));
+}
+
+static inline __m128i loadChunk(const char *Ptr) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i *>(Ptr));
+}
+#endif
+
+/// Skip the characters [_A-Za-z0-9] starting at \p CurPtr, i.e. the part of
+/// an identifier which is matched by isIdentifierBody.
+static const char *skipIdentifierBody(const char *CurPtr,
+                                      const char *BufferEnd) {
+#ifdef __SSE2__
+  while (CurPtr + 16 <= BufferEnd) {
+    __m128i Chunk = loadChunk(CurPtr);
+    // Setting bit 5 maps [A-Z] onto [a-z] and nothing else onto [a-z].
+    __m128i Lower = _mm_or_si128(Chunk, _mm_set1_epi8(0x20));
+    unsigned Mask = matchRange(Lower, 'a', 'z') | matchRange(Chunk, '0', '9') |
+                    matchByte(Chunk, '_');
+    if (Mask != 0xFFFF)
+      return CurPtr + llvm::countTrailingOnes(Mask);
+    CurPtr += 16;
+  }
+#endif
+  while (isIdentifierBody(*CurPtr))
+    ++CurPtr;
+  return CurPtr;
+}
+
+/// Skip the horizontal whitespace characters starting at \p CurPtr.
+static const char *skipHorizontalWhitespace(const char *CurPtr,
+                                            const char *BufferEnd) {
+#ifdef __SSE2__
+  while (CurPtr + 16 <= BufferEnd) {
+    __m128i Chunk = loadChunk(CurPtr);
+    unsigned Mask = matchByte(Chunk, ' ') | matchByte(Chunk, '\t') |
+                    matchByte(Chunk, '\f') | matchByte(Chunk, '\v');
+    if (Mask != 0xFFFF)
+      return CurPtr + llvm::countTrailingOnes(Mask);
+    CurPtr += 16;
+  }
+#endif
+  while (isHorizontalWhitespace(*CurPtr))
+    ++CurPtr;
+  return CurPtr;
+}
+
+/// Skip the characters of a string literal body starting at \p CurPtr which
+/// are not the closing quote \p Terminator, an escape, a newline, a nul or a
+/// '?' (which might start a trigraph). Lexer::getAndAdvanceChar would return
+/// all of the skipped characters unchanged.
+static const char *skipSimpleStringChars(const char *CurPtr,
+                                         const char *BufferEnd,
+                                         char Terminator) {
+#ifdef __SSE2__
+  while (CurPtr + 16 <= BufferEnd) {
+    __m128i Chunk = loadChunk(CurPtr);
+    unsigned Mask = matchByte(Chunk, Terminator) | matchByte(Chunk, '\\') |
+                    matchByte(Chunk, '\n') | matchByte(Chunk, '\r') |
+                    matchByte(Chunk, '\0') | matchByte(Chunk, '?');
+    if (Mask != 0)
+      return CurPtr + llvm::countTrailingZeros(Mask);
+    CurPtr += 16;
+  }
+#endif
+  while (true) {
+    char C = *CurPtr;
+    if (C == Terminator || C == '\\' || C == '\n' || C == '\r' || C == 0 ||
+        C == '?')
+      return CurPtr;
+    ++CurPtr;
+  }
+}
+
+/// Skip the characters of a raw string literal body starting at \p CurPtr
+/// which can neither end the literal nor the buffer, i.e. anything but ')'
+/// and nul.
+static const char *skipRawStringChars(const char *CurPtr,
+                                      const char *BufferEnd) {
+#ifdef __SSE2__
+  while (CurPtr + 16 <= BufferEnd) {
+    __m128i Chunk = loadChunk(CurPtr);
+    unsigned Mask = matchByte(Chunk, ')') | matchByte(Chunk, '\0');
+    if (Mask != 0)
+      return CurPtr + llvm::countTrailingZeros(Mask);
+    CurPtr += 16;
+  }
+#endif
+  while (*CurPtr != ')' && *CurPtr != 0)
+    ++CurPtr;
+  return CurPtr;
+}
+
 //===----------------------------------------------------------------------===//
 // Token Class Implementation
 //===----------------------------------------------------------------------===//
@@ -1629,11 +1750,8 @@ bool Lexer::tryConsumeIdentifierUTF8Char(const char *&CurPtr) {
 bool Lexer::LexIdentifier(Token &Result, const char *CurPtr) {
   // Match [_A-Za-z0-9]*, we have already matched [_A-Za-z$]
   unsigned Size;
-  unsigned char C = *CurPtr++;
-  while (isIdentifierBody(C))
-    C = *CurPtr++;
-
-  --CurPtr;   // Back up over the skipped character.
+  CurPtr = skipIdentifierBody(CurPtr, BufferEnd);
+  unsigned char C = *CurPtr;
 
   // Fast path, no $,\,? in identifier found.  '\' might be an escaped newline
   // or UCN, and ? might be a trigraph for '\', an escaped newline or UCN.
@@ -1935,6 +2053,7 @@ bool Lexer::LexStringLiteral(Token &Result, const char *CurPtr,
 
       NulCharacter = CurPtr-1;
     }
+    CurPtr = skipSimpleStringChars(CurPtr, BufferEnd, '"');
     C = getAndAdvanceChar(CurPtr, Result);
   }
 
@@ -2005,6 +2124,7 @@ bool Lexer::LexRawStringLiteral(Token &Result, const char *CurPtr,
   CurPtr += PrefixLen + 1; // skip over prefix and '('
 
   while (true) {
+    CurPtr = skipRawStringChars(CurPtr, BufferEnd);
     char C = *CurPtr++;
 
     if (C == ')') {
@@ -2184,8 +2304,8 @@ bool Lexer::SkipWhitespace(Token &Result, const char *CurPtr,
   // Skip consecutive spaces efficiently.
   while (true) {
     // Skip horizontal whitespace very aggressively.
-    while (isHorizontalWhitespace(Char))
-      Char = *++CurPtr;
+    CurPtr = skipHorizontalWhitespace(CurPtr, BufferEnd);
+    Char = *CurPtr;
 
     // Otherwise if we have something other than whitespace, we're done.
     if (!isVerticalWhitespace(Char))
@@ -2460,13 +2580,6 @@ static bool isEndOfBlockCommentWithEscapedNewLine(const char *CurPtr,
   return true;
 }
 
-#ifdef __SSE2__
-#include <emmintrin.h>
-#elif __ALTIVEC__
-#include <altivec.h>
-#undef bool
-#endif
-
 /// We have just read from input the / and * characters that started a comment.
 /// Read until we find the * and / characters that terminate the comment.
 /// Note that we don't bother decoding trigraphs or escaped newlines in block
@@ -614,6 +614,10 @@ bool Preprocessor::usingPCHWithPragmaHdrStop() {
   return TUKind != TU_Prefix && PPOpts->PCHWithHdrStop;
 }
 
+bool Preprocessor::isCancellationRequested() const {
+  return PPOpts->Cancellation && PPOpts->Cancellation->isCancelled();
+}
+
 /// Skip tokens until after the #include of the through header or
 /// until after a #pragma hdrstop is seen. Tokens in the predefines file
 /// and the main file may be skipped. If the end of the predefines file
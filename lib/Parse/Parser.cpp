@@ -715,7 +715,9 @@ Parser::ParseExternalDeclaration(ParsedAttributesWithRange &attrs,
   DestroyTemplateIdAnnotationsRAIIObj CleanupRAII(TemplateIds);
   ParenBraceBracketBalancer BalancerRAIIObj(*this);
 
-  if (PP.isCodeCompletionReached()) {
+  // Stop at a declaration boundary when the client cancelled the parse; the
+  // declarations parsed so far form a partial translation unit.
+  if (PP.isCodeCompletionReached() || PP.isCancellationRequested()) {
     cutOffParsing();
     return nullptr;
   }
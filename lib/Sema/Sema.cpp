@@ -949,6 +949,21 @@ void Sema::ActOnEndOfTranslationUnit() {
                                  LateParsedInstantiations.begin(),
                                  LateParsedInstantiations.end());
     LateParsedInstantiations.clear();
+
+    // Perform the implicit instantiations of the function templates that are
+    // already defined, so that translation units using the prefix load them
+    // instead of performing them again. The others are serialized as pending.
+    if (LangOpts.PCHInstantiateTemplates) {
+      {
+        llvm::TimeTraceScope TimeScope("PerformPendingInstantiations",
+                                       StringRef(""));
+        PerformPendingInstantiations();
+      }
+      PendingInstantiations.insert(PendingInstantiations.end(),
+                                   PendingPrefixInstantiations.begin(),
+                                   PendingPrefixInstantiations.end());
+      PendingPrefixInstantiations.clear();
+    }
   }
 
   DiagnoseUnterminatedPragmaPack();
@@ -1041,6 +1041,10 @@ void ResultBuilder::MaybeAddResult(Result R, DeclContext *CurContext) {
     return;
   }
 
+  // Keep the results found so far if the client cancelled the completion.
+  if (SemaRef.PP.isCancellationRequested())
+    return;
+
   // Look through using declarations.
   if (const UsingShadowDecl *Using = dyn_cast<UsingShadowDecl>(R.Declaration)) {
     CodeCompletionResult Result(Using->getTargetDecl(),
@@ -1164,6 +1168,10 @@ void ResultBuilder::AddResult(Result R, DeclContext *CurContext,
     return;
   }
 
+  // Keep the results found so far if the client cancelled the completion.
+  if (SemaRef.PP.isCancellationRequested())
+    return;
+
   // Look through using declarations.
   if (const auto *Using = dyn_cast<UsingShadowDecl>(R.Declaration)) {
     CodeCompletionResult Result(Using->getTargetDecl(),
@@ -32,6 +32,7 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/Support/TimeProfiler.h"
 #include <algorithm>
 #include <cstdlib>
 
@@ -6048,9 +6049,30 @@ void Sema::AddOverloadCandidate(
   EnterExpressionEvaluationContext Unevaluated(
       *this, Sema::ExpressionEvaluationContext::Unevaluated);
 
-  // Add this candidate
+  // (C++ 13.3.2p2): A candidate function having fewer than m
+  // parameters is viable only if it has an ellipsis in its parameter
+  // list (8.3.5).
+  unsigned NumParams = Proto->getNumParams();
+  bool TooManyArgs =
+      TooManyArguments(NumParams, Args.size(), PartialOverloading) &&
+      !Proto->isVariadic();
+
+  // (C++ 13.3.2p2): A candidate function having more than m parameters
+  // is viable only if the (m+1)st parameter has a default argument
+  // (8.3.6). For the purposes of overload resolution, the
+  // parameter list is truncated on the right, so that there are
+  // exactly m parameters.
+  bool TooFewArgs = Args.size() < Function->getMinRequiredArguments() &&
+                    !PartialOverloading;
+
+  // Add this candidate. A candidate with the wrong number of parameters is
+  // never viable and its conversions are never looked at, so don't bother
+  // allocating them.
+  unsigned NumConversions = Args.size();
+  if ((TooManyArgs || TooFewArgs) && EarlyConversions.empty())
+    NumConversions = 0;
   OverloadCandidate &Candidate =
-      CandidateSet.addCandidate(Args.size(), EarlyConversions);
+      CandidateSet.addCandidate(NumConversions, EarlyConversions);
   Candidate.FoundDecl = FoundDecl;
   Candidate.Function = Function;
   Candidate.Viable = true;
@@ -6103,25 +6125,13 @@ void Sema::AddOverloadCandidate(
     }
   }
 
-  unsigned NumParams = Proto->getNumParams();
-
-  // (C++ 13.3.2p2): A candidate function having fewer than m
-  // parameters is viable only if it has an ellipsis in its parameter
-  // list (8.3.5).
-  if (TooManyArguments(NumParams, Args.size(), PartialOverloading) &&
-      !Proto->isVariadic()) {
+  if (TooManyArgs) {
     Candidate.Viable = false;
     Candidate.FailureKind = ovl_fail_too_many_arguments;
     return;
   }
 
-  // (C++ 13.3.2p2): A candidate function having more than m parameters
-  // is viable only if the (m+1)st parameter has a default argument
-  // (8.3.6). For the purposes of overload resolution, the
-  // parameter list is truncated on the right, so that there are
-  // exactly m parameters.
-  unsigned MinRequiredArgs = Function->getMinRequiredArguments();
-  if (Args.size() < MinRequiredArgs && !PartialOverloading) {
+  if (TooFewArgs) {
     // Not enough arguments.
     Candidate.Viable = false;
     Candidate.FailureKind = ovl_fail_too_few_arguments;
@@ -6589,34 +6599,42 @@ Sema::AddMethodCandidate(CXXMethodDecl *Method, DeclAccessPair FoundDecl,
   EnterExpressionEvaluationContext Unevaluated(
       *this, Sema::ExpressionEvaluationContext::Unevaluated);
 
-  // Add this candidate
+  // (C++ 13.3.2p2): A candidate function having fewer than m
+  // parameters is viable only if it has an ellipsis in its parameter
+  // list (8.3.5).
+  unsigned NumParams = Proto->getNumParams();
+  bool TooManyArgs =
+      TooManyArguments(NumParams, Args.size(), PartialOverloading) &&
+      !Proto->isVariadic();
+
+  // (C++ 13.3.2p2): A candidate function having more than m parameters
+  // is viable only if the (m+1)st parameter has a default argument
+  // (8.3.6). For the purposes of overload resolution, the
+  // parameter list is truncated on the right, so that there are
+  // exactly m parameters.
+  bool TooFewArgs = Args.size() < Method->getMinRequiredArguments() &&
+                    !PartialOverloading;
+
+  // Add this candidate. As in AddOverloadCandidate, don't allocate
+  // conversions for a candidate with the wrong number of parameters.
+  unsigned NumConversions = Args.size() + 1;
+  if ((TooManyArgs || TooFewArgs) && EarlyConversions.empty())
+    NumConversions = 0;
   OverloadCandidate &Candidate =
-      CandidateSet.addCandidate(Args.size() + 1, EarlyConversions);
+      CandidateSet.addCandidate(NumConversions, EarlyConversions);
   Candidate.FoundDecl = FoundDecl;
   Candidate.Function = Method;
   Candidate.IsSurrogate = false;
   Candidate.IgnoreObjectArgument = false;
   Candidate.ExplicitCallArguments = Args.size();
 
-  unsigned NumParams = Proto->getNumParams();
-
-  // (C++ 13.3.2p2): A candidate function having fewer than m
-  // parameters is viable only if it has an ellipsis in its parameter
-  // list (8.3.5).
-  if (TooManyArguments(NumParams, Args.size(), PartialOverloading) &&
-      !Proto->isVariadic()) {
+  if (TooManyArgs) {
     Candidate.Viable = false;
     Candidate.FailureKind = ovl_fail_too_many_arguments;
     return;
   }
 
-  // (C++ 13.3.2p2): A candidate function having more than m parameters
-  // is viable only if the (m+1)st parameter has a default argument
-  // (8.3.6). For the purposes of overload resolution, the
-  // parameter list is truncated on the right, so that there are
-  // exactly m parameters.
-  unsigned MinRequiredArgs = Method->getMinRequiredArguments();
-  if (Args.size() < MinRequiredArgs && !PartialOverloading) {
+  if (TooFewArgs) {
     // Not enough arguments.
     Candidate.Viable = false;
     Candidate.FailureKind = ovl_fail_too_few_arguments;
@@ -12218,6 +12236,18 @@ static void markUnaddressableCandidatesUnviable(Sema &S,
   }
 }
 
+/// Describe the overload resolution of a call to \p Name at \p Loc in the
+/// time trace.
+static std::string getOverloadTimeTraceDetail(Sema &S, DeclarationName Name,
+                                              SourceLocation Loc) {
+  std::string Detail;
+  llvm::raw_string_ostream OS(Detail);
+  OS << Name << " (";
+  Loc.print(OS, S.getSourceManager());
+  OS << ')';
+  return OS.str();
+}
+
 /// BuildOverloadedCallExpr - Given the call expression that calls Fn
 /// (which eventually refers to the declaration Func) and the call
 /// arguments Args/NumArgs, attempt to resolve the function call down
@@ -12232,6 +12262,10 @@ ExprResult Sema::BuildOverloadedCallExpr(Scope *S, Expr *Fn,
                                          Expr *ExecConfig,
                                          bool AllowTypoCorrection,
                                          bool CalleesAddressIsTaken) {
+  llvm::TimeTraceScope TimeScope("OverloadResolution", [&]() {
+    return getOverloadTimeTraceDetail(*this, ULE->getName(), Fn->getExprLoc());
+  });
+
   OverloadCandidateSet CandidateSet(Fn->getExprLoc(),
                                     OverloadCandidateSet::CSK_Normal);
   ExprResult result;
@@ -12284,6 +12318,10 @@ Sema::CreateOverloadedUnaryOp(SourceLocation OpLoc, UnaryOperatorKind Opc,
   // TODO: provide better source location info.
   DeclarationNameInfo OpNameInfo(OpName, OpLoc);
 
+  llvm::TimeTraceScope TimeScope("OverloadResolution", [&]() {
+    return getOverloadTimeTraceDetail(*this, OpName, OpLoc);
+  });
+
   if (checkPlaceholderForOverload(*this, Input))
     return ExprError();
 
@@ -12476,6 +12514,10 @@ Sema::CreateOverloadedBinOp(SourceLocation OpLoc,
   OverloadedOperatorKind Op = BinaryOperator::getOverloadedOperator(Opc);
   DeclarationName OpName = Context.DeclarationNames.getCXXOperatorName(Op);
 
+  llvm::TimeTraceScope TimeScope("OverloadResolution", [&]() {
+    return getOverloadTimeTraceDetail(*this, OpName, OpLoc);
+  });
+
   // If either side is type-dependent, create an appropriate dependent
   // expression.
   if (Args[0]->isTypeDependent() || Args[1]->isTypeDependent()) {
@@ -2018,7 +2018,10 @@ Sema::InstantiateClass(SourceLocation PointOfInstantiation,
     llvm::raw_string_ostream OS(Name);
     Instantiation->getNameForDiagnostic(OS, getPrintingPolicy(),
                                         /*Qualified=*/true);
-    return Name;
+    OS << " (";
+    PatternDef->getLocation().print(OS, getSourceManager());
+    OS << ')';
+    return OS.str();
   });
 
   Pattern = PatternDef;
@@ -4160,7 +4160,10 @@ void Sema::InstantiateFunctionDefinition(SourceLocation PointOfInstantiation,
     llvm::raw_string_ostream OS(Name);
     Function->getNameForDiagnostic(OS, getPrintingPolicy(),
                                    /*Qualified=*/true);
-    return Name;
+    OS << " (";
+    PatternDecl->getLocation().print(OS, getSourceManager());
+    OS << ')';
+    return OS.str();
   });
 
   // If we're performing recursive template instantiation, create our own
@@ -5493,16 +5496,42 @@ NamedDecl *Sema::FindInstantiatedDecl(SourceLocation Loc, NamedDecl *D,
   return D;
 }
 
+/// Determine whether the pending instantiation of \p D can be performed at the
+/// end of a translation unit prefix. Only function templates that are already
+/// defined are instantiated there, as the definitions of the others, and of
+/// static data members, can still follow the prefix.
+static bool canInstantiateInPrefix(ValueDecl *D) {
+  auto *Function = dyn_cast<FunctionDecl>(D);
+  if (!Function)
+    return false;
+  const FunctionDecl *Pattern = Function->getTemplateInstantiationPattern();
+  const FunctionDecl *PatternDef = Pattern ? Pattern->getDefinition() : nullptr;
+  return PatternDef && !PatternDef->willHaveBody();
+}
+
 /// Performs template instantiation for all implicit template
 /// instantiations we have seen until this point.
 void Sema::PerformPendingInstantiations(bool LocalOnly) {
   while (!PendingLocalImplicitInstantiations.empty() ||
          (!LocalOnly && !PendingInstantiations.empty())) {
+    // Leave the remaining instantiations pending if the client cancelled the
+    // parse. The eager instantiation scopes expect their queues to be
+    // drained, so only stop at the end of the translation unit.
+    if (!LocalOnly && !NumGlobalEagerInstantiationScopes &&
+        PP.isCancellationRequested())
+      return;
+
     PendingImplicitInstantiation Inst;
 
     if (PendingLocalImplicitInstantiations.empty()) {
       Inst = PendingInstantiations.front();
       PendingInstantiations.pop_front();
+
+      if (TUKind == TU_Prefix && LangOpts.PCHInstantiateTemplates &&
+          !canInstantiateInPrefix(Inst.first)) {
+        PendingPrefixInstantiations.push_back(Inst);
+        continue;
+      }
     } else {
       Inst = PendingLocalImplicitInstantiations.front();
       PendingLocalImplicitInstantiations.pop_front();
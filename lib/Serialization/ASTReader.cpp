@@ -96,6 +96,7 @@
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
@@ -113,6 +114,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/SaveAndRestore.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/VersionTuple.h"
 #include "llvm/Support/raw_ostream.h"
@@ -135,6 +137,14 @@
 using namespace clang;
 using namespace clang::serialization;
 using namespace clang::serialization::reader;
+
+#define DEBUG_TYPE "ast-reader"
+
+STATISTIC(NumModuleFilesValidated,
+          "Number of module files whose input files were validated");
+STATISTIC(NumFinalModuleFilesNotValidated,
+          "Number of module files this compilation had already built or "
+          "validated");
 using llvm::BitstreamCursor;
 
 //===----------------------------------------------------------------------===//
@@ -2093,6 +2103,29 @@ ASTReader::readInputFileInfo(ModuleFile &F, unsigned ID) {
   return R;
 }
 
+void ASTReader::prefetchInputFiles(ModuleFile &F, unsigned NumInputs) {
+  // Below this, the threads would cost more than the stat() calls.
+  const unsigned MinInputsToPrefetch = 16;
+  unsigned NumThreads = PP.getHeaderSearchInfo()
+                            .getHeaderSearchOpts()
+                            .ModulesValidationThreads;
+  if (NumThreads < 2 || NumInputs < MinInputsToPrefetch)
+    return;
+
+  std::vector<std::string> Filenames;
+  for (unsigned I = 0; I < NumInputs; ++I) {
+    if (F.InputFilesLoaded[I].getFile() || F.InputFilesLoaded[I].isNotFound())
+      continue;
+    InputFileInfo FI = readInputFileInfo(F, I+1);
+    if (!FI.Overridden && !FI.Transient)
+      Filenames.push_back(std::move(FI.Filename));
+  }
+
+  if (!InputFileStatPool)
+    InputFileStatPool = llvm::make_unique<llvm::ThreadPool>(NumThreads);
+  FileMgr.prefetchFileStats(Filenames, *InputFileStatPool);
+}
+
 static unsigned moduleKindForDiagnostic(ModuleKind Kind);
 InputFile ASTReader::getInputFile(ModuleFile &F, unsigned ID, bool Complain) {
   // If this ID is bogus, just return an empty input file.
@@ -2326,6 +2359,8 @@ ASTReader::ASTReadResult ASTReader::ReadOptionsBlock(
   }
 }
 
+static bool wasValidatedInBuildSession(const ModuleFile &MF);
+
 ASTReader::ASTReadResult
 ASTReader::ReadControlBlock(ModuleFile &F,
                             SmallVectorImpl<ImportedModule> &Loaded,
@@ -2390,12 +2425,31 @@ ASTReader::ReadControlBlock(ModuleFile &F,
         // files.
 
         unsigned N = NumUserInputs;
-        if (ValidateSystemInputs ||
-            (HSOpts.ModulesValidateOncePerBuildSession &&
-             F.InputFilesValidationTimestamp <= HSOpts.BuildSessionTimestamp &&
-             F.Kind == MK_ImplicitModule))
+        // A module that was already built or validated by this process was
+        // checked against the same (cached) file system, so checking its
+        // inputs again can't find anything new.
+        if (F.Kind == MK_ImplicitModule &&
+            getModuleManager().getModuleCache().isPCMFinal(F.FileName)) {
+          N = 0;
+          ++NumFinalModuleFilesNotValidated;
+        } else if (F.Kind == MK_ImplicitModule &&
+                   HSOpts.ModulesValidateOncePerBuildSession &&
+                   HSOpts.ModulesValidateSignatureOncePerBuildSession &&
+                   F.InputFilesValidationTimestamp >
+                       HSOpts.BuildSessionTimestamp &&
+                   wasValidatedInBuildSession(F)) {
+          N = 0;
+        } else if (ValidateSystemInputs ||
+                   (HSOpts.ModulesValidateOncePerBuildSession &&
+                    F.InputFilesValidationTimestamp <=
+                        HSOpts.BuildSessionTimestamp &&
+                    F.Kind == MK_ImplicitModule)) {
           N = NumInputs;
+        }
 
+        if (N)
+          ++NumModuleFilesValidated;
+        prefetchInputFiles(F, N);
         for (unsigned I = 0; I < N; ++I) {
           InputFile IF = getInputFile(F, I+1, Complain);
           if (!IF.getFile() || IF.isOutOfDate())
@@ -3829,18 +3883,48 @@ bool ASTReader::isGlobalIndexUnavailable() const {
          !hasGlobalIndex() && TriedLoadingGlobalIndex;
 }
 
+/// Returns the line of the timestamp file that records that the module file
+/// with the signature of \p MF was validated, or an empty string if the
+/// module file has no signature.
+static std::string getValidatedSignatureLine(const ModuleFile &MF) {
+  if (!MF.Signature)
+    return std::string();
+  std::string Line;
+  llvm::raw_string_ostream OS(Line);
+  OS << "signature";
+  for (uint32_t Word : MF.Signature)
+    OS << ' ' << Word;
+  OS << '\n';
+  return OS.str();
+}
+
 static void updateModuleTimestamp(ModuleFile &MF) {
   // Overwrite the timestamp file contents so that file's mtime changes.
   std::string TimestampFilename = MF.getTimestampFilename();
   std::error_code EC;
-  llvm::raw_fd_ostream OS(TimestampFilename, EC, llvm::sys::fs::F_Text);
+  llvm::raw_fd_ostream OS(TimestampFilename, EC, llvm::sys::fs::F_None);
   if (EC)
     return;
-  OS << "Timestamp file\n";
+  // Also record the signature of the module file, which identifies the
+  // contents that were validated during the build session.
+  OS << "Timestamp file\n" << getValidatedSignatureLine(MF);
   OS.close();
   OS.clear_error(); // Avoid triggering a fatal error.
 }
 
+/// Whether the timestamp file of \p MF records that a module file with the
+/// same signature was validated; the caller checks that this happened during
+/// the current build session.
+static bool wasValidatedInBuildSession(const ModuleFile &MF) {
+  std::string SignatureLine = getValidatedSignatureLine(MF);
+  if (SignatureLine.empty())
+    return false;
+  auto Buffer = llvm::MemoryBuffer::getFile(MF.getTimestampFilename());
+  if (!Buffer)
+    return false;
+  return (*Buffer)->getBuffer() == "Timestamp file\n" + SignatureLine;
+}
+
 /// Given a cursor at the start of an AST file, scan ahead and drop the
 /// cursor into the start of the given block ID, returning false on success and
 /// true on failure.
@@ -4224,9 +4308,14 @@ ASTReader::ReadASTCore(StringRef FileName,
     }
 
     switch (Entry.ID) {
-    case CONTROL_BLOCK_ID:
+    case CONTROL_BLOCK_ID: {
       HaveReadControlBlock = true;
-      switch (ReadControlBlock(F, Loaded, ImportedBy, ClientLoadCapabilities)) {
+      ASTReadResult ControlResult =
+          ReadControlBlock(F, Loaded, ImportedBy, ClientLoadCapabilities);
+      // The input files that were stat()ed ahead of time have been validated
+      // by now; a stat that wasn't used would be stale by the time it is.
+      FileMgr.clearPrefetchedStats();
+      switch (ControlResult) {
       case Success:
         // Check that we didn't try to load a non-module AST file as a module.
         //
@@ -4251,6 +4340,7 @@ ASTReader::ReadASTCore(StringRef FileName,
       case HadErrors: return HadErrors;
       }
       break;
+    }
 
     case AST_BLOCK_ID:
       if (!HaveReadControlBlock) {
@@ -4644,7 +4734,8 @@ std::string ASTReader::getOriginalSourceFile(
     const std::string &ASTFileName, FileManager &FileMgr,
     const PCHContainerReader &PCHContainerRdr, DiagnosticsEngine &Diags) {
   // Open the AST file.
-  auto Buffer = FileMgr.getBufferForFile(ASTFileName);
+  auto Buffer = FileMgr.getBufferForFile(ASTFileName, /*isVolatile=*/false,
+                                         /*RequiresNullTerminator=*/false);
   if (!Buffer) {
     Diags.Report(diag::err_fe_unable_to_read_pch_file)
         << ASTFileName << Buffer.getError().message();
@@ -4744,7 +4835,8 @@ bool ASTReader::readASTFileControlBlock(
   // Open the AST file.
   // FIXME: This allows use of the VFS; we do not allow use of the
   // VFS when actually loading a module.
-  auto Buffer = FileMgr.getBufferForFile(Filename);
+  auto Buffer = FileMgr.getBufferForFile(Filename, /*isVolatile=*/false,
+                                         /*RequiresNullTerminator=*/false);
   if (!Buffer) {
     return true;
   }
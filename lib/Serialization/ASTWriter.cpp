@@ -64,6 +64,7 @@
 #include "clang/Sema/Sema.h"
 #include "clang/Sema/Weak.h"
 #include "clang/Serialization/ASTReader.h"
+#include "clang/Serialization/DeserializationProfile.h"
 #include "clang/Serialization/InMemoryModuleCache.h"
 #include "clang/Serialization/Module.h"
 #include "clang/Serialization/ModuleFileExtension.h"
@@ -4685,6 +4686,42 @@ static void AddLazyVectorDecls(ASTWriter &Writer, Vector &Vec,
   }
 }
 
+/// Collect the declarations of \p DC and of its nested declaration contexts
+/// that have a rank in \p Ranks, without looking into function bodies.
+static void
+collectHotDecls(const DeclContext *DC, const llvm::StringMap<unsigned> &Ranks,
+                SmallVectorImpl<std::pair<unsigned, Decl *>> &HotDecls) {
+  for (Decl *D : DC->noload_decls()) {
+    if (D->isFromASTFile())
+      continue;
+    auto It = Ranks.find(DeserializationProfile::getDeclKey(D));
+    if (It != Ranks.end())
+      HotDecls.push_back(std::make_pair(It->second, D));
+    if (auto *Template = dyn_cast<TemplateDecl>(D))
+      if (NamedDecl *Templated = Template->getTemplatedDecl()) {
+        It = Ranks.find(DeserializationProfile::getDeclKey(Templated));
+        if (It != Ranks.end())
+          HotDecls.push_back(std::make_pair(It->second, Templated));
+        D = Templated;
+      }
+    if (auto *Inner = dyn_cast<DeclContext>(D))
+      if (!Inner->isFunctionOrMethod())
+        collectHotDecls(Inner, Ranks, HotDecls);
+  }
+}
+
+void ASTWriter::AssignHotDeclIDs(ASTContext &Context) {
+  llvm::StringMap<unsigned> Ranks;
+  for (unsigned I = 0, N = HotDeclKeys.size(); I != N; ++I)
+    Ranks.try_emplace(HotDeclKeys[I], I);
+
+  SmallVector<std::pair<unsigned, Decl *>, 64> HotDecls;
+  collectHotDecls(Context.getTranslationUnitDecl(), Ranks, HotDecls);
+  llvm::stable_sort(HotDecls, llvm::less_first());
+  for (const auto &HotDecl : HotDecls)
+    GetDeclRef(HotDecl.second);
+}
+
 ASTFileSignature ASTWriter::WriteASTCore(Sema &SemaRef, StringRef isysroot,
                                          const std::string &OutputFile,
                                          Module *WritingModule) {
@@ -4731,6 +4768,11 @@ ASTFileSignature ASTWriter::WriteASTCore(Sema &SemaRef, StringRef isysroot,
   RegisterPredefDecl(Context.TypePackElementDecl,
                      PREDEF_DECL_TYPE_PACK_ELEMENT_ID);
 
+  // Assign the first IDs to the hot declarations, which makes them the first
+  // ones to be written.
+  if (!isModule && !HotDeclKeys.empty())
+    AssignHotDeclIDs(Context);
+
   // Build a record containing all of the tentative definitions in this file, in
   // TentativeDefinitions order.  Generally, this record will be empty for
   // headers.
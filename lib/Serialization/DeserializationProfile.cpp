@@ -0,0 +1,94 @@
+//===- DeserializationProfile.cpp - Record of deserialized decls ----------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the DeserializationProfile class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Serialization/DeserializationProfile.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Decl.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Serialization/ASTReader.h"
+#include "clang/Serialization/Module.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace clang;
+
+void DeserializationProfile::addDecl(const Decl *D) {
+  if (SeenDecls.insert(D).second)
+    Decls.push_back(D);
+}
+
+void DeserializationProfile::addIdentifier(const IdentifierInfo *II) {
+  if (II && SeenIdentifiers.insert(II).second)
+    Identifiers.push_back(II);
+}
+
+void DeserializationProfile::write(raw_ostream &OS) const {
+  OS << "# " << Decls.size() << " declarations and " << Identifiers.size()
+     << " identifiers deserialized\n";
+  for (const Decl *D : Decls) {
+    std::string Key = getDeclKey(D);
+    if (Key.empty())
+      continue;
+    OS << "decl\t";
+    if (Reader)
+      if (serialization::ModuleFile *MF = Reader->getOwningModuleFile(D))
+        OS << MF->FileName;
+    OS << '\t' << Key << '\t';
+    if (const auto *ND = dyn_cast<NamedDecl>(D))
+      ND->printQualifiedName(OS);
+    OS << '\n';
+  }
+  for (const IdentifierInfo *II : Identifiers)
+    OS << "identifier\t" << II->getName() << '\n';
+}
+
+std::string DeserializationProfile::getDeclKey(const Decl *D) {
+  // Offsets are used rather than lines and columns, as computing those would
+  // read the headers from disk.
+  const SourceManager &SM = D->getASTContext().getSourceManager();
+  std::pair<FileID, unsigned> Loc =
+      SM.getDecomposedExpansionLoc(D->getLocation());
+  const FileEntry *File = Loc.first.isValid()
+                              ? SM.getFileEntryForID(Loc.first)
+                              : nullptr;
+  if (!File)
+    return std::string();
+
+  // Name the file the way the AST writer does, as the reader sees the names
+  // stored in the AST file while the writer sees the names used in lookups.
+  SmallString<256> Path(File->getName());
+  SM.getFileManager().makeAbsolutePath(Path);
+  llvm::sys::path::remove_dots(Path);
+
+  std::string Key;
+  llvm::raw_string_ostream OS(Key);
+  OS << D->getDeclKindName() << '\t' << Path << ':' << Loc.second;
+  return OS.str();
+}
+
+std::vector<std::string>
+DeserializationProfile::readDeclKeys(StringRef Buffer) {
+  std::vector<std::string> Keys;
+  SmallVector<StringRef, 5> Fields;
+  while (!Buffer.empty()) {
+    StringRef Line;
+    std::tie(Line, Buffer) = Buffer.split('\n');
+    Fields.clear();
+    Line.rtrim("\r").split(Fields, '\t');
+    // The key is made of the kind and location fields.
+    if (Fields.size() < 4 || Fields[0] != "decl")
+      continue;
+    Keys.push_back((Fields[2] + "\t" + Fields[3]).str());
+  }
+  return Keys;
+}
@@ -14,8 +14,10 @@
 #include "clang/AST/ASTContext.h"
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/Preprocessor.h"
+#include "clang/Lex/PreprocessorOptions.h"
 #include "clang/Sema/SemaConsumer.h"
 #include "clang/Serialization/ASTWriter.h"
+#include "clang/Serialization/DeserializationProfile.h"
 #include "llvm/Bitcode/BitstreamWriter.h"
 
 using namespace clang;
@@ -57,6 +59,18 @@ void PCHGenerator::HandleTranslationUnit(ASTContext &Ctx) {
     }
   }
 
+  const std::string &LayoutProfile = PP.getPreprocessorOpts().PCHLayoutProfile;
+  if (!Module && !LayoutProfile.empty()) {
+    auto ProfileBuffer = PP.getFileManager().getBufferForFile(LayoutProfile);
+    if (!ProfileBuffer) {
+      PP.getDiagnostics().Report(diag::err_cannot_open_file)
+          << LayoutProfile << ProfileBuffer.getError().message();
+      return;
+    }
+    Writer.setHotDecls(
+        DeserializationProfile::readDeclKeys((*ProfileBuffer)->getBuffer()));
+  }
+
   // Emit the PCH file to the Buffer.
   assert(SemaPtr && "No Sema?");
   Buffer->Signature =
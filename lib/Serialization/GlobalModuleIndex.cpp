@@ -19,8 +19,10 @@
 #include "clang/Serialization/Module.h"
 #include "clang/Serialization/PCHContainerOperations.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Bitcode/BitstreamReader.h"
 #include "llvm/Bitcode/BitstreamWriter.h"
 #include "llvm/Support/DJB.h"
@@ -29,11 +31,20 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/OnDiskHashTable.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/TimeProfiler.h"
 #include <cstdio>
 using namespace clang;
 using namespace serialization;
 
+#define DEBUG_TYPE "module-index"
+
+STATISTIC(NumIndexModuleFilesRead,
+          "Number of module files read into the global module index");
+STATISTIC(NumIndexModuleFilesReused,
+          "Number of module files whose global module index entry was reused");
+
 //----------------------------------------------------------------------------//
 // Shared constants
 //----------------------------------------------------------------------------//
@@ -59,7 +70,7 @@ namespace {
 static const char * const IndexFileName = "modules.idx";
 
 /// The global index file version.
-static const unsigned CurrentVersion = 1;
+static const unsigned CurrentVersion = 2;
 
 //----------------------------------------------------------------------------//
 // Global module index reader.
@@ -190,6 +201,8 @@ GlobalModuleIndex::GlobalModuleIndex(std::unique_ptr<llvm::MemoryBuffer> Buffer,
       // global index was built.
       Modules[ID].Size = Record[Idx++];
       Modules[ID].ModTime = Record[Idx++];
+      for (uint32_t &Word : Modules[ID].Signature)
+        Word = Record[Idx++];
 
       // File name.
       unsigned NameLen = Record[Idx++];
@@ -241,8 +254,11 @@ GlobalModuleIndex::readIndex(StringRef Path) {
   IndexPath += Path;
   llvm::sys::path::append(IndexPath, IndexFileName);
 
+  // The index is always mapped rather than copied, so that the compilers
+  // reading it at the same time share its pages.
   llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> BufferOrErr =
-      llvm::MemoryBuffer::getFile(IndexPath.c_str());
+      llvm::MemoryBuffer::getFile(IndexPath.c_str(), /*FileSize=*/-1,
+                                  /*RequiresNullTerminator=*/false);
   if (!BufferOrErr)
     return std::make_pair(nullptr, EC_NotFound);
   std::unique_ptr<llvm::MemoryBuffer> Buffer = std::move(BufferOrErr.get());
@@ -389,6 +405,31 @@ namespace {
         : StoredSize(Size), StoredModTime(ModTime), StoredSignature(Sig) {}
   };
 
+  /// The parts of a module file that go into the index, as read by
+  /// scanModuleFile(). Reading them doesn't use the file manager, so that
+  /// several module files can be scanned concurrently.
+  struct ScannedModuleFile {
+    /// The module file, which the identifiers point into.
+    std::unique_ptr<llvm::MemoryBuffer> Buffer;
+
+    /// Whether the module file could not be read.
+    bool Failed = false;
+
+    struct Import {
+      off_t StoredSize;
+      time_t StoredModTime;
+      ASTFileSignature StoredSignature;
+      std::string FileName;
+    };
+    SmallVector<Import, 4> Imports;
+
+    /// The identifiers of the module file, and whether each of them is
+    /// interesting.
+    std::vector<std::pair<StringRef, bool>> Identifiers;
+
+    ASTFileSignature Signature;
+  };
+
   /// Builder that generates the global module index file.
   class GlobalModuleIndexBuilder {
     FileManager &FileMgr;
@@ -437,10 +478,20 @@ namespace {
         FileManager &FileMgr, const PCHContainerReader &PCHContainerRdr)
         : FileMgr(FileMgr), PCHContainerRdr(PCHContainerRdr) {}
 
-    /// Load the contents of the given module file into the builder.
+    /// Add the contents of the given scanned module file to the builder.
     ///
     /// \returns true if an error occurred, false otherwise.
-    bool loadModuleFile(const FileEntry *File);
+    bool addModuleFile(const FileEntry *File, const ScannedModuleFile &Scanned);
+
+    /// Add a module file whose entry in the previous index is reused.
+    void addReusedModuleFile(const FileEntry *File, ASTFileSignature Signature,
+                             ArrayRef<const FileEntry *> Dependencies);
+
+    /// Add an identifier of the previous index, which is interesting in the
+    /// given reused module files. The identifier is skipped if there are
+    /// none.
+    void addReusedIdentifier(StringRef Name,
+                             ArrayRef<const FileEntry *> InterestingIn);
 
     /// Write the index to the given bitstream.
     /// \returns true if an error occurred, false otherwise.
@@ -511,29 +562,31 @@ namespace {
   };
 }
 
-bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
-  // Open the module file.
-
-  auto Buffer = FileMgr.getBufferForFile(File, /*isVolatile=*/true);
-  if (!Buffer) {
-    return true;
-  }
+/// Read the parts of the module file at \p Path that go into the index.
+static void scanModuleFile(StringRef Path,
+                           const PCHContainerReader &PCHContainerRdr,
+                           ScannedModuleFile &Result) {
+  Result.Failed = true;
+
+  // Open the module file. Module files are replaced rather than modified in
+  // place, so it can be mapped.
+  auto Buffer = llvm::MemoryBuffer::getFile(Path, /*FileSize=*/-1,
+                                            /*RequiresNullTerminator=*/false);
+  if (!Buffer)
+    return;
+  Result.Buffer = std::move(*Buffer);
 
   // Initialize the input stream
-  llvm::BitstreamCursor InStream(PCHContainerRdr.ExtractPCH(**Buffer));
+  llvm::BitstreamCursor InStream(PCHContainerRdr.ExtractPCH(*Result.Buffer));
 
   // Sniff for the signature.
   if (InStream.Read(8) != 'C' ||
       InStream.Read(8) != 'P' ||
       InStream.Read(8) != 'C' ||
       InStream.Read(8) != 'H') {
-    return true;
+    return;
   }
 
-  // Record this module file and assign it a unique ID (if it doesn't have
-  // one already).
-  unsigned ID = getModuleFileInfo(File).ID;
-
   // Search for the blocks and records we care about.
   enum { Other, ControlBlock, ASTBlock, DiagnosticOptionsBlock } State = Other;
   bool Done = false;
@@ -557,7 +610,7 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
     case llvm::BitstreamEntry::SubBlock:
       if (Entry.ID == CONTROL_BLOCK_ID) {
         if (InStream.EnterSubBlock(CONTROL_BLOCK_ID))
-          return true;
+          return;
 
         // Found the control block.
         State = ControlBlock;
@@ -566,7 +619,7 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
 
       if (Entry.ID == AST_BLOCK_ID) {
         if (InStream.EnterSubBlock(AST_BLOCK_ID))
-          return true;
+          return;
 
         // Found the AST block.
         State = ASTBlock;
@@ -575,7 +628,7 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
 
       if (Entry.ID == UNHASHED_CONTROL_BLOCK_ID) {
         if (InStream.EnterSubBlock(UNHASHED_CONTROL_BLOCK_ID))
-          return true;
+          return;
 
         // Found the Diagnostic Options block.
         State = DiagnosticOptionsBlock;
@@ -583,7 +636,7 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
       }
 
       if (InStream.SkipBlock())
-        return true;
+        return;
 
       continue;
 
@@ -603,6 +656,7 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
       unsigned Idx = 0, N = Record.size();
       while (Idx < N) {
         // Read information about the AST file.
+        ScannedModuleFile::Import Import;
 
         // Skip the imported kind
         ++Idx;
@@ -611,12 +665,12 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
         ++Idx;
 
         // Load stored size/modification time.
-        off_t StoredSize = (off_t)Record[Idx++];
-        time_t StoredModTime = (time_t)Record[Idx++];
+        Import.StoredSize = (off_t)Record[Idx++];
+        Import.StoredModTime = (time_t)Record[Idx++];
 
-        // Skip the stored signature.
-        // FIXME: we could read the signature out of the import and validate it.
-        ASTFileSignature StoredSignature = {
+        // Load the stored signature, which is checked once all the module
+        // files are loaded.
+        Import.StoredSignature = {
             {{(uint32_t)Record[Idx++], (uint32_t)Record[Idx++],
               (uint32_t)Record[Idx++], (uint32_t)Record[Idx++],
               (uint32_t)Record[Idx++]}}};
@@ -627,27 +681,11 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
 
         // Retrieve the imported file name.
         unsigned Length = Record[Idx++];
-        SmallString<128> ImportedFile(Record.begin() + Idx,
-                                      Record.begin() + Idx + Length);
+        Import.FileName.assign(Record.begin() + Idx,
+                               Record.begin() + Idx + Length);
         Idx += Length;
 
-        // Find the imported module file.
-        const FileEntry *DependsOnFile
-          = FileMgr.getFile(ImportedFile, /*openFile=*/false,
-                            /*cacheFailure=*/false);
-
-        if (!DependsOnFile)
-          return true;
-
-        // Save the information in ImportedModuleFileInfo so we can verify after
-        // loading all pcms.
-        ImportedModuleFiles.insert(std::make_pair(
-            DependsOnFile, ImportedModuleFileInfo(StoredSize, StoredModTime,
-                                                  StoredSignature)));
-
-        // Record the dependency.
-        unsigned DependsOnID = getModuleFileInfo(DependsOnFile).ID;
-        getModuleFileInfo(File).Dependencies.push_back(DependsOnID);
+        Result.Imports.push_back(std::move(Import));
       }
 
       continue;
@@ -664,27 +702,84 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
               (const unsigned char *)Blob.data()));
       for (InterestingIdentifierTable::data_iterator D = Table->data_begin(),
                                                      DEnd = Table->data_end();
-           D != DEnd; ++D) {
-        std::pair<StringRef, bool> Ident = *D;
-        if (Ident.second)
-          InterestingIdentifiers[Ident.first].push_back(ID);
-        else
-          (void)InterestingIdentifiers[Ident.first];
-      }
+           D != DEnd; ++D)
+        Result.Identifiers.push_back(*D);
     }
 
     // Get Signature.
     if (State == DiagnosticOptionsBlock && Code == SIGNATURE)
-      getModuleFileInfo(File).Signature = {
+      Result.Signature = {
           {{(uint32_t)Record[0], (uint32_t)Record[1], (uint32_t)Record[2],
             (uint32_t)Record[3], (uint32_t)Record[4]}}};
 
     // We don't care about this record.
   }
 
+  Result.Failed = false;
+}
+
+bool GlobalModuleIndexBuilder::addModuleFile(const FileEntry *File,
+                                             const ScannedModuleFile &Scanned) {
+  if (Scanned.Failed)
+    return true;
+
+  // Record this module file and assign it a unique ID (if it doesn't have
+  // one already).
+  unsigned ID = getModuleFileInfo(File).ID;
+
+  for (const ScannedModuleFile::Import &Import : Scanned.Imports) {
+    // Find the imported module file.
+    const FileEntry *DependsOnFile
+      = FileMgr.getFile(Import.FileName, /*openFile=*/false,
+                        /*cacheFailure=*/false);
+
+    if (!DependsOnFile)
+      return true;
+
+    // Save the information in ImportedModuleFileInfo so we can verify after
+    // loading all pcms.
+    ImportedModuleFiles.insert(std::make_pair(
+        DependsOnFile,
+        ImportedModuleFileInfo(Import.StoredSize, Import.StoredModTime,
+                               Import.StoredSignature)));
+
+    // Record the dependency.
+    unsigned DependsOnID = getModuleFileInfo(DependsOnFile).ID;
+    getModuleFileInfo(File).Dependencies.push_back(DependsOnID);
+  }
+
+  for (const std::pair<StringRef, bool> &Ident : Scanned.Identifiers) {
+    if (Ident.second)
+      InterestingIdentifiers[Ident.first].push_back(ID);
+    else
+      (void)InterestingIdentifiers[Ident.first];
+  }
+
+  if (Scanned.Signature)
+    getModuleFileInfo(File).Signature = Scanned.Signature;
+
   return false;
 }
 
+void GlobalModuleIndexBuilder::addReusedModuleFile(
+    const FileEntry *File, ASTFileSignature Signature,
+    ArrayRef<const FileEntry *> Dependencies) {
+  getModuleFileInfo(File).Signature = Signature;
+  for (const FileEntry *DependsOnFile : Dependencies) {
+    unsigned DependsOnID = getModuleFileInfo(DependsOnFile).ID;
+    getModuleFileInfo(File).Dependencies.push_back(DependsOnID);
+  }
+}
+
+void GlobalModuleIndexBuilder::addReusedIdentifier(
+    StringRef Name, ArrayRef<const FileEntry *> InterestingIn) {
+  if (InterestingIn.empty())
+    return;
+  SmallVector<unsigned, 2> &IDs = InterestingIdentifiers[Name];
+  for (const FileEntry *File : InterestingIn)
+    IDs.push_back(getModuleFileInfo(File).ID);
+}
+
 namespace {
 
 /// Trait used to generate the identifier index as an on-disk hash
@@ -769,6 +864,7 @@ bool GlobalModuleIndexBuilder::writeIndex(llvm::BitstreamWriter &Stream) {
     Record.push_back(M->second.ID);
     Record.push_back(M->first->getSize());
     Record.push_back(M->first->getModificationTime());
+    Record.append(M->second.Signature.begin(), M->second.Signature.end());
 
     // File name
     StringRef Name(M->first->getName());
@@ -828,27 +924,11 @@ GlobalModuleIndex::writeIndex(FileManager &FileMgr,
   IndexPath += Path;
   llvm::sys::path::append(IndexPath, IndexFileName);
 
-  // Coordinate building the global index file with other processes that might
-  // try to do the same.
-  llvm::LockFileManager Locked(IndexPath);
-  switch (Locked) {
-  case llvm::LockFileManager::LFS_Error:
-    return EC_IOError;
-
-  case llvm::LockFileManager::LFS_Owned:
-    // We're responsible for building the index ourselves. Do so below.
-    break;
-
-  case llvm::LockFileManager::LFS_Shared:
-    // Someone else is responsible for building the index. We don't care
-    // when they finish, so we're done.
-    return EC_Building;
-  }
-
   // The module index builder.
   GlobalModuleIndexBuilder Builder(FileMgr, PCHContainerRdr);
 
-  // Load each of the module files.
+  // Find the module files.
+  SmallVector<std::pair<std::string, const FileEntry *>, 64> ModuleFiles;
   std::error_code EC;
   for (llvm::sys::fs::directory_iterator D(Path, EC), DEnd;
        D != DEnd && !EC;
@@ -869,10 +949,124 @@ GlobalModuleIndex::writeIndex(FileManager &FileMgr,
     if (!ModuleFile)
       continue;
 
-    // Load this module file.
-    if (Builder.loadModuleFile(ModuleFile))
+    ModuleFiles.push_back(std::make_pair(D->path(), ModuleFile));
+  }
+
+  // Reuse the entries of the previous index for the module files that did not
+  // change since it was written, provided that the module files they import
+  // did not change either.
+  llvm::DenseSet<const FileEntry *> ReusedFiles;
+  std::unique_ptr<GlobalModuleIndex> Previous(readIndex(Path).first);
+  if (Previous && Previous->IdentifierIndex) {
+    llvm::StringMap<unsigned> PreviousIDs;
+    for (unsigned ID = 0, N = Previous->Modules.size(); ID != N; ++ID)
+      if (!Previous->Modules[ID].FileName.empty())
+        PreviousIDs[Previous->Modules[ID].FileName] = ID;
+
+    // The file of each module file of the previous index that can be reused.
+    std::vector<const FileEntry *> FilesByID(Previous->Modules.size());
+    for (const auto &ModuleFile : ModuleFiles) {
+      auto Known = PreviousIDs.find(ModuleFile.second->getName());
+      if (Known == PreviousIDs.end())
+        continue;
+      const ModuleInfo &Info = Previous->Modules[Known->second];
+      if (Info.Size == ModuleFile.second->getSize() &&
+          Info.ModTime == ModuleFile.second->getModificationTime())
+        FilesByID[Known->second] = ModuleFile.second;
+    }
+    bool Changed = true;
+    while (Changed) {
+      Changed = false;
+      for (unsigned ID = 0, N = FilesByID.size(); ID != N; ++ID) {
+        if (!FilesByID[ID])
+          continue;
+        for (unsigned DependsOnID : Previous->Modules[ID].Dependencies) {
+          if (DependsOnID >= N || !FilesByID[DependsOnID]) {
+            FilesByID[ID] = nullptr;
+            Changed = true;
+            break;
+          }
+        }
+      }
+    }
+
+    for (unsigned ID = 0, N = FilesByID.size(); ID != N; ++ID) {
+      if (!FilesByID[ID])
+        continue;
+      SmallVector<const FileEntry *, 4> Dependencies;
+      for (unsigned DependsOnID : Previous->Modules[ID].Dependencies)
+        Dependencies.push_back(FilesByID[DependsOnID]);
+      Builder.addReusedModuleFile(FilesByID[ID],
+                                  Previous->Modules[ID].Signature,
+                                  Dependencies);
+      ReusedFiles.insert(FilesByID[ID]);
+    }
+
+    // The keys and the data of the table are iterated in the same order.
+    IdentifierIndexTable &Table =
+        *static_cast<IdentifierIndexTable *>(Previous->IdentifierIndex);
+    IdentifierIndexTable::key_iterator Key = Table.key_begin();
+    for (IdentifierIndexTable::data_iterator Data = Table.data_begin(),
+                                             DataEnd = Table.data_end();
+         Data != DataEnd; ++Data, ++Key) {
+      SmallVector<const FileEntry *, 2> InterestingIn;
+      for (unsigned ID : *Data)
+        if (ID < FilesByID.size() && FilesByID[ID])
+          InterestingIn.push_back(FilesByID[ID]);
+      Builder.addReusedIdentifier(*Key, InterestingIn);
+    }
+  }
+
+  // Load the other module files, on several threads if there are enough of
+  // them to make it worthwhile.
+  SmallVector<std::pair<std::string, const FileEntry *>, 64> FilesToLoad;
+  for (auto &ModuleFile : ModuleFiles)
+    if (!ReusedFiles.count(ModuleFile.second))
+      FilesToLoad.push_back(std::move(ModuleFile));
+
+  std::vector<ScannedModuleFile> Scanned(FilesToLoad.size());
+  {
+    // Coordinate reading the module files with other processes that might try
+    // to do the same. The index is written to a temporary file which is then
+    // renamed, so writing it doesn't need the lock.
+    llvm::LockFileManager Locked(IndexPath);
+    switch (Locked) {
+    case llvm::LockFileManager::LFS_Error:
       return EC_IOError;
+
+    case llvm::LockFileManager::LFS_Owned:
+      // We're responsible for building the index ourselves. Do so below.
+      break;
+
+    case llvm::LockFileManager::LFS_Shared:
+      // Someone else is responsible for building the index. We don't care
+      // when they finish, so we're done.
+      return EC_Building;
+    }
+
+    const unsigned MinFilesPerThread = 4;
+    unsigned NumThreads = std::min<unsigned>(llvm::hardware_concurrency(),
+                                             FilesToLoad.size() /
+                                                 MinFilesPerThread);
+    if (NumThreads > 1) {
+      llvm::ThreadPool Pool(NumThreads);
+      for (unsigned I = 0, N = FilesToLoad.size(); I != N; ++I)
+        Pool.async([&, I] {
+          scanModuleFile(FilesToLoad[I].first, PCHContainerRdr, Scanned[I]);
+        });
+      Pool.wait();
+    } else {
+      for (unsigned I = 0, N = FilesToLoad.size(); I != N; ++I)
+        scanModuleFile(FilesToLoad[I].first, PCHContainerRdr, Scanned[I]);
+    }
   }
+  NumIndexModuleFilesReused += ReusedFiles.size();
+  NumIndexModuleFilesRead += FilesToLoad.size();
+
+  // Add them in a deterministic order.
+  for (unsigned I = 0, N = FilesToLoad.size(); I != N; ++I)
+    if (Builder.addModuleFile(FilesToLoad[I].second, Scanned[I]))
+      return EC_IOError;
 
   // The output buffer, into which the global index will be written.
   SmallVector<char, 16> OutputBuffer;
@@ -183,9 +183,14 @@ ModuleManager::addModule(StringRef FileName, ModuleKind Type,
       Buf = llvm::MemoryBuffer::getSTDIN();
     } else {
       // Get a buffer of the file and close the file descriptor when done.
+      // The bitstream doesn't need a null terminator, so the file is always
+      // mapped read-only rather than copied: its pages are only read in when
+      // the blocks that live in them are decoded, and they are shared with
+      // the other processes that import the same module.
       Buf = FileMgr.getBufferForFile(NewModule->File,
                                      /*IsVolatile=*/false,
-                                     /*ShouldClose=*/true);
+                                     /*ShouldClose=*/true,
+                                     /*RequiresNullTerminator=*/false);
     }
 
     if (!Buf) {
@@ -35,6 +35,7 @@
 #include "clang/StaticAnalyzer/Frontend/CheckerRegistration.h"
 #include "llvm/ADT/PostOrderIterator.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/Support/DJB.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Program.h"
@@ -203,6 +204,7 @@ public:
         PP(CI.getPreprocessor()), OutDir(outdir), Opts(std::move(opts)),
         Plugins(plugins), Injector(injector), CTU(CI) {
     DigestAnalyzerOptions();
+    CTU.setMaxLoadedASTMemory(uint64_t(Opts->CTUASTMemoryLimit) << 20);
     if (Opts->PrintStats || Opts->ShouldSerializeStats) {
       AnalyzerTimers = llvm::make_unique<llvm::TimerGroup>(
           "analyzer", "Analyzer timers");
@@ -420,6 +422,14 @@ private:
 
   /// Check if we should skip (not analyze) the given function.
   AnalysisMode getModeForDecl(Decl *D, AnalysisMode Mode);
+
+  /// Returns true unless the analysis is split into shards and this process
+  /// analyzes any shard but the first one. The syntax-based and translation
+  /// unit level checks only run in the first shard.
+  bool isFirstShard() const {
+    return Opts->ShardCount <= 1 || Opts->ShardIndex == 0;
+  }
+
   void runAnalysisOnTranslationUnit(ASTContext &C);
 
   /// Print \p S to stderr if \c Opts->AnalyzerDisplayProgress is set.
@@ -557,7 +567,8 @@ static bool isBisonFile(ASTContext &C) {
 void AnalysisConsumer::runAnalysisOnTranslationUnit(ASTContext &C) {
   BugReporter BR(*Mgr);
   TranslationUnitDecl *TU = C.getTranslationUnitDecl();
-  checkerMgr->runCheckersOnASTDecl(TU, *Mgr, BR);
+  if (isFirstShard())
+    checkerMgr->runCheckersOnASTDecl(TU, *Mgr, BR);
 
   // Run the AST-only checks using the order in which functions are defined.
   // If inlining is not turned on, use the simplest function order for path
@@ -582,7 +593,8 @@ void AnalysisConsumer::runAnalysisOnTranslationUnit(ASTContext &C) {
     HandleDeclsCallGraph(LocalTUDeclsSize);
 
   // After all decls handled, run checkers on the entire TranslationUnit.
-  checkerMgr->runCheckersOnEndOfTranslationUnit(TU, *Mgr, BR);
+  if (isFirstShard())
+    checkerMgr->runCheckersOnEndOfTranslationUnit(TU, *Mgr, BR);
 
   RecVisitorBR = nullptr;
 }
@@ -697,6 +709,19 @@ AnalysisConsumer::getModeForDecl(Decl *D, AnalysisMode Mode) {
       getFunctionName(D) != Opts->AnalyzeSpecificFunction)
     return AM_None;
 
+  // When the analysis is split into shards, every function is analyzed
+  // path-sensitively by exactly one of them. The shard is picked from the
+  // name of the function, so that it doesn't depend on the order in which
+  // the functions are visited.
+  if (Opts->ShardCount > 1) {
+    if (!isFirstShard())
+      Mode &= ~AM_Syntax;
+    if ((Mode & AM_Path) &&
+        llvm::djbHash(getFunctionName(D)) % Opts->ShardCount !=
+            Opts->ShardIndex)
+      Mode &= ~AM_Path;
+  }
+
   // Unless -analyze-all is specified, treat decls differently depending on
   // where they came from:
   // - Main source file: run both path-sensitive and non-path-sensitive checks.
@@ -792,8 +817,26 @@ ento::CreateAnalysisConsumer(CompilerInstance &CI) {
   AnalyzerOptionsRef analyzerOpts = CI.getAnalyzerOpts();
   bool hasModelPath = analyzerOpts->Config.count("model-path") > 0;
 
+  // When the analysis is split into shards, the shards must not overwrite each
+  // other's reports. The HTML reports get unique names within their directory,
+  // but the plist and SARIF output files get the shard index as a suffix, and
+  // are merged by utils/analyzer/MergeShards.py.
+  std::string OutputFile = CI.getFrontendOpts().OutputFile;
+  if (analyzerOpts->ShardCount > 1 && !OutputFile.empty()) {
+    switch (analyzerOpts->AnalysisDiagOpt) {
+    case PD_PLIST:
+    case PD_PLIST_MULTI_FILE:
+    case PD_PLIST_HTML:
+    case PD_SARIF:
+      OutputFile += ".shard" + std::to_string(analyzerOpts->ShardIndex);
+      break;
+    default:
+      break;
+    }
+  }
+
   return llvm::make_unique<AnalysisConsumer>(
-      CI, CI.getFrontendOpts().OutputFile, analyzerOpts,
+      CI, OutputFile, analyzerOpts,
       CI.getFrontendOpts().Plugins,
       hasModelPath ? new ModelInjector(CI) : nullptr);
 }
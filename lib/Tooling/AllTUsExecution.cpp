@@ -7,7 +7,9 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/Tooling/AllTUsExecution.h"
+#include "clang/Tooling/DependencyScanning/DependencyScanningFilesystem.h"
 #include "clang/Tooling/ToolExecutorPluginRegistry.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/VirtualFileSystem.h"
 
@@ -59,6 +61,14 @@ llvm::cl::opt<std::string>
                           "This flag only applies to all-TUs."),
            llvm::cl::init(".*"));
 
+llvm::cl::opt<bool> ShareFileContents(
+    "execute-share-file-contents",
+    llvm::cl::desc("Share the status and contents of the headers that are read "
+                   "between the threads, so that headers used by many files "
+                   "are only read from disk once. This flag only applies to "
+                   "all-TUs."),
+    llvm::cl::init(false));
+
 AllTUsToolExecutor::AllTUsToolExecutor(
     const CompilationDatabase &Compilations, unsigned ThreadCount,
     std::shared_ptr<PCHContainerOperations> PCHContainerOps)
@@ -112,6 +122,12 @@ llvm::Error AllTUsToolExecutor::execute(
 
   auto &Action = Actions.front();
 
+  // Outlives the thread pool, as all threads read files through it.
+  llvm::Optional<dependencies::DependencyScanningFilesystemSharedCache>
+      SharedCache;
+  if (ShareFileContents)
+    SharedCache.emplace();
+
   {
     llvm::ThreadPool Pool(ThreadCount == 0 ? llvm::hardware_concurrency()
                                            : ThreadCount);
@@ -124,6 +140,26 @@ llvm::Error AllTUsToolExecutor::execute(
             // concurrent working directories.
             IntrusiveRefCntPtr<llvm::vfs::FileSystem> FS =
                 llvm::vfs::createPhysicalFileSystem().release();
+            if (WrapFileSystem)
+              FS = WrapFileSystem(std::move(FS));
+            if (SharedCache) {
+              auto *SharedFS =
+                  new dependencies::DependencyScanningWorkerFilesystem(
+                      *SharedCache, std::move(FS), /*MinimizeSources=*/false);
+              // Only this thread reads the main file, so it isn't worth
+              // keeping in memory for the rest of the run.
+              for (const CompileCommand &Cmd :
+                   Compilations.getCompileCommands(Path)) {
+                SmallString<256> MainFile;
+                if (llvm::sys::path::is_absolute(Cmd.Filename))
+                  MainFile = Cmd.Filename;
+                else
+                  llvm::sys::path::append(MainFile, Cmd.Directory,
+                                          Cmd.Filename);
+                SharedFS->ignoreFile(MainFile);
+              }
+              FS = SharedFS;
+            }
             ClangTool Tool(Compilations, {Path},
                            std::make_shared<PCHContainerOperations>(), FS);
             Tool.appendArgumentsAdjuster(Action.second);
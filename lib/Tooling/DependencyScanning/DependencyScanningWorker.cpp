@@ -0,0 +1,157 @@
+//===- DependencyScanningWorker.cpp - clang-scan-deps worker --------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Tooling/DependencyScanning/DependencyScanningWorker.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/FrontendActions.h"
+#include "clang/Frontend/TextDiagnosticPrinter.h"
+#include "clang/Frontend/Utils.h"
+#include "clang/Tooling/Tooling.h"
+#include "llvm/Support/Path.h"
+
+using namespace clang;
+using namespace tooling;
+using namespace dependencies;
+
+namespace {
+
+/// Prints out all of the gathered dependencies into a string.
+class DependencyPrinter : public DependencyCollector {
+public:
+  DependencyPrinter(std::unique_ptr<DependencyOutputOptions> Opts,
+                    std::string &S)
+      : Opts(std::move(Opts)), S(S) {}
+
+  void finishedMainFile() override {
+    llvm::raw_string_ostream OS(S);
+    // Targets are already quoted as needed.
+    for (unsigned I = 0, E = Opts->Targets.size(); I != E; ++I)
+      OS << (I ? " " : "") << Opts->Targets[I];
+    OS << ':';
+    for (StringRef File : getDependencies()) {
+      OS << " \\\n  ";
+      printFilename(OS, File);
+    }
+    OS << '\n';
+  }
+
+  bool needSystemDependencies() override {
+    return Opts->IncludeSystemHeaders;
+  }
+
+private:
+  /// Escape the characters that are special to make.
+  static void printFilename(raw_ostream &OS, StringRef Filename) {
+    for (unsigned I = 0, E = Filename.size(); I != E; ++I) {
+      if (Filename[I] == '#' || Filename[I] == ' ')
+        OS << '\\';
+      else if (Filename[I] == '$')
+        OS << '$';
+      OS << Filename[I];
+    }
+  }
+
+  std::unique_ptr<DependencyOutputOptions> Opts;
+  std::string &S;
+};
+
+/// A clang tool that runs the preprocessor in a mode that's optimized for
+/// dependency scanning for the given compiler invocation.
+class DependencyScanningAction : public tooling::ToolAction {
+public:
+  DependencyScanningAction(std::string &DependencyFileContents)
+      : DependencyFileContents(DependencyFileContents) {}
+
+  bool runInvocation(std::shared_ptr<CompilerInvocation> Invocation,
+                     FileManager *FileMgr,
+                     std::shared_ptr<PCHContainerOperations> PCHContainerOps,
+                     DiagnosticConsumer *DiagConsumer) override {
+    // Create a compiler instance to handle the actual work.
+    CompilerInstance Compiler(std::move(PCHContainerOps));
+    Compiler.setInvocation(std::move(Invocation));
+    Compiler.setFileManager(FileMgr);
+
+    // Don't print 'X warnings and Y errors generated'.
+    Compiler.getDiagnosticOpts().ShowCarets = false;
+    // Create the compiler's actual diagnostics engine.
+    Compiler.createDiagnostics(DiagConsumer, /*ShouldOwnClient=*/false);
+    if (!Compiler.hasDiagnostics())
+      return false;
+
+    Compiler.createSourceManager(*FileMgr);
+
+    // Create the dependency collector that will collect the produced
+    // dependencies.
+    //
+    // This also moves the existing dependency output options from the
+    // invocation to the collector. The options in the invocation are reset,
+    // which ensures that the compiler won't create new dependency collectors,
+    // and thus won't write out the extra '.d' files to disk.
+    auto Opts = llvm::make_unique<DependencyOutputOptions>(
+        std::move(Compiler.getInvocation().getDependencyOutputOpts()));
+    Compiler.getInvocation().getDependencyOutputOpts() =
+        DependencyOutputOptions();
+    // Name the target after the object file when the command line doesn't.
+    if (Opts->Targets.empty() && !Compiler.getFrontendOpts().Inputs.empty()) {
+      StringRef Input = Compiler.getFrontendOpts().Inputs[0].getFile();
+      Opts->Targets.push_back((llvm::sys::path::stem(Input) + ".o").str());
+    }
+    Compiler.addDependencyCollector(std::make_shared<DependencyPrinter>(
+        std::move(Opts), DependencyFileContents));
+
+    auto Action = llvm::make_unique<PreprocessOnlyAction>();
+    const bool Result = Compiler.ExecuteAction(*Action);
+    FileMgr->clearStatCache();
+    return Result;
+  }
+
+private:
+  std::string &DependencyFileContents;
+};
+
+} // end anonymous namespace
+
+DependencyScanningWorker::DependencyScanningWorker(
+    DependencyScanningService &Service) {
+  DiagOpts = new DiagnosticOptions();
+  PCHContainerOps = std::make_shared<PCHContainerOperations>();
+  // Each worker gets its own physical file system, so that the workers can
+  // use different working directories concurrently.
+  RealFS = llvm::vfs::createPhysicalFileSystem().release();
+  if (Service.getMode() == ScanningMode::MinimizedSourcePreprocessing)
+    DepFS = new DependencyScanningWorkerFilesystem(Service.getSharedCache(),
+                                                   RealFS);
+}
+
+llvm::Expected<std::string> DependencyScanningWorker::getDependencyFile(
+    const std::vector<std::string> &CommandLine, StringRef WorkingDirectory) {
+  // Capture the emitted diagnostics and report them to the client
+  // in the case of a failure.
+  std::string DiagnosticOutput;
+  llvm::raw_string_ostream DiagnosticsOS(DiagnosticOutput);
+  TextDiagnosticPrinter DiagPrinter(DiagnosticsOS, DiagOpts.get());
+
+  if (std::error_code EC = RealFS->setCurrentWorkingDirectory(WorkingDirectory))
+    return llvm::errorCodeToError(EC);
+
+  llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FS = RealFS;
+  if (DepFS)
+    FS = DepFS;
+  llvm::IntrusiveRefCntPtr<FileManager> Files(
+      new FileManager(FileSystemOptions(), FS));
+
+  std::string Output;
+  DependencyScanningAction Action(Output);
+  ToolInvocation Invocation(CommandLine, &Action, Files.get(),
+                            PCHContainerOps);
+  Invocation.setDiagnosticConsumer(&DiagPrinter);
+  if (!Invocation.run())
+    return llvm::make_error<llvm::StringError>(DiagnosticsOS.str(),
+                                               llvm::inconvertibleErrorCode());
+  return Output;
+}
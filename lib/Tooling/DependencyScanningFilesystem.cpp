@@ -0,0 +1,226 @@
+//===- DependencyScanningFilesystem.cpp - clang-scan-deps fs --------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Tooling/DependencyScanning/DependencyScanningFilesystem.h"
+#include "clang/Lex/DependencyDirectivesSourceMinimizer.h"
+#include "llvm/Support/Errc.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Threading.h"
+#include <algorithm>
+
+using namespace clang;
+using namespace tooling;
+using namespace dependencies;
+
+CachedFileSystemEntry
+CachedFileSystemEntry::createFileEntry(StringRef Filename,
+                                       llvm::vfs::FileSystem &FS,
+                                       bool Minimize) {
+  // Load the file and its content from the file system.
+  llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>> MaybeFile =
+      FS.openFileForRead(Filename);
+  if (!MaybeFile)
+    return MaybeFile.getError();
+  llvm::ErrorOr<llvm::vfs::Status> Stat = (*MaybeFile)->status();
+  if (!Stat)
+    return Stat.getError();
+
+  llvm::vfs::File &F = **MaybeFile;
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> MaybeBuffer =
+      F.getBuffer(Stat->getName());
+  if (!MaybeBuffer)
+    return MaybeBuffer.getError();
+  StringRef Buffer = (*MaybeBuffer)->getBuffer();
+
+  llvm::SmallString<1024> MinimizedFileContents;
+  llvm::SmallVector<minimize_source_to_dependency_directives::Token, 64> Tokens;
+  // Fall back to the original contents when the minimizer fails, and let the
+  // preprocessor diagnose the problem.
+  if (!Minimize ||
+      minimizeSourceToDependencyDirectives(Buffer, MinimizedFileContents,
+                                           Tokens))
+    MinimizedFileContents.assign(Buffer.begin(), Buffer.end());
+
+  CachedFileSystemEntry Result;
+  size_t Size = MinimizedFileContents.size();
+  Result.MaybeStat = llvm::vfs::Status(Stat->getName(), Stat->getUniqueID(),
+                                       Stat->getLastModificationTime(),
+                                       Stat->getUser(), Stat->getGroup(), Size,
+                                       Stat->getType(), Stat->getPermissions());
+  // The contents produced by the minimizer must be null terminated.
+  MinimizedFileContents.push_back('\0');
+  Result.Contents = std::move(MinimizedFileContents);
+  // Now make the null terminator implicit again, so that Clang's lexer can find
+  // it right where the buffer ends.
+  Result.Contents.pop_back();
+  return Result;
+}
+
+CachedFileSystemEntry
+CachedFileSystemEntry::createDirectoryEntry(llvm::vfs::Status &&Stat) {
+  assert(Stat.isDirectory() && "not a directory!");
+  auto Result = CachedFileSystemEntry();
+  Result.MaybeStat = std::move(Stat);
+  return Result;
+}
+
+DependencyScanningFilesystemSharedCache::
+    DependencyScanningFilesystemSharedCache() {
+  // Shard the cache to reduce the lock contention between the workers; the
+  // per-entry locks already serialize the expensive file system accesses, so
+  // the shard locks only need to cover the map lookups.
+  NumShards = std::max(2u, llvm::hardware_concurrency() / 4);
+  CacheShards = llvm::make_unique<CacheShard[]>(NumShards);
+}
+
+DependencyScanningFilesystemSharedCache::SharedFileSystemEntry &
+DependencyScanningFilesystemSharedCache::get(StringRef Key) {
+  CacheShard &Shard = CacheShards[llvm::hash_value(Key) % NumShards];
+  std::unique_lock<std::mutex> LockGuard(Shard.CacheLock);
+  auto It = Shard.Cache.try_emplace(Key);
+  return It.first->getValue();
+}
+
+/// Module maps are parsed by the preprocessor as is, and header maps, AST files
+/// and virtual file system overlays are not sources at all, so only the
+/// remaining files are worth minimizing.
+static bool shouldMinimize(StringRef Filename) {
+  StringRef Name = llvm::sys::path::filename(Filename);
+  if (Name == "module.modulemap" || Name == "module.private.modulemap" ||
+      Name == "module.map" || Name == "module_private.map")
+    return false;
+  StringRef Ext = llvm::sys::path::extension(Filename);
+  return !Ext.equals_lower(".modulemap") && !Ext.equals_lower(".hmap") &&
+         !Ext.equals_lower(".pch") && !Ext.equals_lower(".pcm") &&
+         !Ext.equals_lower(".yaml") && !Ext.equals_lower(".json");
+}
+
+void DependencyScanningWorkerFilesystem::ignoreFile(StringRef Filename) {
+  SmallString<256> Path(Filename);
+  if (!makeAbsolute(Path)) {
+    llvm::sys::path::remove_dots(Path, /*remove_dot_dot=*/false);
+    IgnoredFiles.insert(Path);
+  }
+}
+
+llvm::ErrorOr<const CachedFileSystemEntry *>
+DependencyScanningWorkerFilesystem::getOrCreateFileSystemEntry(
+    const Twine &Path) {
+  // Key the caches on absolute paths, as the working directory changes between
+  // the compilations that share them.
+  SmallString<256> Filename;
+  Path.toVector(Filename);
+  if (std::error_code EC = makeAbsolute(Filename))
+    return EC;
+  llvm::sys::path::remove_dots(Filename, /*remove_dot_dot=*/false);
+
+  if (IgnoredFiles.count(Filename))
+    return nullptr;
+
+  auto It = Cache.find(Filename);
+  if (It != Cache.end())
+    return It->second;
+
+  DependencyScanningFilesystemSharedCache::SharedFileSystemEntry
+      &SharedCacheEntry = SharedCache.get(Filename);
+  const CachedFileSystemEntry *Result;
+  {
+    std::unique_lock<std::mutex> LockGuard(SharedCacheEntry.ValueLock);
+    CachedFileSystemEntry &CacheEntry = SharedCacheEntry.Value;
+
+    if (!CacheEntry.isValid()) {
+      llvm::vfs::FileSystem &FS = getUnderlyingFS();
+      auto MaybeStatus = FS.status(Filename);
+      if (!MaybeStatus)
+        CacheEntry = CachedFileSystemEntry(MaybeStatus.getError());
+      else if (MaybeStatus->isDirectory())
+        CacheEntry = CachedFileSystemEntry::createDirectoryEntry(
+            std::move(*MaybeStatus));
+      else
+        CacheEntry = CachedFileSystemEntry::createFileEntry(
+            Filename, FS, MinimizeSources && shouldMinimize(Filename));
+    }
+
+    Result = &CacheEntry;
+  }
+
+  // Store the result in the local cache.
+  Cache[Filename] = Result;
+  return Result;
+}
+
+llvm::ErrorOr<llvm::vfs::Status>
+DependencyScanningWorkerFilesystem::status(const Twine &Path) {
+  llvm::ErrorOr<const CachedFileSystemEntry *> Result =
+      getOrCreateFileSystemEntry(Path);
+  if (!Result)
+    return Result.getError();
+  if (!*Result)
+    return getUnderlyingFS().status(Path);
+  llvm::ErrorOr<llvm::vfs::Status> Stat = (*Result)->getStatus();
+  if (!Stat)
+    return Stat.getError();
+  // Report the status under the name it was requested with, like the
+  // underlying file system would.
+  return llvm::vfs::Status::copyWithNewName(*Stat, Path.str());
+}
+
+namespace {
+
+/// The VFS that is used by clang consumes the \c CachedFileSystemEntry using
+/// this subclass.
+class MinimizedVFSFile final : public llvm::vfs::File {
+public:
+  MinimizedVFSFile(std::unique_ptr<llvm::MemoryBuffer> Buffer,
+                   llvm::vfs::Status Stat)
+      : Buffer(std::move(Buffer)), Stat(std::move(Stat)) {}
+
+  llvm::ErrorOr<llvm::vfs::Status> status() override { return Stat; }
+
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
+  getBuffer(const Twine &Name, int64_t FileSize, bool RequiresNullTerminator,
+            bool IsVolatile) override {
+    return std::move(Buffer);
+  }
+
+  std::error_code close() override { return {}; }
+
+private:
+  std::unique_ptr<llvm::MemoryBuffer> Buffer;
+  llvm::vfs::Status Stat;
+};
+
+} // end anonymous namespace
+
+llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>>
+DependencyScanningWorkerFilesystem::openFileForRead(const Twine &Path) {
+  llvm::ErrorOr<const CachedFileSystemEntry *> Result =
+      getOrCreateFileSystemEntry(Path);
+  if (!Result)
+    return Result.getError();
+  if (!*Result)
+    return getUnderlyingFS().openFileForRead(Path);
+
+  const CachedFileSystemEntry *Entry = *Result;
+  if (Entry->isDirectory())
+    return llvm::errc::is_a_directory;
+
+  llvm::ErrorOr<StringRef> Contents = Entry->getContents();
+  if (!Contents)
+    return Contents.getError();
+  llvm::ErrorOr<llvm::vfs::Status> Stat = Entry->getStatus();
+  if (!Stat)
+    return Stat.getError();
+
+  std::string Name = Path.str();
+  return llvm::make_unique<MinimizedVFSFile>(
+      llvm::MemoryBuffer::getMemBuffer(*Contents, Name,
+                                       /*RequiresNullTerminator=*/true),
+      llvm::vfs::Status::copyWithNewName(*Stat, Name));
+}
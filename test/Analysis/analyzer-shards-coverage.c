@@ -0,0 +1,68 @@
+// RUN: rm -rf %t && mkdir %t
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-display-progress \
+// RUN:   %s 2> %t/all.txt
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-display-progress \
+// RUN:   -analyzer-config shard-count=3,shard-index=0 %s 2> %t/shard0.txt
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-display-progress \
+// RUN:   -analyzer-config shard-count=3,shard-index=1 %s 2> %t/shard1.txt
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-display-progress \
+// RUN:   -analyzer-config shard-count=3,shard-index=2 %s 2> %t/shard2.txt
+
+// Together, the shards analyze every function exactly as often as the analysis
+// that isn't split into shards, and every shard analyzes some of them.
+// RUN: grep "^ANALYZE" %t/all.txt | sort > %t/all.sorted
+// RUN: cat %t/shard0.txt %t/shard1.txt %t/shard2.txt | grep "^ANALYZE" \
+// RUN:   | sort > %t/shards.sorted
+// RUN: diff %t/all.sorted %t/shards.sorted
+// RUN: FileCheck --check-prefix=SHARD0 --input-file=%t/shard0.txt %s
+// RUN: FileCheck --check-prefix=SHARD1 --input-file=%t/shard1.txt %s
+// RUN: FileCheck --check-prefix=SHARD2 --input-file=%t/shard2.txt %s
+
+// SHARD0-DAG: ANALYZE (Path,  Inline_Regular): {{.*}} f0
+// SHARD0-DAG: ANALYZE (Path,  Inline_Regular): {{.*}} f3
+// SHARD0-DAG: ANALYZE (Syntax): {{.*}} f1
+// SHARD1-DAG: ANALYZE (Path,  Inline_Regular): {{.*}} f1
+// SHARD1-DAG: ANALYZE (Path,  Inline_Regular): {{.*}} f4
+// SHARD2-DAG: ANALYZE (Path,  Inline_Regular): {{.*}} f2
+// SHARD2-DAG: ANALYZE (Path,  Inline_Regular): {{.*}} f5
+
+// The shards write their plist output to files of their own, which
+// MergeShards.py merges into one report.
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-output=plist \
+// RUN:   -analyzer-config shard-count=3,shard-index=0 %s -o %t/out.plist
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-output=plist \
+// RUN:   -analyzer-config shard-count=3,shard-index=1 %s -o %t/out.plist
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-output=plist \
+// RUN:   -analyzer-config shard-count=3,shard-index=2 %s -o %t/out.plist
+// RUN: not ls %t/out.plist
+// RUN: %merge_analyzer_shards %t/out.plist %t/out.plist.shard0 \
+// RUN:   %t/out.plist.shard1 %t/out.plist.shard2
+// RUN: FileCheck --check-prefix=PLIST --input-file=%t/out.plist %s
+
+// PLIST-COUNT-3: <string>core.NullDereference</string>
+// PLIST-NOT: core.NullDereference
+// PLIST: <key>files</key>
+// PLIST-NEXT: <array>
+// PLIST-NEXT: <string>{{.*}}analyzer-shards-coverage.c</string>
+// PLIST-NEXT: </array>
+
+void f0(int *p) {
+  p = 0;
+  *p = 1;
+}
+
+void f1(int *p) {
+  p = 0;
+  *p = 1;
+}
+
+void f2(int *p) {
+  p = 0;
+  *p = 1;
+}
+
+int f3(int x) { return x + 3; }
+
+int f4(int x) { return x * 4; }
+
+int f5(int x) { return x - 5; }
@@ -0,0 +1,46 @@
+// A bug in a function that is inlined into functions of different shards is
+// found by each of those shards, but reported once, as without shards.
+//
+// RUN: rm -rf %t && mkdir %t
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-output=plist \
+// RUN:   %s -o %t/all.plist
+// RUN: FileCheck --check-prefix=PLIST --input-file=%t/all.plist %s
+//
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-output=plist \
+// RUN:   -analyzer-config shard-count=2,shard-index=0 %s -o %t/out.plist
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-output=plist \
+// RUN:   -analyzer-config shard-count=2,shard-index=1 %s -o %t/out.plist
+// RUN: FileCheck --check-prefix=PLIST --input-file=%t/out.plist.shard0 %s
+// RUN: FileCheck --check-prefix=PLIST --input-file=%t/out.plist.shard1 %s
+// RUN: %merge_analyzer_shards %t/out.plist %t/out.plist.shard0 \
+// RUN:   %t/out.plist.shard1
+// RUN: FileCheck --check-prefix=PLIST --input-file=%t/out.plist %s
+//
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-output=sarif \
+// RUN:   -analyzer-config shard-count=2,shard-index=0 %s -o %t/out.sarif
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-output=sarif \
+// RUN:   -analyzer-config shard-count=2,shard-index=1 %s -o %t/out.sarif
+// RUN: FileCheck --check-prefix=SARIF --input-file=%t/out.sarif.shard0 %s
+// RUN: FileCheck --check-prefix=SARIF --input-file=%t/out.sarif.shard1 %s
+// RUN: %merge_analyzer_shards %t/out.sarif %t/out.sarif.shard0 \
+// RUN:   %t/out.sarif.shard1
+// RUN: FileCheck --check-prefix=SARIF --input-file=%t/out.sarif %s
+
+// PLIST-COUNT-1: <string>core.NullDereference</string>
+// PLIST-NOT: core.NullDereference
+
+// SARIF-COUNT-1: "ruleId": "core.NullDereference"
+// SARIF-NOT: "ruleId": "core.NullDereference"
+
+static void store(int *p) {
+  *p = 1;
+}
+
+// f0 is analyzed by shard 1 and f1 by shard 0.
+void f0() {
+  store(0);
+}
+
+void f1() {
+  store(0);
+}
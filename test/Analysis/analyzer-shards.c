@@ -0,0 +1,20 @@
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,deadcode.DeadStores \
+// RUN:   -verify=shard0,shard1 %s
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,deadcode.DeadStores \
+// RUN:   -analyzer-config shard-count=2,shard-index=0 -verify=shard0 %s
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,deadcode.DeadStores \
+// RUN:   -analyzer-config shard-count=2,shard-index=1 -verify=shard1 %s
+
+// Every function is analyzed path-sensitively in exactly one shard, while the
+// syntax-based checks, like the dead stores checker, run in the first shard.
+
+void third(int *p) {
+  p = 0;
+  *p = 1; // shard0-warning{{Dereference of null pointer}}
+}
+
+void fourth(int *p) {
+  int x = 0; // shard0-warning{{Value stored to 'x' during its initialization is never read}}
+  p = 0;
+  *p = 1; // shard1-warning{{Dereference of null pointer}}
+}
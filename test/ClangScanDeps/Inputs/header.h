@@ -0,0 +1,8 @@
+#ifdef INCLUDE_HEADER2
+#include "header2.h"
+#endif
+
+// A raw string that mentions #include "missing.h" is never a dependency.
+const char *Doc = R"(
+#include "missing.h"
+)";
@@ -0,0 +1,29 @@
+// RUN: rm -rf %t.dir
+// RUN: rm -rf %t.cdb
+// RUN: mkdir -p %t.dir
+// RUN: cp %s %t.dir/regular_cdb.cpp
+// RUN: mkdir %t.dir/Inputs
+// RUN: cp %S/Inputs/header.h %t.dir/Inputs/header.h
+// RUN: cp %S/Inputs/header2.h %t.dir/Inputs/header2.h
+// RUN: sed -e "s|DIR|%/t.dir|g" %S/Inputs/regular_cdb.json > %t.cdb
+//
+// RUN: clang-scan-deps -compilation-database %t.cdb -j 1 | \
+// RUN:   FileCheck --check-prefixes=CHECK1,CHECK2 %s
+// RUN: clang-scan-deps -compilation-database %t.cdb -j 2 \
+// RUN:   -mode=preprocess | FileCheck --check-prefixes=CHECK1,CHECK2 %s
+//
+// The scanner doesn't write the dependency file requested by the command.
+// RUN: not ls %t.dir/regular_cdb.d
+
+#include "header.h"
+
+// CHECK1: regular_cdb.o:
+// CHECK1-NEXT: regular_cdb.cpp
+// CHECK1-NEXT: Inputs{{/|\\}}header.h
+// CHECK1-NEXT: Inputs{{/|\\}}header2.h
+// CHECK1-NOT: missing.h
+
+// CHECK2: regular_cdb.o:
+// CHECK2-NEXT: regular_cdb.cpp
+// CHECK2-NEXT: Inputs{{/|\\}}header.h
+// CHECK2-NOT: header2.h
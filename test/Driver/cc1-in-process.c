@@ -0,0 +1,18 @@
+// RUN: %clang -fintegrated-cc1 -### -c %s 2>&1 | FileCheck %s
+// CHECK: (in-process)
+// CHECK-NEXT: "-cc1"
+
+// RUN: %clang -fintegrated-cc1 -fno-integrated-cc1 -### -c %s 2>&1 \
+// RUN:   | FileCheck --check-prefix=NO-IN-PROCESS %s
+// RUN: %clang -### -c %s 2>&1 | FileCheck --check-prefix=NO-IN-PROCESS %s
+// NO-IN-PROCESS-NOT: (in-process)
+
+// Only a single cc1 job runs inside the driver.
+// RUN: %clang -fintegrated-cc1 -### -fsyntax-only %s %s 2>&1 \
+// RUN:   | FileCheck --check-prefix=NO-IN-PROCESS %s
+
+// RUN: %clang -fintegrated-cc1 -fsyntax-only %s 2>&1 \
+// RUN:   | FileCheck --check-prefix=EXEC %s
+// EXEC: warning: in-process cc1
+
+#warning in-process cc1
@@ -0,0 +1,41 @@
+// A fatal error or a crash in a cc1 job running inside the driver process only
+// stops that job, and the driver still generates the crash diagnostics.
+// RUN: rm -rf %t
+// RUN: mkdir %t
+// RUN: env TMPDIR=%t TEMP=%t TMP=%t \
+// RUN:   not %clang -fintegrated-cc1 -target x86_64-unknown-linux-gnu -O2 \
+// RUN:   -fomit-frame-pointer -DFATAL -c %s -o %t.o 2>&1 \
+// RUN:   | FileCheck --check-prefix=FATAL %s
+// RUN: cat %t/crash-report-in-process-*.c | FileCheck --check-prefix=CHECKSRC %s
+// RUN: cat %t/crash-report-in-process-*.sh | FileCheck --check-prefix=CHECKSH %s
+
+// RUN: rm -rf %t
+// RUN: mkdir %t
+// RUN: env TMPDIR=%t TEMP=%t TMP=%t \
+// RUN:   not %clang -fintegrated-cc1 -fsyntax-only -DCRASH %s 2>&1 \
+// RUN:   | FileCheck --check-prefix=CRASH %s
+// REQUIRES: crash-recovery, x86-registered-target
+
+#ifdef FATAL
+// The backend can't read the frame pointer of a function that has none.
+register unsigned long frame asm("rbp");
+unsigned long read_frame(void) { return frame; }
+#endif
+
+#ifdef CRASH
+#pragma clang __debug parser_crash
+#endif
+
+// FATAL: error in backend: register rbp is allocatable
+// FATAL: clang: error: clang frontend command failed with exit code 70
+// FATAL: Preprocessed source(s) and associated run script(s) are located at:
+// FATAL-NEXT: note: diagnostic msg: {{.*}}crash-report-in-process-{{.*}}.c
+
+// CRASH: clang: error: clang frontend command failed due to signal
+// CRASH: Preprocessed source(s) and associated run script(s) are located at:
+// CRASH-NEXT: note: diagnostic msg: {{.*}}crash-report-in-process-{{.*}}.c
+
+// CHECKSRC: unsigned long read_frame(void)
+// CHECKSH: # Crash reproducer
+// CHECKSH: "-cc1"
+// CHECKSH: "-D" "FATAL"
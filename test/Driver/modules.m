@@ -24,6 +24,11 @@
 // MODULES_VALIDATE_ONCE_FILE: -fbuild-session-timestamp=128
 // MODULES_VALIDATE_ONCE_FILE: -fmodules-validate-once-per-build-session
 
+// RUN: %clang -fbuild-session-timestamp=123 -fmodules-validate-once-per-build-session -fmodules-validate-signature-once-per-build-session -fmodules-validation-threads=8 -### %s 2>&1 | FileCheck -check-prefix=MODULES_VALIDATE_SIGNATURE %s
+// MODULES_VALIDATE_SIGNATURE: -fmodules-validation-threads=8
+// MODULES_VALIDATE_SIGNATURE: -fmodules-validate-once-per-build-session
+// MODULES_VALIDATE_SIGNATURE: -fmodules-validate-signature-once-per-build-session
+
 // RUN: %clang -fmodules-validate-once-per-build-session -### %s 2>&1 | FileCheck -check-prefix=MODULES_VALIDATE_ONCE_ERR %s
 // MODULES_VALIDATE_ONCE_ERR: option '-fmodules-validate-once-per-build-session' requires '-fbuild-session-timestamp=<seconds since Epoch>' or '-fbuild-session-file=<file>'
 
@@ -0,0 +1,28 @@
+// The output of jobs run concurrently is printed in job order and does not
+// interleave.
+// RUN: %clang -fparallel-jobs=4 -fsyntax-only %s %S/Inputs/parallel-jobs-b.c 2>&1 \
+// RUN:   | FileCheck %s
+// CHECK: parallel-jobs.c:{{[0-9]+}}:2: warning: first input
+// CHECK-NEXT: #warning first input
+// CHECK: parallel-jobs-b.c:1:2: warning: second input
+// CHECK-NEXT: #warning second input
+
+// A failing job does not prevent the independent jobs from running.
+// RUN: not %clang -fparallel-jobs=2 -fsyntax-only -DFAIL %s \
+// RUN:   %S/Inputs/parallel-jobs-b.c 2>&1 | FileCheck --check-prefix=FAIL %s
+// FAIL: parallel-jobs.c:{{[0-9]+}}:2: error: failing input
+// FAIL: parallel-jobs-b.c:1:2: warning: second input
+
+// RUN: not %clang -fparallel-jobs=foo -fsyntax-only %s 2>&1 \
+// RUN:   | FileCheck --check-prefix=INVALID %s
+// INVALID: error: invalid integral value 'foo' in '-fparallel-jobs=foo'
+
+// RUN: %clang -fparallel-jobs=0 -### -c %s 2>&1 \
+// RUN:   | FileCheck --check-prefix=UNUSED %s
+// UNUSED-NOT: argument unused
+
+#ifdef FAIL
+#error failing input
+#else
+#warning first input
+#endif
@@ -0,0 +1,42 @@
+// RUN: %clang_cc1 -std=c++14 -triple x86_64-unknown-linux-gnu -emit-llvm -ftime-trace -mllvm -time-trace-granularity=0 -o %t.ll %s
+// RUN: %python -c 'import json, sys; sys.stdout.writelines(e["name"] + " " + e["args"].get("detail", "") + "\n" for e in json.load(open(sys.argv[1]))["traceEvents"] if e["ph"] == "X")' %t.json \
+// RUN:   | FileCheck %s
+// RUN: %python %S/../../utils/summarize-time-trace.py %t.json | FileCheck %s --check-prefix=SUMMARY
+
+// CHECK-DAG: InstantiateClass Box<int> ({{.*}}time-trace-events.cpp:[[@LINE+1]]:30)
+template <typename T> struct Box {
+  T Value;
+  constexpr T get() const { return Value; }
+};
+
+// CHECK-DAG: InstantiateFunction twice<int> ({{.*}}time-trace-events.cpp:[[@LINE+1]]:25)
+template <typename T> T twice(T X) { return X + X; }
+
+constexpr int square(int X) { return X * X; }
+
+// CHECK-DAG: EvaluateAsInitializer Squared ({{.*}}time-trace-events.cpp:[[@LINE+2]]:15)
+// CHECK-DAG: EvaluateConstexprCall square ({{.*}}time-trace-events.cpp:[[@LINE+1]]:25)
+constexpr int Squared = square(4);
+
+struct Stream {};
+Stream &operator<<(Stream &S, int) { return S; }
+Stream &operator<<(Stream &S, const char *) { return S; }
+
+int use(Stream &S) {
+  Box<int> B = {1};
+  // CHECK-DAG: OverloadResolution operator<< ({{.*}}time-trace-events.cpp:[[@LINE+1]]:5)
+  S << twice(B.get()) << "";
+  return Squared;
+}
+
+// SUMMARY: 1 translation units
+// SUMMARY: Most expensive templates
+// SUMMARY-DAG: Box ({{.*}}time-trace-events.cpp)
+// SUMMARY-DAG: twice ({{.*}}time-trace-events.cpp)
+// SUMMARY: Most expensive instantiations
+// SUMMARY-DAG: Box<int>
+// SUMMARY-DAG: twice<int>
+// SUMMARY: Most expensive constant evaluations
+// SUMMARY-DAG: square ({{.*}}time-trace-events.cpp:{{[0-9]+}}:25)
+// SUMMARY: Most expensive overload resolutions
+// SUMMARY: operator<< ({{.*}}time-trace-events.cpp:
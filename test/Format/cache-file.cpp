@@ -0,0 +1,13 @@
+// RUN: rm -f %t.cache
+// RUN: grep -Ev "// *[A-Z-]+:" %s | clang-format -style=LLVM \
+// RUN:   -cache-file=%t.cache | FileCheck -strict-whitespace %s
+// RUN: FileCheck -check-prefix=CACHE %s < %t.cache
+// RUN: grep -Ev "// *[A-Z-]+:" %s | clang-format -style=LLVM \
+// RUN:   -cache-file=%t.cache | FileCheck -strict-whitespace %s
+// RUN: echo "garbage" > %t.cache
+// RUN: grep -Ev "// *[A-Z-]+:" %s | clang-format -style=LLVM \
+// RUN:   -cache-file=%t.cache | FileCheck -strict-whitespace %s
+// CHECK: {{^int\ someFunction\(int\ aaaaaaaaaaaaaaaaaaaaaaaaa,\ int\ bbbbbbbbbbbbbbbbbbbbbbb,$}}
+// CHECK-NEXT: {{^\ \ \ \ \ \ \ \ \ \ \ \ \ \ \ \ \ int\ ccccccccccccccccccccccccc\);$}}
+// CACHE: clang-format line cache 1
+int someFunction(int aaaaaaaaaaaaaaaaaaaaaaaaa, int bbbbbbbbbbbbbbbbbbbbbbb, int ccccccccccccccccccccccccc);
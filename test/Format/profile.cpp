@@ -0,0 +1,10 @@
+// RUN: grep -Ev "// *[A-Z-]+:" %s | clang-format -style=LLVM -profile \
+// RUN:   -assume-filename=profile.cpp 2>&1 >/dev/null | FileCheck %s
+// CHECK: profile.cpp: searched 1 lines in {{[0-9.]+}}s,
+// CHECK-SAME: expanded {{[1-9][0-9]*}} states, pruned {{[0-9]+}} states,
+// CHECK-SAME: cut off 0 searches
+// CHECK-NEXT: profile.cpp:4: slowest line, searched in {{[0-9.]+}}s
+int a;
+int b;
+int c;
+int someFunction(int aaaaaaaaaaaaaaaaaaaaaaaaa, int bbbbbbbbbbbbbbbbbbbbbbb, int ccccccccccccccccccccccccc);
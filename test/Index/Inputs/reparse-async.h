@@ -0,0 +1 @@
+void bar(void);
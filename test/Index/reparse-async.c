@@ -0,0 +1,15 @@
+#include "reparse-async.h"
+
+void foo() {
+  bar();
+}
+
+// RUN: env CINDEXTEST_EDITING=1 CINDEXTEST_ASYNC_REPARSE=1 \
+// RUN:   c-index-test -test-load-source-reparse 2 all \
+// RUN:   -remap-file-1="%S/Inputs/reparse-async.h,%S/Inputs/reparse-async.h-1" \
+// RUN:   -- -I %S/Inputs %s | FileCheck %s
+
+// CHECK: reparse-async.h:1:6: FunctionDecl=bar:1:6
+// CHECK: reparse-async.h:2:6: FunctionDecl=baz:2:6
+// CHECK: reparse-async.c:3:6: FunctionDecl=foo:3:6 (Definition)
+// CHECK: reparse-async.c:4:3: CallExpr=bar:1:6
@@ -0,0 +1,16 @@
+#include "reparse-async.h"
+
+void foo() {
+  bar();
+}
+
+int x;
+
+// RUN: env CINDEXTEST_EDITING=1 CINDEXTEST_CANCEL_REPARSE=1 \
+// RUN:   not c-index-test -test-load-source-reparse 1 all \
+// RUN:   -- -I %S/Inputs %s 2>&1 | FileCheck %s
+
+// A cancelled reparse leaves a partial translation unit, so it fails.
+// CHECK: Unable to reparse translation unit!
+// CHECK-NEXT: Failure (no details available)
+// CHECK-NOT: reparse-cancel.c:
@@ -0,0 +1,28 @@
+// RUN: %clang_cc1 -fsyntax-only -std=c++11 -verify %s
+// RUN: %clang_cc1 -fsyntax-only -std=c++11 -trigraphs -DTRIGRAPHS -verify %s
+
+// Tokens and whitespace runs spanning several of the 16 byte chunks the lexer
+// scans at once.
+
+constexpr int an_identifier_longer_than_several_chunks_ABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789 = 1;
+static_assert(an_identifier_longer_than_several_chunks_ABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789 == 1, "");
+constexpr int ends_at_chunk_boundary_ = 2; static_assert(ends_at_chunk_boundary_+1 == 3, "");
+
+                                                                    constexpr int x = 3;
+			 	 	 		  	 	 	 	 	    static_assert(x == 3, "");
+
+static_assert(sizeof("0123456789abcdef0123456789abcdef0123456789") == 43, "");
+static_assert(sizeof("0123456789abcdef0123456789\"bcdef0123456789") == 43, "");
+static_assert(sizeof("0123456789abcdef0123456789\\bcdef0123456789") == 43, "");
+static_assert(sizeof("0123456789abcdef0123456789?bcdef0123456789") == 43, "");
+static_assert(sizeof("0123456789abcdef0123456789\
+abcdef0123456789") == 43, "");
+
+static_assert(sizeof(R"(0123456789abcdef0123456789abcdef0123456789)") == 43, "");
+static_assert(sizeof(R"x(0123456789abcdef)"0123456789abcdef01234567)x") == 43, "");
+
+#ifdef TRIGRAPHS
+static_assert(sizeof("0123456789abcdef0123456789??/"bcdef0123456789") == 43, ""); // expected-warning {{trigraph converted}}
+#else
+// expected-no-diagnostics
+#endif
@@ -0,0 +1,50 @@
+// Test the dependency directives source minimizer on a mixed input.
+//
+// RUN: %clang_cc1 -print-dependency-directives-minimized-source %s 2>&1 | FileCheck %s
+
+#ifndef GUARD_H
+#define GUARD_H
+
+// A comment that mentions #include "not-a-dependency.h".
+/* A block comment spanning lines.
+#include "not-a-dependency-either.h"
+*/
+   #  include   "quoted.h"   // trailing comment
+#include <angled//header.h>
+#define MACRO(x) "a string with // inside" \
+  x
+#pragma once
+#pragma GCC diagnostic push
+#pragma push_macro("MACRO")
+#error not kept
+
+int Value = 1'000'000;
+const char *Raw = R"delim(
+#include "in-raw-string.h"
+)delim";
+
+#if defined(MACRO) /* inline comment */ && 1
+#include_next <next.h>
+#elif 0
+#undef MACRO
+#else
+@import Module.Sub;
+#endif
+#endif
+
+// CHECK:      #ifndef GUARD_H
+// CHECK-NEXT: #define GUARD_H
+// CHECK-NEXT: #include "quoted.h"
+// CHECK-NEXT: #include <angled//header.h>
+// CHECK-NEXT: #define MACRO(x) "a string with // inside"   x
+// CHECK-NEXT: #pragma once
+// CHECK-NEXT: #pragma push_macro("MACRO")
+// CHECK-NEXT: #if defined(MACRO)   && 1
+// CHECK-NEXT: #include_next <next.h>
+// CHECK-NEXT: #elif 0
+// CHECK-NEXT: #undef MACRO
+// CHECK-NEXT: #else
+// CHECK-NEXT: @import Module.Sub;
+// CHECK-NEXT: #endif
+// CHECK-NEXT: #endif
+// CHECK-NOT:  {{.}}
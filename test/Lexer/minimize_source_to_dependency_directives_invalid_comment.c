@@ -0,0 +1,6 @@
+// RUN: not %clang_cc1 -print-dependency-directives-minimized-source %s 2>&1 | FileCheck %s
+
+#include "a.h"
+/* unterminated
+
+// CHECK: error: failed to minimize the source to its dependency directives
@@ -0,0 +1,2 @@
+#include "d.h"
+int a = d;
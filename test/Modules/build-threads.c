@@ -0,0 +1,46 @@
+// REQUIRES: asserts
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t \
+// RUN:   -fmodules-build-threads=4 -I %S/Inputs/build-threads %s -verify
+// RUN: ls -R %t | grep ^A.*pcm
+// RUN: ls -R %t | grep ^B.*pcm
+// RUN: ls -R %t | grep ^C.*pcm
+// RUN: ls -R %t | grep ^D.*pcm
+//
+// The modules are all in the cache now, so nothing is built.
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t \
+// RUN:   -fmodules-build-threads=4 -I %S/Inputs/build-threads %s \
+// RUN:   -Rmodule-build 2>&1 | count 0
+//
+// A is built when it is imported, and B and C, which the main file imports
+// too, are built in the background meanwhile. D is only imported by A and B.
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t \
+// RUN:   -fmodules-build-threads=4 -I %S/Inputs/build-threads %s \
+// RUN:   -fsyntax-only -print-stats 2>&1 | FileCheck --check-prefix=STATS %s
+// STATS: 2 modules{{ +}}- Number of modules imported by the main file that were built in the background
+//
+// With a single thread, each module is built when it is imported.
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t \
+// RUN:   -fmodules-build-threads=1 -I %S/Inputs/build-threads %s \
+// RUN:   -fsyntax-only -print-stats 2>&1 | FileCheck --check-prefix=SERIAL %s
+// SERIAL-NOT: Number of modules imported by the main file that were built in the background
+//
+// A module that fails to build in the background is built again, with
+// diagnostics, when it is imported.
+// RUN: rm -rf %t
+// RUN: not %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t \
+// RUN:   -fmodules-build-threads=4 -I %S/Inputs/build-threads %s \
+// RUN:   -DBROKEN -I %S/Inputs/build-threads-broken 2>&1 | FileCheck %s
+// CHECK: broken.h:1:14: error: expected expression
+// CHECK: fatal error: could not build module 'Broken'
+
+#include "a.h"
+#include "b.h"
+#pragma clang module import C
+#ifdef BROKEN
+#include "broken.h"
+#endif
+
+int sum() { return a + b + c + d; } // expected-no-diagnostics
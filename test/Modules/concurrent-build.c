@@ -0,0 +1,36 @@
+// REQUIRES: shell
+// Compilers that import the same module at the same time, with the same module
+// cache, build it only once and don't leave its lock file behind.
+//
+// RUN: rm -rf %t
+// RUN: mkdir -p %t/include
+// RUN: echo 'module A { header "A.h" }' > %t/include/module.modulemap
+// RUN: for i in 0 1 2 3 4 5 6 7; do \
+// RUN:   echo "struct S$i { int x$i; }; int f$i(struct S$i *);"; \
+// RUN: done > %t/include/A.h
+//
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache \
+// RUN:   -fdisable-module-hash -fsyntax-only -I %t/include -Rmodule-build %s \
+// RUN:   2> %t/1.txt & \
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache \
+// RUN:   -fdisable-module-hash -fsyntax-only -I %t/include -Rmodule-build %s \
+// RUN:   2> %t/2.txt & \
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache \
+// RUN:   -fdisable-module-hash -fsyntax-only -I %t/include -Rmodule-build %s \
+// RUN:   2> %t/3.txt; \
+// RUN: wait
+//
+// RUN: cat %t/1.txt %t/2.txt %t/3.txt | FileCheck %s
+// RUN: ls %t/cache | FileCheck --check-prefix=CACHE %s
+
+#include "A.h"
+
+int g(struct S7 *s) { return f0(0) + s->x7; }
+
+// CHECK: remark: building module 'A'
+// CHECK: remark: finished building module 'A'
+// CHECK-NOT: remark: building module 'A'
+// CHECK-NOT: error:
+
+// CACHE: A.pcm
+// CACHE-NOT: .lock
@@ -0,0 +1,34 @@
+#include "foo.h"
+
+// RUN: rm -rf %t
+// RUN: mkdir -p %t/Inputs
+// RUN: mkdir -p %t/modules-to-compare
+
+// ===
+// Create a module whose header is a user header.
+// RUN: echo 'void meow(void);' > %t/Inputs/foo.h
+// RUN: echo 'module Foo { header "foo.h" }' > %t/Inputs/module.map
+
+// ===
+// Compile the module. The timestamp file records its signature.
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fdisable-module-hash -fmodules-cache-path=%t/modules-cache -fsyntax-only -I %t/Inputs -fbuild-session-timestamp=1390000000 -fmodules-validate-once-per-build-session -fmodules-validate-signature-once-per-build-session -fmodules-validation-threads=4 %s
+// RUN: FileCheck -check-prefix=STAMP %s < %t/modules-cache/Foo.pcm.timestamp
+// STAMP: Timestamp file
+// STAMP-NEXT: signature {{[0-9]+ [0-9]+ [0-9]+ [0-9]+ [0-9]+$}}
+// RUN: cp %t/modules-cache/Foo.pcm %t/modules-to-compare/Foo-before.pcm
+
+// ===
+// Change the user header. The module was validated during this build session,
+// so it is not validated again.
+// RUN: echo 'void meow2(void);' > %t/Inputs/foo.h
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fdisable-module-hash -fmodules-cache-path=%t/modules-cache -fsyntax-only -I %t/Inputs -fbuild-session-timestamp=1390000000 -fmodules-validate-once-per-build-session -fmodules-validate-signature-once-per-build-session -fmodules-validation-threads=4 %s
+// RUN: cp %t/modules-cache/Foo.pcm %t/modules-to-compare/Foo-after.pcm
+// RUN: diff %t/modules-to-compare/Foo-before.pcm %t/modules-to-compare/Foo-after.pcm
+
+// ===
+// Without the signature of the module file in the timestamp file, the user
+// header is validated, and the module is rebuilt.
+// RUN: echo 'Timestamp file' > %t/modules-cache/Foo.pcm.timestamp
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fdisable-module-hash -fmodules-cache-path=%t/modules-cache -fsyntax-only -I %t/Inputs -fbuild-session-timestamp=1390000000 -fmodules-validate-once-per-build-session -fmodules-validate-signature-once-per-build-session -fmodules-validation-threads=4 %s
+// RUN: cp %t/modules-cache/Foo.pcm %t/modules-to-compare/Foo-after.pcm
+// RUN: not diff %t/modules-to-compare/Foo-before.pcm %t/modules-to-compare/Foo-after.pcm
@@ -0,0 +1,26 @@
+// REQUIRES: asserts
+// RUN: rm -rf %t
+// Create the global module index for the first module.
+// RUN: %clang_cc1 -Wno-private-module -fmodules-cache-path=%t -fdisable-module-hash -fmodules -fimplicit-module-maps -F %S/Inputs %s -verify -DFIRST
+// RUN: ls %t | grep modules.idx
+// Build another module, which updates the index: the entry of the first
+// module is reused, and only the new module file is read.
+// RUN: %clang_cc1 -Wno-private-module -fmodules-cache-path=%t -fdisable-module-hash -fmodules -fimplicit-module-maps -F %S/Inputs %s -verify -print-stats 2>&1 | FileCheck --check-prefix=UPDATE %s
+// RUN: ls %t | grep modules.idx
+// Use the updated index.
+// RUN: %clang_cc1 -Wno-private-module -fmodules-cache-path=%t -fdisable-module-hash -fmodules -fimplicit-module-maps -F %S/Inputs %s -verify -print-stats 2>&1 | FileCheck %s
+
+// expected-no-diagnostics
+@import Module;
+#ifndef FIRST
+@import DependsOnModule;
+#endif
+
+// UPDATE-DAG: 1 module-index - Number of module files read into the global module index
+// UPDATE-DAG: 1 module-index - Number of module files whose global module index entry was reused
+
+// CHECK: *** Global Module Index Statistics:
+
+int *get_sub() {
+  return Module_Sub;
+}
@@ -0,0 +1,43 @@
+// REQUIRES: asserts, shell
+// The input files of a module are validated when it is loaded from an earlier
+// build, but not when the same compilation built or validated it already.
+//
+// RUN: rm -rf %t
+// RUN: mkdir -p %t/include
+// RUN: echo 'module A { header "A.h" export * }' > %t/include/module.modulemap
+// RUN: echo 'module B { header "B.h" }' >> %t/include/module.modulemap
+// RUN: echo 'module C { header "C.h" }' >> %t/include/module.modulemap
+// RUN: echo '#include "B.h"' > %t/include/A.h
+// RUN: echo 'int a(void);' >> %t/include/A.h
+// RUN: echo 'int b(void);' > %t/include/B.h
+// RUN: echo 'int c(void);' > %t/include/C.h
+//
+// Building A builds B and loads it; the compilation then loads both.
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache \
+// RUN:   -fdisable-module-hash -fsyntax-only -I %t/include %s -print-stats 2>&1 \
+// RUN:   | FileCheck --check-prefix=BUILD %s
+//
+// A and B come from the first build and are validated. C is built and then
+// loaded without being validated.
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache \
+// RUN:   -fdisable-module-hash -fsyntax-only -I %t/include %s -DWITH_C \
+// RUN:   -print-stats 2>&1 | FileCheck --check-prefix=REBUILD %s
+
+#include "A.h"
+#ifdef WITH_C
+#include "C.h"
+#endif
+
+int f(void) {
+#ifdef WITH_C
+  c();
+#endif
+  return a() + b();
+}
+
+// BUILD-NOT: ast-reader{{ +}}- Number of module files whose input files were validated
+// BUILD: 3 ast-reader{{ +}}- Number of module files this compilation had already built or validated
+// BUILD-NOT: ast-reader{{ +}}- Number of module files whose input files were validated
+
+// REBUILD-DAG: 2 ast-reader{{ +}}- Number of module files whose input files were validated
+// REBUILD-DAG: 1 ast-reader{{ +}}- Number of module files this compilation had already built or validated
@@ -0,0 +1,27 @@
+// The declarations in a profile are matched to the ones in the header even
+// when the header is found through a relative include path, which the AST
+// file records as an absolute path.
+//
+// RUN: rm -rf %t
+// RUN: mkdir -p %t/include
+// RUN: echo 'enum class Unused { A };' > %t/include/hot.h
+// RUN: echo 'namespace ns { struct Used { int x; }; }' >> %t/include/hot.h
+// RUN: echo '#include "hot.h"' > %t/prefix.h
+//
+// RUN: cd %t && %clang_cc1 -std=c++11 -x c++-header -emit-pch -I include \
+// RUN:   -o cold.pch prefix.h
+// RUN: cd %t && %clang_cc1 -std=c++11 -include-pch cold.pch -I include \
+// RUN:   -fsyntax-only -deserialization-profile profile %s
+// RUN: FileCheck --input-file=%t/profile %s
+//
+// RUN: cd %t && %clang_cc1 -std=c++11 -x c++-header -emit-pch -I include \
+// RUN:   -pch-layout-profile profile -o hot.pch prefix.h
+// RUN: llvm-bcanalyzer -dump %t/hot.pch | FileCheck -check-prefix=HOT %s
+
+int use(ns::Used *U) { return U->x; }
+
+// CHECK: {{^}}decl{{.*}}include{{[/\\]}}hot.h:{{[0-9]+}}{{.*}}ns::Used
+
+// HOT-DAG: {{<DECL_NAMESPACE }}
+// HOT-DAG: {{<DECL_CXX_RECORD }}
+// HOT: {{<DECL_ENUM }}
@@ -0,0 +1,53 @@
+// Record the declarations that a translation unit reads from a PCH, then lay
+// out a new PCH with those declarations first.
+//
+// RUN: %clang_cc1 -std=c++11 -emit-pch -o %t.pch %s
+// RUN: %clang_cc1 -std=c++11 -include-pch %t.pch -fsyntax-only \
+// RUN:   -deserialization-profile %t.profile %s
+// RUN: FileCheck --input-file=%t.profile %s
+//
+// RUN: %clang_cc1 -std=c++11 -emit-pch -pch-layout-profile %t.profile \
+// RUN:   -o %t.hot.pch %s
+// RUN: %clang_cc1 -std=c++11 -include-pch %t.hot.pch -fsyntax-only \
+// RUN:   -deserialization-profile %t.hot.profile %s
+// RUN: FileCheck --input-file=%t.hot.profile %s
+//
+// The declarations are written in the order of their IDs. Without a profile,
+// that's the order of the source. With one, the declarations that were read
+// get the first IDs, and are written before the others.
+// RUN: llvm-bcanalyzer -dump %t.pch | FileCheck -check-prefix=COLD %s
+// RUN: llvm-bcanalyzer -dump %t.hot.pch | FileCheck -check-prefix=HOT %s
+//
+// RUN: not %clang_cc1 -std=c++11 -emit-pch -pch-layout-profile %t.missing \
+// RUN:   -o %t.bad.pch %s 2>&1 | FileCheck -check-prefix=MISSING %s
+
+#ifndef HEADER
+#define HEADER
+
+enum class Unused { A };
+
+namespace ns {
+struct Used { int x; };
+}
+
+#else
+
+int use(ns::Used *U) { return U->x; }
+
+#endif
+
+// CHECK: {{^}}# {{[0-9]+}} declarations and {{[0-9]+}} identifiers deserialized
+// CHECK-NOT: Unused
+// CHECK-DAG: {{^}}decl{{.*}}.pch{{.*}}Namespace{{.*}}deserialization-profile.cpp:{{[0-9]+}}{{.*}}ns{{$}}
+// CHECK-DAG: {{^}}decl{{.*}}.pch{{.*}}CXXRecord{{.*}}deserialization-profile.cpp:{{[0-9]+}}{{.*}}ns::Used{{$}}
+// CHECK-DAG: {{^}}identifier{{.*}}Used{{$}}
+// CHECK-NOT: Unused
+
+// COLD: {{<DECL_ENUM }}
+// COLD: {{<DECL_NAMESPACE }}
+
+// HOT-DAG: {{<DECL_NAMESPACE }}
+// HOT-DAG: {{<DECL_CXX_RECORD }}
+// HOT: {{<DECL_ENUM }}
+
+// MISSING: cannot open file '{{.*}}.missing'
@@ -0,0 +1,39 @@
+// Without -fpch-instantiate-templates, the translation unit performs the
+// instantiations that the PCH requires.
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -emit-pch -o %t.pch %s -verify=pch
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -include-pch %t.pch -emit-llvm -o - %s -verify=tu | FileCheck %s
+
+// With it, the PCH performs those whose templates it defines.
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -emit-pch -fpch-instantiate-templates -o %t.inst.pch %s -verify=inst-pch
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -include-pch %t.inst.pch -emit-llvm -o - %s -verify=inst-tu | FileCheck %s
+
+// RUN: %clang -### -fpch-instantiate-templates -c %s 2>&1 | FileCheck %s --check-prefix=DRIVER
+// DRIVER: "-fpch-instantiate-templates"
+
+// pch-no-diagnostics
+// inst-tu-no-diagnostics
+// tu-warning@23 {{division by zero is undefined}} tu-note@27 {{in instantiation of}}
+// inst-pch-warning@23 {{division by zero is undefined}} inst-pch-note@27 {{in instantiation of}}
+
+#ifndef HEADER
+#define HEADER
+
+template <typename T> T twice(T x) { return x + x; }
+
+template <typename T> T ratio(T x) { return x / (sizeof(T) - 4); }
+
+template <typename T> T later(T x);
+
+inline int use(int x) { return twice(x) + ratio(x) + later(x); }
+
+#else
+
+template <typename T> T later(T x) { return x - 1; }
+
+int main() { return use(1); }
+
+// CHECK-DAG: define {{.*}}@_Z5twiceIiET_S0_(
+// CHECK-DAG: define {{.*}}@_Z5ratioIiET_S0_(
+// CHECK-DAG: define {{.*}}@_Z5laterIiET_S0_(
+
+#endif
@@ -0,0 +1,134 @@
+// RUN: %clang_cc1 -std=c++17 -fsyntax-only -verify %s -fconstexpr-steps 1000 -fconstexpr-depth 32 -fconstexpr-bytecode
+// RUN: %clang_cc1 -std=c++17 -fsyntax-only -verify %s -fconstexpr-steps 1000 -fconstexpr-depth 32 -fconstexpr-bytecode-verify
+// RUN: %clang_cc1 -std=c++17 -fsyntax-only -verify %s -fconstexpr-steps 1000 -fconstexpr-depth 32 -fconstexpr-bytecode-verify -fconstexpr-cache-size 0
+// RUN: %clang -std=c++17 -fsyntax-only -Xclang -verify %s -fconstexpr-steps=1000 -fconstexpr-depth=32 -fconstexpr-bytecode
+// RUN: %clang_cc1 -std=c++17 -fsyntax-only %s -fconstexpr-steps 1000 -fconstexpr-depth 32 -fconstexpr-bytecode -print-stats 2>&1 | FileCheck %s
+
+// CHECK: *** Constexpr Bytecode Stats:
+// CHECK: {{[1-9][0-9]*}} functions compiled, {{[1-9][0-9]*}} unsupported
+
+// -fconstexpr-bytecode-verify also evaluates every call that the bytecode
+// evaluates by walking the function body, and diagnoses different results.
+
+constexpr int fib(int n) { return n < 2 ? n : fib(n - 1) + fib(n - 2); }
+static_assert(fib(15) == 610, "");
+
+constexpr unsigned long long collatz(unsigned long long n) {
+  unsigned long long steps = 0;
+  while (n != 1) {
+    if (n % 2 == 0)
+      n /= 2;
+    else
+      n = 3 * n + 1;
+    ++steps;
+  }
+  return steps;
+}
+static_assert(collatz(27) == 111, "");
+
+constexpr int loops(int n) {
+  int sum = 0;
+  for (int i = 0; i < n; i++) {
+    if (i % 3 == 0)
+      continue;
+    if (i > 20)
+      break;
+    sum += i;
+  }
+  int j = 0;
+  do {
+    sum -= j;
+  } while (++j < 4);
+  if (int k = sum & 7; k > 3)
+    return sum * 2;
+  else
+    return -sum;
+}
+static_assert(loops(10) == 42, "");
+static_assert(loops(100) == 282, "");
+
+// Conversions between integral types, and unsigned arithmetic, wrap around.
+constexpr unsigned char narrow(int n) { return n; }
+static_assert(narrow(300) == 44, "");
+constexpr unsigned wrap(unsigned n) { return n - 1u; }
+static_assert(wrap(0) == 4294967295u, "");
+constexpr signed char increment(signed char c) { return ++c; }
+static_assert(increment(127) == -128, "");
+constexpr long long widen(int n, unsigned m) { return (long long)n * m; }
+static_assert(widen(-3, 4000000000u) == -12000000000LL, "");
+constexpr bool flag(int n) {
+  bool b = false;
+  b |= n;
+  return b;
+}
+static_assert(flag(2) && !flag(0), "");
+
+constexpr int shifts(int a, unsigned b) { return (a << b) ^ (-a >> 1); }
+static_assert(shifts(3, 4) == -50, "");
+static_assert(shifts(1, 30) == -(1 << 30) - 1, "");
+
+constexpr bool logic(int a, int b) { return (a && b / a > 1) || !b; }
+static_assert(logic(2, 6) && !logic(0, 1) && logic(0, 0), "");
+
+enum class Color : short { Red = -1, Green = 2, Blue = 5 };
+constexpr Color next(Color c) {
+  return c == Color::Red     ? Color::Green
+         : c == Color::Green ? Color::Blue
+                             : Color::Red;
+}
+static_assert(next(next(Color::Red)) == Color::Blue, "");
+
+template <int N> constexpr int scaled(int n, int by = N * 2) { return n * by; }
+static_assert(scaled<3>(7) == 42 && scaled<3>(7, 1) == 7, "");
+
+constexpr int Base = 100;
+constexpr int offset(int n) { return Base + n; }
+static_assert(offset(5) == 105, "");
+
+// Calls to functions that can't be compiled to bytecode, and to functions that
+// call them, are evaluated by walking the function bodies.
+struct Pair {
+  int a, b;
+};
+constexpr int first(Pair p) { return p.a; }
+constexpr int array(int n) {
+  int values[3] = {n, n + 1, n + 2};
+  return values[2];
+}
+constexpr int mixed(int n) { return n + array(n); }
+static_assert(first({4, 0}) + mixed(4) == 14, "");
+
+// Functions are compiled when they're first called, so they can call functions
+// that are defined after them.
+constexpr int late(int n);
+constexpr int calls_late(int n) { return late(n) + 1; }
+constexpr int late(int n) { return n * n; }
+static_assert(calls_late(6) == 37, "");
+
+// Calls that aren't constant expressions are diagnosed as without bytecode.
+constexpr int add(int a, int b) { return a + b; } // expected-note {{value 2147483648 is outside the range}}
+static_assert(add(2147483647, 1), ""); // expected-error {{constant}} expected-note {{in call to 'add(2147483647, 1)'}}
+
+constexpr int divide(int a, int b) { return a / b; } // expected-note {{division by zero}}
+static_assert(divide(1, 0), ""); // expected-error {{constant}} expected-note {{in call to 'divide(1, 0)'}}
+
+constexpr int negate(int a) { return -a; } // expected-note {{value 2147483648 is outside the range}}
+static_assert(negate(-2147483647 - 1), ""); // expected-error {{constant}} expected-note {{in call to 'negate(-2147483648)'}}
+
+constexpr int shift(int a, int b) { return a << b; } // expected-note {{negative shift count -1}}
+static_assert(shift(1, -1), ""); // expected-error {{constant}} expected-note {{in call to 'shift(1, -1)'}}
+
+constexpr int no_return(int n) { if (n) return n; } // expected-note {{control reached end of constexpr function}} expected-warning {{does not return a value}}
+static_assert(no_return(0), ""); // expected-error {{constant}} expected-note {{in call to 'no_return(0)'}}
+
+constexpr bool steps(int n) {
+  for (int k = 0; k != n; ++k) {}
+  return true; // expected-note {{step limit}}
+}
+static_assert(steps(300), "");
+static_assert(steps(1000), ""); // expected-error {{constant}} expected-note {{in call to 'steps(1000)'}}
+
+constexpr int depth(int n) { return n > 1 ? depth(n - 1) : 0; } // expected-note {{exceeded maximum depth}} expected-note +{{}}
+constexpr int call_depth(int n) { return depth(n); } // expected-note {{in call to 'depth(}}
+static_assert(depth(32) == 0, "");
+static_assert(call_depth(32) == 0, ""); // expected-error {{constant}} expected-note {{in call to 'call_depth(32)'}}
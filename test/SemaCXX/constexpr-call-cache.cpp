@@ -0,0 +1,51 @@
+// RUN: %clang_cc1 -std=c++14 -fsyntax-only -verify %s -fconstexpr-steps 1000 -fconstexpr-depth 32
+// RUN: %clang_cc1 -std=c++14 -fsyntax-only -verify %s -fconstexpr-steps 1000 -fconstexpr-depth 32 -fconstexpr-cache-size 0
+// RUN: %clang -std=c++14 -fsyntax-only -Xclang -verify %s -fconstexpr-steps=1000 -fconstexpr-depth=32 -fconstexpr-cache-size=16
+// RUN: %clang_cc1 -std=c++14 -fsyntax-only %s -fconstexpr-steps 1000 -fconstexpr-depth 32 -print-stats 2>&1 | FileCheck %s
+
+// CHECK: *** Constexpr Call Cache Stats:
+// CHECK: {{[1-9][0-9]*}} hits
+
+constexpr int fib(int n) { return n < 2 ? n : fib(n - 1) + fib(n - 2); }
+static_assert(fib(10) == 55, "");
+static_assert(fib(12) == 144, "");
+
+constexpr unsigned length(const char *s) { return *s ? 1 + length(s + 1) : 0; }
+static_assert(length("hello") == 5, "");
+static_assert(length("hello") + length("hello" + 2) == 8, "");
+static_assert(length("") == 0, "");
+
+struct Pair {
+  int a, b;
+};
+union Either {
+  int i;
+  float f;
+};
+constexpr Pair swap(Pair p) { return {p.b, p.a}; }
+constexpr int get(Either e) { return e.i; }
+static_assert(swap({1, 2}).a == 2 && swap({1, 2}).b == 1, "");
+static_assert(swap(swap({1, 2})).a == 1, "");
+static_assert(get(Either{3}) == 3, "");
+constexpr Either e = {3};
+static_assert(get(e) == 3, "");
+
+constexpr int numbers[] = {1, 2, 3};
+constexpr int sum(const int *p, int n) { return n ? *p + sum(p + 1, n - 1) : 0; }
+static_assert(sum(numbers, 3) == 6, "");
+static_assert(sum(numbers + 1, 2) == 5, "");
+static_assert(sum(numbers, 3) == 6, "");
+
+// The results of earlier calls are only reused when evaluating the call again
+// would stay within the step and depth limits.
+constexpr bool steps(int n) {
+  for (int k = 0; k != n; ++k) {}
+  return true; // expected-note {{step limit}}
+}
+static_assert(steps(600), "");
+static_assert(steps(600) && steps(600), ""); // expected-error {{constant}} expected-note {{in call to 'steps(600)'}}
+
+constexpr int depth(int n) { return n > 1 ? depth(n - 1) : 0; } // expected-note {{exceeded maximum depth}} expected-note +{{}}
+constexpr int wrap(int n) { return depth(n); } // expected-note {{in call to 'depth(}}
+static_assert(depth(32) == 0, "");
+static_assert(wrap(32) == 0, ""); // expected-error {{constant}} expected-note {{in call to 'wrap(32)'}}
@@ -2062,6 +2062,25 @@ int perform_test_load_source(int argc, const char **argv,
   return result;
 }
 
+/* Reparse the translation unit, on a background thread if
+ * CINDEXTEST_ASYNC_REPARSE is set. */
+static int reparse_translation_unit(CXTranslationUnit TU,
+                                    unsigned num_unsaved_files,
+                                    struct CXUnsavedFile *unsaved_files) {
+  CXReparseTask Task;
+  if (!getenv("CINDEXTEST_ASYNC_REPARSE"))
+    return clang_reparseTranslationUnit(TU, num_unsaved_files, unsaved_files,
+                                        clang_defaultReparseOptions(TU));
+
+  Task = clang_reparseTranslationUnitAsync(TU, num_unsaved_files,
+                                           unsaved_files,
+                                           clang_defaultReparseOptions(TU),
+                                           NULL, NULL);
+  if (!Task)
+    return CXError_InvalidArguments;
+  return clang_finishReparse(Task);
+}
+
 int perform_test_reparse_source(int argc, const char **argv, int trials,
                                 const char *filter, CXCursorVisitor Visitor,
                                 PostVisitTU PV) {
@@ -2075,6 +2094,7 @@ int perform_test_reparse_source(int argc, const char **argv, int trials,
   int trial;
   int remap_after_trial = 0;
   char *endptr = 0;
+  CXCancellationToken Cancellation = 0;
   
   Idx = clang_createIndex(/* excludeDeclsFromPCH */
                           !strcmp(filter, "local") ? 1 : 0,
@@ -2116,6 +2136,13 @@ int perform_test_reparse_source(int argc, const char **argv, int trials,
         strtol(getenv("CINDEXTEST_REMAP_AFTER_TRIAL"), &endptr, 10);
   }
 
+  /* Make the reparses stop at the first declaration of the main file. */
+  if (getenv("CINDEXTEST_CANCEL_REPARSE")) {
+    Cancellation = clang_CancellationToken_create();
+    clang_CancellationToken_cancel(Cancellation);
+    clang_TranslationUnit_setCancellationToken(TU, Cancellation);
+  }
+
   for (trial = 0; trial < trials; ++trial) {
     free_remapped_files(unsaved_files, num_unsaved_files);
     if (parse_remapped_files_with_try(trial, argc, argv, 0,
@@ -2125,17 +2152,18 @@ int perform_test_reparse_source(int argc, const char **argv, int trials,
       return -1;
     }
 
-    Err = clang_reparseTranslationUnit(
+    Err = reparse_translation_unit(
         TU,
         trial >= remap_after_trial ? num_unsaved_files : 0,
-        trial >= remap_after_trial ? unsaved_files : 0,
-        clang_defaultReparseOptions(TU));
+        trial >= remap_after_trial ? unsaved_files : 0);
     if (Err != CXError_Success) {
       fprintf(stderr, "Unable to reparse translation unit!\n");
       describeLibclangFailure(Err);
       clang_disposeTranslationUnit(TU);
       free_remapped_files(unsaved_files, num_unsaved_files);
       clang_disposeIndex(Idx);
+      if (Cancellation)
+        clang_CancellationToken_dispose(Cancellation);
       return -1;      
     }
 
@@ -2147,6 +2175,8 @@ int perform_test_reparse_source(int argc, const char **argv, int trials,
 
   free_remapped_files(unsaved_files, num_unsaved_files);
   clang_disposeIndex(Idx);
+  if (Cancellation)
+    clang_CancellationToken_dispose(Cancellation);
   return result;
 }
 
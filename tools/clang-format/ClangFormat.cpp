@@ -21,6 +21,7 @@
 #include "clang/Rewrite/Core/Rewriter.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/InitLLVM.h"
 #include "llvm/Support/Process.h"
 
@@ -107,6 +108,19 @@ static cl::opt<bool>
     Verbose("verbose", cl::desc("If set, shows the list of processed files"),
             cl::cat(ClangFormatCategory));
 
+static cl::opt<std::string> CacheFile(
+    "cache-file",
+    cl::desc("Remember the line breaks of the formatted lines in this file,\n"
+             "so that formatting the same lines again, e.g. from an editor\n"
+             "integration, is faster."),
+    cl::cat(ClangFormatCategory));
+
+static cl::opt<bool>
+    Profile("profile",
+            cl::desc("If set, prints how long the search for the best line\n"
+                     "breaks took for each file to stderr."),
+            cl::cat(ClangFormatCategory));
+
 static cl::list<std::string> FileNames(cl::Positional, cl::desc("[<file> ...]"),
                                        cl::cat(ClangFormatCategory));
 
@@ -239,8 +253,21 @@ static void outputReplacementsXML(const Replacements &Replaces) {
   }
 }
 
+static void printProfile(StringRef FileName,
+                         const FormattingAttemptStatus &Status) {
+  errs() << FileName << ": searched " << Status.NumSearchedLines
+         << " lines in " << llvm::format("%.6f", Status.SearchTime)
+         << "s, expanded " << Status.NumExpandedStates << " states, pruned "
+         << Status.NumPrunedStates << " states, cut off "
+         << Status.NumCutOffSearches << " searches\n";
+  if (Status.SlowestSearchLine)
+    errs() << FileName << ":" << Status.SlowestSearchLine
+           << ": slowest line, searched in "
+           << llvm::format("%.6f", Status.SlowestSearchTime) << "s\n";
+}
+
 // Returns true on error.
-static bool format(StringRef FileName) {
+static bool format(StringRef FileName, LineFormattingCache *Cache) {
   if (!OutputXML && Inplace && FileName == "-") {
     errs() << "error: cannot use -i when reading from stdin.\n";
     return false;
@@ -313,8 +340,10 @@ static bool format(StringRef FileName) {
   Ranges = tooling::calculateRangesAfterReplacements(Replaces, Ranges);
   FormattingAttemptStatus Status;
   Replacements FormatChanges = reformat(*FormatStyle, *ChangedCode, Ranges,
-                                        AssumedFileName, &Status);
+                                        AssumedFileName, &Status, Cache);
   Replaces = Replaces.merge(FormatChanges);
+  if (Profile)
+    printProfile(AssumedFileName, Status);
   if (OutputXML) {
     outs() << "<?xml version='1.0'?>\n<replacements "
               "xml:space='preserve' incomplete_format='"
@@ -360,6 +389,29 @@ static bool format(StringRef FileName) {
   return false;
 }
 
+// Writes the cache next to \p Path first and renames it, so that concurrent
+// invocations never read a partially written cache.
+// Returns true on error.
+static bool saveCache(const LineFormattingCache &Cache, StringRef Path) {
+  int FD;
+  SmallString<128> TempPath;
+  if (std::error_code EC = llvm::sys::fs::createUniqueFile(
+          Path + "-%%%%%%%%", FD, TempPath)) {
+    errs() << "error: cannot write " << Path << ": " << EC.message() << "\n";
+    return true;
+  }
+  {
+    raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    Cache.save(OS);
+  }
+  if (std::error_code EC = llvm::sys::fs::rename(TempPath, Path)) {
+    llvm::sys::fs::remove(TempPath);
+    errs() << "error: cannot write " << Path << ": " << EC.message() << "\n";
+    return true;
+  }
+  return false;
+}
+
 }  // namespace format
 }  // namespace clang
 
@@ -418,20 +470,33 @@ int main(int argc, const char **argv) {
     return 0;
   }
 
-  bool Error = false;
-  if (FileNames.empty()) {
-    Error = clang::format::format("-");
-    return Error ? 1 : 0;
-  }
-  if (FileNames.size() != 1 && (!Offsets.empty() || !Lengths.empty() || !LineRanges.empty())) {
+  if (FileNames.size() > 1 &&
+      (!Offsets.empty() || !Lengths.empty() || !LineRanges.empty())) {
     errs() << "error: -offset, -length and -lines can only be used for "
               "single file.\n";
     return 1;
   }
-  for (const auto &FileName : FileNames) {
-    if (Verbose)
-      errs() << "Formatting " << FileName << "\n";
-    Error |= clang::format::format(FileName);
+
+  std::unique_ptr<clang::format::LineFormattingCache> Cache;
+  if (!CacheFile.empty()) {
+    Cache = llvm::make_unique<clang::format::LineFormattingCache>();
+    // A missing or outdated cache is simply rebuilt.
+    if (ErrorOr<std::unique_ptr<MemoryBuffer>> CacheBuffer =
+            MemoryBuffer::getFile(CacheFile))
+      Cache->load((*CacheBuffer)->getBuffer());
+  }
+
+  bool Error = false;
+  if (FileNames.empty()) {
+    Error = clang::format::format("-", Cache.get());
+  } else {
+    for (const auto &FileName : FileNames) {
+      if (Verbose)
+        errs() << "Formatting " << FileName << "\n";
+      Error |= clang::format::format(FileName, Cache.get());
+    }
   }
+  if (Cache)
+    Error |= clang::format::saveCache(*Cache, CacheFile);
   return Error ? 1 : 0;
 }
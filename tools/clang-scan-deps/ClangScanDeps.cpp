@@ -0,0 +1,163 @@
+//===- ClangScanDeps.cpp - Implementation of clang-scan-deps --------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Clang tool which computes the make-style dependencies of every translation
+// unit in a compilation database, preprocessing sources that have been
+// minimized down to the directives that can affect the dependencies.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Frontend/CompilerInvocation.h"
+#include "clang/Tooling/ArgumentsAdjusters.h"
+#include "clang/Tooling/DependencyScanning/DependencyScanningService.h"
+#include "clang/Tooling/DependencyScanning/DependencyScanningWorker.h"
+#include "clang/Tooling/JSONCompilationDatabase.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <atomic>
+
+using namespace clang;
+using namespace tooling::dependencies;
+
+static llvm::cl::OptionCategory DependencyScannerCategory("Tool options");
+
+static llvm::cl::opt<ScanningMode> ScanMode(
+    "mode",
+    llvm::cl::desc("The preprocessing mode used to compute the dependencies"),
+    llvm::cl::values(
+        clEnumValN(ScanningMode::MinimizedSourcePreprocessing,
+                   "preprocess-minimized-sources",
+                   "The set of dependencies is computed by preprocessing the "
+                   "source files that were minimized to only include the "
+                   "contents that might affect the dependencies"),
+        clEnumValN(ScanningMode::CanonicalPreprocessing, "preprocess",
+                   "The set of dependencies is computed by preprocessing the "
+                   "unmodified source files")),
+    llvm::cl::init(ScanningMode::MinimizedSourcePreprocessing),
+    llvm::cl::cat(DependencyScannerCategory));
+
+static llvm::cl::opt<unsigned>
+    NumThreads("j", llvm::cl::Optional,
+               llvm::cl::desc("Number of worker threads to use (default: use "
+                              "all concurrent threads)"),
+               llvm::cl::init(0), llvm::cl::cat(DependencyScannerCategory));
+
+static llvm::cl::opt<std::string>
+    CompilationDB("compilation-database",
+                  llvm::cl::desc("Compilation database"), llvm::cl::Required,
+                  llvm::cl::cat(DependencyScannerCategory));
+
+namespace {
+
+/// The result of scanning a single compile command.
+struct ScanResult {
+  std::string File;
+  bool Succeeded = false;
+  /// The dependency file contents, or the diagnostics on failure.
+  std::string Output;
+};
+
+} // end anonymous namespace
+
+int main(int argc, const char **argv) {
+  llvm::InitLLVM X(argc, argv);
+  llvm::cl::HideUnrelatedOptions(DependencyScannerCategory);
+  if (!llvm::cl::ParseCommandLineOptions(argc, argv))
+    return 1;
+
+  std::string ErrorMessage;
+  std::unique_ptr<tooling::JSONCompilationDatabase> Compilations =
+      tooling::JSONCompilationDatabase::loadFromFile(
+          CompilationDB, ErrorMessage,
+          tooling::JSONCommandLineSyntax::AutoDetect);
+  if (!Compilations) {
+    llvm::errs() << "error: " << ErrorMessage << "\n";
+    return 1;
+  }
+
+  // Every command becomes a syntax-only one without an output, so that the
+  // driver builds exactly one compiler job for it. The dependency output
+  // options are kept, as they describe the requested dependency file.
+  tooling::ArgumentsAdjuster Adjuster =
+      tooling::combineAdjusters(tooling::getClangStripOutputAdjuster(),
+                                tooling::getClangSyntaxOnlyAdjuster());
+
+  // Exists solely for the purpose of lookup of the resource path.
+  // This just needs to be some symbol in the binary.
+  static int StaticSymbol;
+  std::string ResourceDir =
+      CompilerInvocation::GetResourcesPath(argv[0], &StaticSymbol);
+
+  std::vector<tooling::CompileCommand> Inputs =
+      Compilations->getAllCompileCommands();
+  std::vector<ScanResult> Results(Inputs.size());
+
+  unsigned NumWorkers =
+      NumThreads == 0 ? llvm::hardware_concurrency() : NumThreads;
+  NumWorkers = std::max(1u, std::min<unsigned>(NumWorkers, Inputs.size()));
+
+  // The service owns the file system cache that is shared by the workers.
+  DependencyScanningService Service(ScanMode);
+  std::vector<std::unique_ptr<DependencyScanningWorker>> Workers;
+  for (unsigned I = 0; I < NumWorkers; ++I)
+    Workers.push_back(llvm::make_unique<DependencyScanningWorker>(Service));
+
+  std::atomic<size_t> Index(0);
+  {
+    llvm::ThreadPool Pool(NumWorkers);
+    for (unsigned I = 0; I < NumWorkers; ++I) {
+      Pool.async([&, I]() {
+        DependencyScanningWorker &Worker = *Workers[I];
+        while (true) {
+          size_t Idx = Index++;
+          if (Idx >= Inputs.size())
+            return;
+          const tooling::CompileCommand &Command = Inputs[Idx];
+          std::vector<std::string> CommandLine =
+              Adjuster(Command.CommandLine, Command.Filename);
+          bool HasResourceDir = false;
+          for (StringRef Arg : CommandLine)
+            HasResourceDir |= Arg.startswith("-resource-dir");
+          if (!HasResourceDir)
+            CommandLine.push_back("-resource-dir=" + ResourceDir);
+
+          ScanResult &Result = Results[Idx];
+          Result.File = Command.Filename;
+          llvm::Expected<std::string> MaybeFile =
+              Worker.getDependencyFile(CommandLine, Command.Directory);
+          if (MaybeFile) {
+            Result.Succeeded = true;
+            Result.Output = std::move(*MaybeFile);
+          } else {
+            Result.Output = llvm::toString(MaybeFile.takeError());
+          }
+        }
+      });
+    }
+    Pool.wait();
+  }
+
+  // Print the results in the order of the compilation database, to keep the
+  // output independent of the scheduling of the workers.
+  bool HadErrors = false;
+  for (const ScanResult &Result : Results) {
+    if (Result.Succeeded) {
+      llvm::outs() << Result.Output;
+      continue;
+    }
+    HadErrors = true;
+    llvm::errs() << "Error while scanning dependencies for " << Result.File
+                 << ":\n"
+                 << Result.Output;
+  }
+  return HadErrors;
+}
@@ -16,6 +16,7 @@
 #include "clang/CodeGen/ObjectFilePCHContainerOperations.h"
 #include "clang/Config/config.h"
 #include "clang/Driver/DriverDiagnostic.h"
+#include "clang/Driver/Job.h"
 #include "clang/Driver/Options.h"
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/CompilerInvocation.h"
@@ -66,7 +67,12 @@ static void LLVMErrorHandler(void *UserData, const std::string &Message,
   // We cannot recover from llvm errors.  When reporting a fatal error, exit
   // with status 70 to generate crash diagnostics.  For BSD systems this is
   // defined as an internal software error.  Otherwise, exit with status 1.
-  exit(GenCrashDiag ? 70 : 1);
+  // When running inside the driver process, only stop this job so that the
+  // driver can still handle the failure.
+  int RetCode = GenCrashDiag ? 70 : 1;
+  if (driver::CC1Command::isRunningInProcess())
+    driver::CC1Command::exitInProcess(RetCode);
+  exit(RetCode);
 }
 
 #ifdef LINK_POLLY_INTO_TOOLS
@@ -14,6 +14,7 @@
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/DiagnosticOptions.h"
 #include "clang/Driver/DriverDiagnostic.h"
+#include "clang/Driver/Job.h"
 #include "clang/Driver/Options.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Frontend/TextDiagnosticPrinter.h"
@@ -540,7 +541,11 @@ static void LLVMErrorHandler(void *UserData, const std::string &Message,
 
   Diags.Report(diag::err_fe_error_backend) << Message;
 
-  // We cannot recover from llvm errors.
+  // We cannot recover from llvm errors. When running inside the driver
+  // process, only stop this job so that the driver can still handle the
+  // failure.
+  if (driver::CC1Command::isRunningInProcess())
+    driver::CC1Command::exitInProcess(1);
   exit(1);
 }
 
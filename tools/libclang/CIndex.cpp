@@ -53,6 +53,7 @@
 #include "llvm/Support/Threading.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/thread.h"
 
 #if LLVM_ENABLE_THREADS != 0 && defined(__APPLE__)
 #define USE_DARWIN_THREADS
@@ -3290,6 +3291,14 @@ CXIndex clang_createIndex(int excludeDeclarationsFromPCH,
     CIdxr->setCXGlobalOptFlags(CIdxr->getCXGlobalOptFlags() |
                                CXGlobalOpt_ThreadBackgroundPriorityForEditing);
 
+  // The size of the preamble cache shared by all translation units, in
+  // megabytes.
+  if (const char *CacheSize = getenv("LIBCLANG_PREAMBLE_CACHE_SIZE")) {
+    uint64_t Megabytes;
+    if (!StringRef(CacheSize).getAsInteger(10, Megabytes))
+      ASTUnit::setSharedPreambleCacheSize(Megabytes << 20);
+  }
+
   return CIdxr;
 }
 
@@ -4132,6 +4141,183 @@ int clang_reparseTranslationUnit(CXTranslationUnit TU,
   return result;
 }
 
+CXCancellationToken clang_CancellationToken_create(void) {
+  CXCancellationToken Token = new CXCancellationTokenImpl;
+  Token->Token = std::make_shared<CancellationToken>();
+  return Token;
+}
+
+void clang_CancellationToken_dispose(CXCancellationToken token) {
+  delete token;
+}
+
+void clang_CancellationToken_cancel(CXCancellationToken token) {
+  if (token)
+    token->Token->cancel();
+}
+
+void clang_CancellationToken_setDeadline(CXCancellationToken token,
+                                         unsigned timeout_ms) {
+  if (token)
+    token->Token->setDeadline(CancellationToken::Clock::now() +
+                              std::chrono::milliseconds(timeout_ms));
+}
+
+unsigned clang_CancellationToken_isCancelled(CXCancellationToken token) {
+  return token && token->Token->isCancelled();
+}
+
+void clang_TranslationUnit_setCancellationToken(CXTranslationUnit TU,
+                                                CXCancellationToken token) {
+  if (isNotUsableTU(TU)) {
+    LOG_BAD_TU(TU);
+    return;
+  }
+  ASTUnit *CXXUnit = cxtu::getASTUnit(TU);
+  ASTUnit::ConcurrencyCheck Check(*CXXUnit);
+  CXXUnit->setCancellationToken(token ? token->Token : nullptr);
+}
+
+struct CXReparseTaskImpl {
+  CXTranslationUnit TU;
+  /// The unit that is reparsed, which replaces the one of \c TU when the
+  /// task is finished.
+  std::unique_ptr<ASTUnit> NewUnit;
+  std::vector<ASTUnit::RemappedFile> RemappedFiles;
+  std::shared_ptr<PCHContainerOperations> PCHContainerOps;
+  bool BackgroundPriority = false;
+  CXReparseCallback Callback = nullptr;
+  CXClientData ClientData = nullptr;
+
+  /// Stops the reparse of \c NewUnit when the task is cancelled.
+  std::shared_ptr<CancellationToken> Cancellation =
+      std::make_shared<CancellationToken>();
+  /// Whether \c NewUnit took the ownership of the remapped file buffers.
+  bool ReparseStarted = false;
+  CXErrorCode Result = CXError_Failure;
+  std::unique_ptr<llvm::thread> Thread;
+
+  ~CXReparseTaskImpl() {
+    if (!ReparseStarted)
+      for (const auto &RF : RemappedFiles)
+        delete RF.second;
+  }
+
+  void run();
+};
+
+void CXReparseTaskImpl::run() {
+  if (!Cancellation->isCancelled()) {
+    if (BackgroundPriority)
+      setThreadBackgroundPriority();
+
+    ASTUnit *Unit = NewUnit.get();
+    auto ReparseImpl = [this, Unit]() {
+      ASTUnit::ConcurrencyCheck Check(*Unit);
+      if (!Unit->Reparse(PCHContainerOps, RemappedFiles))
+        Result = CXError_Success;
+      else if (isASTReadError(Unit))
+        Result = CXError_ASTReadError;
+      else
+        Result = CXError_Failure;
+    };
+
+    ReparseStarted = true;
+    llvm::CrashRecoveryContext CRC;
+    if (!RunSafely(CRC, ReparseImpl)) {
+      fprintf(stderr, "libclang: crash detected during reparsing\n");
+      // Leak the unit, like clang_disposeTranslationUnit() does for units
+      // that crashed.
+      NewUnit.release();
+      Result = CXError_Crashed;
+    }
+  }
+
+  if (Callback)
+    Callback(this, Cancellation->isCancelled() ? CXError_Failure : Result,
+             ClientData);
+}
+
+CXReparseTask clang_reparseTranslationUnitAsync(
+    CXTranslationUnit TU, unsigned num_unsaved_files,
+    struct CXUnsavedFile *unsaved_files, unsigned options,
+    CXReparseCallback callback, CXClientData client_data) {
+  LOG_FUNC_SECTION {
+    *Log << TU;
+  }
+
+  if (isNotUsableTU(TU)) {
+    LOG_BAD_TU(TU);
+    return nullptr;
+  }
+  if (num_unsaved_files && !unsaved_files)
+    return nullptr;
+
+  ASTUnit *CXXUnit = cxtu::getASTUnit(TU);
+  auto Task = llvm::make_unique<CXReparseTaskImpl>();
+  {
+    ASTUnit::ConcurrencyCheck Check(*CXXUnit);
+    Task->NewUnit = CXXUnit->createUnparsedCopy();
+  }
+  if (!Task->NewUnit)
+    return nullptr;
+  Task->NewUnit->setCancellationToken(Task->Cancellation);
+
+  CIndexer *CXXIdx = TU->CIdx;
+  Task->TU = TU;
+  Task->PCHContainerOps = CXXIdx->getPCHContainerOperations();
+  Task->BackgroundPriority =
+      CXXIdx->isOptEnabled(CXGlobalOpt_ThreadBackgroundPriorityForEditing);
+  Task->Callback = callback;
+  Task->ClientData = client_data;
+  for (auto &UF : llvm::makeArrayRef(unsaved_files, num_unsaved_files)) {
+    std::unique_ptr<llvm::MemoryBuffer> MB =
+        llvm::MemoryBuffer::getMemBufferCopy(getContents(UF), UF.Filename);
+    Task->RemappedFiles.push_back(std::make_pair(UF.Filename, MB.release()));
+  }
+
+  CXReparseTaskImpl *Result = Task.release();
+  if (getenv("LIBCLANG_NOTHREADS"))
+    Result->run();
+  else
+    Result->Thread =
+        llvm::make_unique<llvm::thread>([Result] { Result->run(); });
+  return Result;
+}
+
+void clang_cancelReparse(CXReparseTask Task) {
+  if (Task)
+    Task->Cancellation->cancel();
+}
+
+enum CXErrorCode clang_finishReparse(CXReparseTask Task) {
+  if (!Task)
+    return CXError_InvalidArguments;
+
+  std::unique_ptr<CXReparseTaskImpl> TaskOwner(Task);
+  if (Task->Thread)
+    Task->Thread->join();
+  if (Task->Cancellation->isCancelled())
+    return CXError_Failure;
+  if (Task->Result != CXError_Success)
+    return Task->Result;
+
+  CXTranslationUnit TU = Task->TU;
+  ASTUnit *OldUnit = cxtu::getASTUnit(TU);
+  {
+    ASTUnit::ConcurrencyCheck Check(*OldUnit);
+    delete static_cast<CXDiagnosticSetImpl *>(TU->Diagnostics);
+    TU->Diagnostics = nullptr;
+    TU->TheASTUnit = Task->NewUnit.release();
+  }
+  if (!OldUnit->isUnsafeToFree())
+    delete OldUnit;
+
+  if (getenv("LIBCLANG_RESOURCE_USAGE"))
+    PrintLibclangResourceUsage(TU);
+  return CXError_Success;
+}
+
 
 CXString clang_getTranslationUnitSpelling(CXTranslationUnit CTUnit) {
   if (isNotUsableTU(CTUnit)) {
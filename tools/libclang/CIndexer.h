@@ -15,9 +15,11 @@
 #define LLVM_CLANG_TOOLS_LIBCLANG_CINDEXER_H
 
 #include "clang-c/Index.h"
+#include "clang/Basic/CancellationToken.h"
 #include "clang/Frontend/PCHContainerOperations.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/Mutex.h"
+#include <memory>
 #include <utility>
 
 namespace llvm {
@@ -151,4 +153,8 @@ private:
     }
     }
 
+struct CXCancellationTokenImpl {
+  std::shared_ptr<clang::CancellationToken> Token;
+};
+
 #endif
@@ -442,6 +442,8 @@ bool CXIndexDataConsumer::isFunctionLocalDecl(const Decl *D) {
 }
 
 bool CXIndexDataConsumer::shouldAbort() {
+  if (Cancellation && Cancellation->isCancelled())
+    return true;
   if (!CB.abortQuery)
     return false;
   return CB.abortQuery(ClientData, nullptr);
@@ -12,6 +12,7 @@
 #include "CXCursor.h"
 #include "Index_Internal.h"
 #include "clang/Index/IndexDataConsumer.h"
+#include "clang/Basic/CancellationToken.h"
 #include "clang/AST/DeclGroup.h"
 #include "clang/AST/DeclObjC.h"
 #include "llvm/ADT/DenseSet.h"
@@ -276,6 +277,7 @@ class CXIndexDataConsumer : public index::IndexDataConsumer {
   ASTContext *Ctx;
   CXClientData ClientData;
   IndexerCallbacks &CB;
+  std::shared_ptr<CancellationToken> Cancellation;
   unsigned IndexOptions;
   CXTranslationUnit CXTU;
   
@@ -343,6 +345,10 @@ public:
   void setASTContext(ASTContext &ctx);
   void setPreprocessor(std::shared_ptr<Preprocessor> PP) override;
 
+  void setCancellationToken(std::shared_ptr<CancellationToken> Token) {
+    Cancellation = std::move(Token);
+  }
+
   bool shouldSuppressRefs() const {
     return IndexOptions & CXIndexOpt_SuppressRedundantRefs;
   }
@@ -406,6 +406,7 @@ static IndexingOptions getIndexingOptionsFromCXOptions(unsigned index_options) {
 struct IndexSessionData {
   CXIndex CIdx;
   std::unique_ptr<SessionSkipBodyData> SkipBodyData;
+  std::shared_ptr<CancellationToken> Cancellation;
 
   explicit IndexSessionData(CXIndex cIdx)
     : CIdx(cIdx), SkipBodyData(new SessionSkipBodyData) {}
@@ -517,6 +518,8 @@ static CXErrorCode clang_indexSourceFile_Impl(
   if (index_options & CXIndexOpt_SuppressWarnings)
     CInvok->getDiagnosticOpts().IgnoreWarnings = true;
 
+  CInvok->getPreprocessorOpts().Cancellation = IdxSession->Cancellation;
+
   // Make sure to use the raw module format.
   CInvok->getHeaderSearchOpts().ModuleFormat =
     CXXIdx->getPCHContainerOperations()->getRawReader().getFormat();
@@ -544,6 +547,7 @@ static CXErrorCode clang_indexSourceFile_Impl(
   auto DataConsumer =
     std::make_shared<CXIndexDataConsumer>(client_data, CB, index_options,
                                           CXTU->getTU());
+  DataConsumer->setCancellationToken(IdxSession->Cancellation);
   auto InterAction = llvm::make_unique<IndexingFrontendAction>(DataConsumer,
                          SkipBodies ? IdxSession->SkipBodyData.get() : nullptr);
   std::unique_ptr<FrontendAction> IndexAction;
@@ -659,6 +663,9 @@ static CXErrorCode clang_indexTranslationUnit_Impl(
   memcpy(&CB, client_index_callbacks, ClientCBSize);
 
   CXIndexDataConsumer DataConsumer(client_data, CB, index_options, TU);
+  if (idxAction)
+    DataConsumer.setCancellationToken(
+        static_cast<IndexSessionData *>(idxAction)->Cancellation);
 
   ASTUnit *Unit = cxtu::getASTUnit(TU);
   if (!Unit)
@@ -832,6 +839,13 @@ void clang_IndexAction_dispose(CXIndexAction idxAction) {
     delete static_cast<IndexSessionData *>(idxAction);
 }
 
+void clang_IndexAction_setCancellationToken(CXIndexAction idxAction,
+                                            CXCancellationToken token) {
+  if (idxAction)
+    static_cast<IndexSessionData *>(idxAction)->Cancellation =
+        token ? token->Token : nullptr;
+}
+
 int clang_indexSourceFile(CXIndexAction idxAction,
                           CXClientData client_data,
                           IndexerCallbacks *index_callbacks,
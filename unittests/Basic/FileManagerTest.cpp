@@ -12,6 +12,7 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/VirtualFileSystem.h"
+#include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
 
 using namespace llvm;
@@ -379,4 +380,127 @@ TEST_F(FileManagerTest, getFileDontOpenRealPath) {
   EXPECT_EQ(file->tryGetRealPathName(), ExpectedResult);
 }
 
+// The cache only applies to absolute paths, which look different on Windows.
+#ifndef _WIN32
+TEST_F(FileManagerTest, PersistentStatCacheSharesLookups) {
+  SmallString<128> CacheDir;
+  ASSERT_FALSE(
+      llvm::sys::fs::createUniqueDirectory("stat-cache-test", CacheDir));
+  SmallString<128> CachePath(CacheDir);
+  llvm::sys::path::append(CachePath, "stats");
+
+  auto FS = IntrusiveRefCntPtr<llvm::vfs::InMemoryFileSystem>(
+      new llvm::vfs::InMemoryFileSystem);
+  FS->addFile("/sdk/include/a.h", 0, llvm::MemoryBuffer::getMemBuffer("a"));
+  FS->addFile("/user/b.h", 0, llvm::MemoryBuffer::getMemBuffer("b"));
+  std::vector<std::string> Prefixes = {"/sdk"};
+
+  // The first compiler populates the cache.
+  {
+    FileManager Manager(FileSystemOptions(), FS);
+    Manager.setStatCache(
+        llvm::make_unique<PersistentStatCache>(CachePath, Prefixes));
+    EXPECT_NE(nullptr, Manager.getFile("/sdk/include/a.h"));
+    EXPECT_EQ(nullptr, Manager.getFile("/sdk/include/missing.h"));
+    EXPECT_NE(nullptr, Manager.getFile("/user/b.h"));
+  }
+
+  // The next one finds the missing file in it, looks up the existing file
+  // again, and does not cache paths outside of the prefixes.
+  {
+    PersistentStatCache Cache(CachePath, Prefixes);
+    llvm::vfs::Status Status;
+    EXPECT_FALSE(FileSystemStatCache::get("/sdk/include/a.h", Status,
+                                          /*isFile=*/true, nullptr, &Cache,
+                                          *FS));
+    EXPECT_EQ(1u, Status.getSize());
+    EXPECT_TRUE(FileSystemStatCache::get("/sdk/include/missing.h", Status,
+                                         /*isFile=*/true, nullptr, &Cache,
+                                         *FS));
+    EXPECT_FALSE(FileSystemStatCache::get("/user/b.h", Status,
+                                          /*isFile=*/true, nullptr, &Cache,
+                                          *FS));
+    EXPECT_EQ(1u, Cache.getNumHits());
+    EXPECT_EQ(1u, Cache.getNumMisses());
+  }
+
+  // A different parent directory invalidates the cached lookups.
+  {
+    auto OtherFS = IntrusiveRefCntPtr<llvm::vfs::InMemoryFileSystem>(
+        new llvm::vfs::InMemoryFileSystem);
+    OtherFS->addFile("/sdk/include/missing.h", 0,
+                     llvm::MemoryBuffer::getMemBuffer("now it exists"));
+    PersistentStatCache Cache(CachePath, Prefixes);
+    llvm::vfs::Status Status;
+    EXPECT_FALSE(FileSystemStatCache::get("/sdk/include/missing.h", Status,
+                                          /*isFile=*/true, nullptr, &Cache,
+                                          *OtherFS));
+    EXPECT_EQ(0u, Cache.getNumHits());
+    EXPECT_EQ(1u, Cache.getNumMisses());
+  }
+
+  llvm::sys::fs::remove_directories(CacheDir);
+}
+
+TEST_F(FileManagerTest, PersistentStatCacheSeesHeadersEditedInPlace) {
+  SmallString<128> Dir;
+  ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("stat-cache-test", Dir));
+  SmallString<128> CachePath(Dir), Header(Dir);
+  llvm::sys::path::append(CachePath, "stats");
+  llvm::sys::path::append(Header, "a.h");
+  std::vector<std::string> Prefixes = {Dir.str()};
+
+  auto WriteHeader = [&](StringRef Contents) {
+    std::error_code EC;
+    llvm::raw_fd_ostream OS(Header, EC, llvm::sys::fs::F_None);
+    ASSERT_FALSE(EC);
+    OS << Contents;
+  };
+  auto GetHeaderSize = [&]() -> off_t {
+    FileManager Manager(FileSystemOptions(), llvm::vfs::getRealFileSystem());
+    Manager.setStatCache(
+        llvm::make_unique<PersistentStatCache>(CachePath, Prefixes));
+    const FileEntry *File = Manager.getFile(Header);
+    return File ? File->getSize() : -1;
+  };
+
+  WriteHeader("int a;");
+  EXPECT_EQ(6, GetHeaderSize());
+
+  // Rewriting the header in place leaves its directory alone, but the cache
+  // doesn't hide the new size.
+  WriteHeader("int a, b;");
+  EXPECT_EQ(9, GetHeaderSize());
+
+  llvm::sys::fs::remove_directories(Dir);
+}
+#endif // !_WIN32
+
+TEST_F(FileManagerTest, getBufferForFileMapsFilesWithoutNullTerminator) {
+  // A file whose size is a multiple of the page size can only be mapped when
+  // the buffer doesn't need a null terminator.
+  SmallString<128> Path;
+  int FD;
+  ASSERT_FALSE(
+      llvm::sys::fs::createTemporaryFile("mapped-file", "pcm", FD, Path));
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << std::string(64 * 1024, 'x');
+  }
+
+  FileManager Manager(FileSystemOptions());
+  auto Mapped = Manager.getBufferForFile(Path, /*isVolatile=*/false,
+                                         /*RequiresNullTerminator=*/false);
+  ASSERT_TRUE(bool(Mapped));
+  EXPECT_EQ(llvm::MemoryBuffer::MemoryBuffer_MMap, (*Mapped)->getBufferKind());
+  EXPECT_EQ(64u * 1024, (*Mapped)->getBufferSize());
+
+  auto Copied = Manager.getBufferForFile(Path);
+  ASSERT_TRUE(bool(Copied));
+  EXPECT_EQ((*Mapped)->getBuffer(), (*Copied)->getBuffer());
+  EXPECT_EQ('\0', *(*Copied)->getBufferEnd());
+
+  llvm::sys::fs::remove(Path);
+}
+
 } // anonymous namespace
@@ -97,6 +97,89 @@ private:
   bool *Success;
 };
 
+class CTUUnloadASTConsumer : public clang::ASTConsumer {
+public:
+  explicit CTUUnloadASTConsumer(clang::CompilerInstance &CI, bool *Success)
+      : CTU(CI), Success(Success) {}
+
+  void HandleTranslationUnit(ASTContext &Ctx) override {
+    const FunctionDecl *F = nullptr, *G = nullptr;
+    for (const Decl *D : Ctx.getTranslationUnitDecl()->decls())
+      if (const auto *FD = dyn_cast<FunctionDecl>(D))
+        (FD->getName() == "f" ? F : G) = FD;
+    ASSERT_TRUE(F && G);
+
+    // Put the definitions of f and g into two different AST files.
+    std::string FASTFileName = createASTFile("int f(int) { return 0; }\n");
+    std::string GASTFileName = createASTFile("int g(int) { return 1; }\n");
+    std::string IndexFileName = createFile(
+        "index", "txt",
+        "c:@F@f#I# " + FASTFileName + "\nc:@F@g#I# " + GASTFileName + "\n");
+
+    // Only one of the AST files fits into the memory limit.
+    CTU.setMaxLoadedASTMemory(1);
+    llvm::Expected<const FunctionDecl *> NewFOrError =
+        CTU.getCrossTUDefinition(F, "", IndexFileName);
+    ASSERT_TRUE((bool)NewFOrError);
+    EXPECT_EQ(CTU.getNumLoadedASTs(), 1u);
+    llvm::Expected<const FunctionDecl *> NewGOrError =
+        CTU.getCrossTUDefinition(G, "", IndexFileName);
+    ASSERT_TRUE((bool)NewGOrError);
+    EXPECT_EQ(CTU.getNumLoadedASTs(), 1u);
+
+    // An unloaded AST file is loaded again when it is needed.
+    llvm::Expected<ASTUnit *> UnitOrError =
+        CTU.loadExternalAST("c:@F@f#I#", "", IndexFileName);
+    ASSERT_TRUE((bool)UnitOrError);
+    EXPECT_EQ(CTU.getNumLoadedASTs(), 1u);
+
+    *Success = (*NewFOrError)->hasBody() && (*NewGOrError)->hasBody();
+  }
+
+private:
+  /// Creates a temporary file that is removed with the consumer.
+  std::string createFile(StringRef Prefix, StringRef Suffix,
+                         StringRef Contents) {
+    int FD;
+    llvm::SmallString<256> FileName;
+    EXPECT_FALSE(
+        llvm::sys::fs::createTemporaryFile(Prefix, Suffix, FD, FileName));
+    Files.push_back(llvm::make_unique<llvm::ToolOutputFile>(FileName, FD));
+    Files.back()->os() << Contents;
+    Files.back()->os().flush();
+    return FileName.str();
+  }
+
+  /// Saves the AST of \p SourceText into a temporary AST file.
+  std::string createASTFile(StringRef SourceText) {
+    // The source file must exist since the saved AST file references it.
+    std::string SourceFileName = createFile("input", "cpp", SourceText);
+    std::string ASTFileName = createFile("ast", "ast", "");
+    std::unique_ptr<ASTUnit> AST =
+        tooling::buildASTFromCode(SourceText, SourceFileName);
+    AST->Save(ASTFileName);
+    return ASTFileName;
+  }
+
+  CrossTranslationUnitContext CTU;
+  bool *Success;
+  std::vector<std::unique_ptr<llvm::ToolOutputFile>> Files;
+};
+
+class CTUUnloadASTAction : public clang::ASTFrontendAction {
+public:
+  CTUUnloadASTAction(bool *Success) : Success(Success) {}
+
+protected:
+  std::unique_ptr<clang::ASTConsumer>
+  CreateASTConsumer(clang::CompilerInstance &CI, StringRef) override {
+    return llvm::make_unique<CTUUnloadASTConsumer>(CI, Success);
+  }
+
+private:
+  bool *Success;
+};
+
 } // end namespace
 
 TEST(CrossTranslationUnit, CanLoadFunctionDefinition) {
@@ -105,6 +188,13 @@ TEST(CrossTranslationUnit, CanLoadFunctionDefinition) {
   EXPECT_TRUE(Success);
 }
 
+TEST(CrossTranslationUnit, UnloadsLeastRecentlyUsedASTs) {
+  bool Success = false;
+  EXPECT_TRUE(tooling::runToolOnCode(new CTUUnloadASTAction(&Success),
+                                     "int f(int); int g(int);"));
+  EXPECT_TRUE(Success);
+}
+
 TEST(CrossTranslationUnit, IndexFormatCanBeParsed) {
   llvm::StringMap<std::string> Index;
   Index["a"] = "/b/f1";
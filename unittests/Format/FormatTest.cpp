@@ -4442,6 +4442,22 @@ TEST_F(FormatTest, MemoizationTests) {
 }
 #endif
 
+TEST_F(FormatTest, CountsSearchedStates) {
+  std::string Code =
+      "int i;\n"
+      "int someFunction(int aaaaaaaaaaaaaaaaaaaaaaaaa, int bbbbbbbbbbbbbbbbbbbbb,"
+      " int ccccccccccccccccccccccccc);\n";
+  FormattingAttemptStatus Status;
+  reformat(getLLVMStyle(), Code, tooling::Range(0, Code.size()), "<stdin>",
+           &Status);
+  EXPECT_TRUE(Status.FormatComplete);
+  EXPECT_EQ(1u, Status.NumSearchedLines);
+  EXPECT_LT(0u, Status.NumExpandedStates);
+  EXPECT_EQ(0u, Status.NumCutOffSearches);
+  EXPECT_EQ(2u, Status.SlowestSearchLine);
+  EXPECT_LE(Status.SlowestSearchTime, Status.SearchTime);
+}
+
 TEST_F(FormatTest, BreaksAsHighAsPossible) {
   verifyFormat(
       "void f() {\n"
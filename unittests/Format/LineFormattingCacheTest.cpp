@@ -0,0 +1,93 @@
+//===- LineFormattingCacheTest.cpp - Formatting unit tests ----------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Format/Format.h"
+
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+namespace clang {
+namespace format {
+namespace {
+
+class LineFormattingCacheTest : public ::testing::Test {
+protected:
+  std::string format(llvm::StringRef Code, LineFormattingCache *Cache,
+                     const FormatStyle &Style = getLLVMStyle()) {
+    tooling::Replacements Replaces =
+        reformat(Style, Code, tooling::Range(0, Code.size()), "<stdin>",
+                 /*Status=*/nullptr, Cache);
+    auto Result = applyAllReplacements(Code, Replaces);
+    EXPECT_TRUE(static_cast<bool>(Result));
+    return *Result;
+  }
+};
+
+const char *const Code =
+    "int someFunction(int aaaaaaaaaaaaaaaaaaaaaaaaa, "
+    "int bbbbbbbbbbbbbbbbbbbbbbb, int ccccccccccccccccccccccccc);\n"
+    "void f() {\n"
+    "  auto Lambda = [&](int xxxxxxxxxxxxxxxxxxxxxxx) { return someFunction("
+    "xxxxxxxxxxxxxxxxxxxxxxx, xxxxxxxxxxxxxxxxxxxxxxx, 1); };\n"
+    "}\n";
+
+TEST_F(LineFormattingCacheTest, ReusesLineBreaks) {
+  std::string Expected = format(Code, /*Cache=*/nullptr);
+  LineFormattingCache Cache;
+  EXPECT_EQ(Expected, format(Code, &Cache));
+  unsigned Misses = Cache.getNumMisses();
+  EXPECT_GT(Misses, 0u);
+
+  unsigned Hits = Cache.getNumHits();
+  EXPECT_EQ(Expected, format(Code, &Cache));
+  EXPECT_GT(Cache.getNumHits(), Hits);
+  EXPECT_EQ(Misses, Cache.getNumMisses());
+}
+
+TEST_F(LineFormattingCacheTest, ReusesLineBreaksOfUnchangedLines) {
+  LineFormattingCache Cache;
+  format(Code, &Cache);
+  std::string Changed = std::string("int x;\n") + Code;
+  unsigned Hits = Cache.getNumHits();
+  EXPECT_EQ(format(Changed, /*Cache=*/nullptr), format(Changed, &Cache));
+  EXPECT_GT(Cache.getNumHits(), Hits);
+}
+
+TEST_F(LineFormattingCacheTest, DistinguishesStyles) {
+  FormatStyle Narrow = getLLVMStyle();
+  Narrow.ColumnLimit = 40;
+  LineFormattingCache Cache;
+  EXPECT_EQ(format(Code, /*Cache=*/nullptr), format(Code, &Cache));
+  EXPECT_EQ(format(Code, /*Cache=*/nullptr, Narrow),
+            format(Code, &Cache, Narrow));
+  EXPECT_EQ(format(Code, /*Cache=*/nullptr, getGoogleStyle()),
+            format(Code, &Cache, getGoogleStyle()));
+}
+
+TEST_F(LineFormattingCacheTest, SavesAndLoadsEntries) {
+  LineFormattingCache Cache;
+  std::string Expected = format(Code, &Cache);
+  std::string Saved;
+  llvm::raw_string_ostream OS(Saved);
+  Cache.save(OS);
+  OS.flush();
+
+  LineFormattingCache Loaded;
+  EXPECT_TRUE(Loaded.load(Saved));
+  EXPECT_EQ(Expected, format(Code, &Loaded));
+  EXPECT_GT(Loaded.getNumHits(), 0u);
+  EXPECT_EQ(0u, Loaded.getNumMisses());
+
+  LineFormattingCache Invalid;
+  EXPECT_FALSE(Invalid.load("not a cache\n"));
+  EXPECT_FALSE(Invalid.load(Saved.substr(0, Saved.size() - 2)));
+}
+
+} // end namespace
+} // end namespace format
+} // end namespace clang
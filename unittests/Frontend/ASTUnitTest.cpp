@@ -8,6 +8,7 @@
 
 #include <fstream>
 
+#include "clang/Basic/CancellationToken.h"
 #include "clang/Frontend/ASTUnit.h"
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/CompilerInvocation.h"
@@ -110,4 +111,34 @@ TEST_F(ASTUnitTest, GetBufferForFileMemoryMapping) {
             llvm::MemoryBuffer::MemoryBuffer_MMap);
 }
 
+TEST_F(ASTUnitTest, CancelledReparseFailsAndIsNotSaved) {
+  std::unique_ptr<ASTUnit> AST = createASTUnit(false);
+
+  if (!AST)
+    FAIL() << "failed to create ASTUnit";
+
+  EXPECT_FALSE(AST->wasParseCancelled());
+
+  auto Token = std::make_shared<CancellationToken>();
+  Token->cancel();
+  AST->setCancellationToken(Token);
+  EXPECT_TRUE(AST->Reparse(PCHContainerOps));
+  EXPECT_TRUE(AST->wasParseCancelled());
+
+  // The partial translation unit must not be mistaken for the complete one.
+  llvm::SmallString<256> ASTFileName;
+  ASSERT_FALSE(
+      llvm::sys::fs::createTemporaryFile("ast-unit", "ast", FD, ASTFileName));
+  ToolOutputFile ast_file(ASTFileName, FD);
+  EXPECT_TRUE(AST->Save(ASTFileName.str()));
+  uint64_t Size;
+  ASSERT_FALSE(llvm::sys::fs::file_size(ASTFileName, Size));
+  EXPECT_EQ(0u, Size);
+
+  AST->setCancellationToken(nullptr);
+  EXPECT_FALSE(AST->Reparse(PCHContainerOps));
+  EXPECT_FALSE(AST->wasParseCancelled());
+  EXPECT_FALSE(AST->Save(ASTFileName.str()));
+}
+
 } // anonymous namespace
@@ -10,6 +10,7 @@
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/RecursiveASTVisitor.h"
+#include "clang/Basic/CancellationToken.h"
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/CompilerInvocation.h"
 #include "clang/Frontend/FrontendActions.h"
@@ -255,6 +256,78 @@ TEST(ASTFrontendAction, ExternalSemaSource) {
   EXPECT_EQ("This is a note", TDC->Note.str().str());
 }
 
+/// Cancels the parse once the instantiation of \c f is handed to the consumer,
+/// and records which other function templates got instantiated.
+class CancellingConsumer : public ASTConsumer {
+public:
+  CancellingConsumer(CancellationToken &Token,
+                     std::vector<std::string> &Defined)
+      : Token(Token), Defined(Defined) {}
+
+  bool HandleTopLevelDecl(DeclGroupRef DG) override {
+    for (Decl *D : DG)
+      if (auto *FD = dyn_cast<FunctionDecl>(D))
+        if (FD->isTemplateInstantiation() && FD->getName() == "f")
+          Token.cancel();
+    return true;
+  }
+
+  void HandleTranslationUnit(ASTContext &Ctx) override {
+    for (const char *Name : {"f", "g", "h"})
+      for (NamedDecl *ND :
+           Ctx.getTranslationUnitDecl()->lookup(&Ctx.Idents.get(Name)))
+        if (auto *FTD = dyn_cast<FunctionTemplateDecl>(ND))
+          for (FunctionDecl *Spec : FTD->specializations())
+            if (Spec->isDefined())
+              Defined.push_back(Name);
+  }
+
+private:
+  CancellationToken &Token;
+  std::vector<std::string> &Defined;
+};
+
+class CancellingAction : public ASTFrontendAction {
+public:
+  CancellationToken &Token;
+  std::vector<std::string> Defined;
+
+  CancellingAction(CancellationToken &Token) : Token(Token) {}
+
+  std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance &CI,
+                                                 StringRef InFile) override {
+    return llvm::make_unique<CancellingConsumer>(Token, Defined);
+  }
+};
+
+TEST(ASTFrontendAction, CancelDuringEagerInstantiation) {
+  auto Token = std::make_shared<CancellationToken>();
+  auto Invocation = std::make_shared<CompilerInvocation>();
+  Invocation->getLangOpts()->CPlusPlus = true;
+  Invocation->getPreprocessorOpts().addRemappedFile(
+      "test.cc", MemoryBuffer::getMemBuffer(
+                     "template <typename T> void g(T) {}\n"
+                     "template <typename T> void h(T) {}\n"
+                     "template <typename T> void f(T t) { g(t); }\n"
+                     "void use() { f(0); h(0); }\n")
+                     .release());
+  Invocation->getPreprocessorOpts().Cancellation = Token;
+  Invocation->getFrontendOpts().Inputs.push_back(
+      FrontendInputFile("test.cc", InputKind::CXX));
+  Invocation->getFrontendOpts().ProgramAction = frontend::ParseSyntaxOnly;
+  Invocation->getTargetOpts().Triple = "i386-unknown-linux-gnu";
+  CompilerInstance Compiler;
+  Compiler.setInvocation(std::move(Invocation));
+  Compiler.createDiagnostics();
+
+  // The instantiations required by f<int> are still performed once the parse
+  // is cancelled, but the remaining ones of the translation unit aren't.
+  CancellingAction TestAction(*Token);
+  ASSERT_TRUE(Compiler.ExecuteAction(TestAction));
+  EXPECT_TRUE(Token->isCancelled());
+  EXPECT_EQ(std::vector<std::string>({"f", "g"}), TestAction.Defined);
+}
+
 TEST(GeneratePCHFrontendAction, CacheGeneratedPCH) {
   // Create a temporary file for writing out the PCH that will be cleaned up.
   int PCHFD;
@@ -262,4 +262,71 @@ TEST_F(PCHPreambleTest, ParseWithBom) {
   ASSERT_LE(HeaderReadCount, GetFileReadCount(Header));
 }
 
+TEST_F(PCHPreambleTest, ReparseAfterAppendingIncludeDefersPreambleRebuild) {
+  std::string Header1 = "//./header1.h";
+  std::string Header2 = "//./header2.h";
+  std::string MainName = "//./main.cpp";
+  AddFile(Header1, "#define ZERO 0\n");
+  AddFile(Header2, "#define ONE 1\n");
+  AddFile(MainName, R"cpp(
+#include "//./header1.h"
+int main() { return ZERO; }
+)cpp");
+
+  std::unique_ptr<ASTUnit> AST(ParseAST(MainName));
+  ASSERT_TRUE(AST.get());
+  ASSERT_FALSE(AST->getDiagnostics().hasErrorOccurred());
+  ASSERT_EQ(AST->getPreambleCounterForTests(), 1U);
+
+  // The appended include is parsed on top of the existing preamble.
+  RemapFile(MainName, R"cpp(
+#include "//./header1.h"
+#include "//./header2.h"
+int main() { return ZERO + ONE; }
+)cpp");
+  ASSERT_TRUE(ReparseAST(AST));
+  ASSERT_FALSE(AST->getDiagnostics().hasErrorOccurred());
+  ASSERT_EQ(AST->getPreambleCounterForTests(), 1U);
+
+  // The preamble is rebuilt once the include block stopped changing.
+  ASSERT_TRUE(ReparseAST(AST));
+  ASSERT_FALSE(AST->getDiagnostics().hasErrorOccurred());
+  ASSERT_EQ(AST->getPreambleCounterForTests(), 2U);
+}
+
+TEST_F(PCHPreambleTest, SharedPreambleCacheSharesPreambleBetweenASTUnits) {
+  std::string Header = "//./header.h";
+  std::string MainName = "//./main.cpp";
+  std::string MainFileContent = R"cpp(
+#include "//./header.h"
+int main() { return ZERO; }
+)cpp";
+  AddFile(Header, "#define ZERO 0\n");
+  AddFile(MainName, MainFileContent);
+
+  ASTUnit::setSharedPreambleCacheSize(64 << 20);
+
+  std::unique_ptr<ASTUnit> First(ParseAST(MainName));
+  ASSERT_TRUE(First.get());
+  ASSERT_FALSE(First->getDiagnostics().hasErrorOccurred());
+  ASSERT_EQ(First->getPreambleCounterForTests(), 1U);
+
+  // The second unit adopts the preamble built by the first one.
+  std::unique_ptr<ASTUnit> Second(ParseAST(MainName));
+  ASSERT_TRUE(Second.get());
+  ASSERT_FALSE(Second->getDiagnostics().hasErrorOccurred());
+  ASSERT_EQ(Second->getPreambleCounterForTests(), 0U);
+
+  // A preamble whose headers changed is not shared.
+  ResetVFS();
+  AddFile(Header, "static const int ZERO = 0;\n");
+  AddFile(MainName, MainFileContent);
+  std::unique_ptr<ASTUnit> Third(ParseAST(MainName));
+  ASSERT_TRUE(Third.get());
+  ASSERT_FALSE(Third->getDiagnostics().hasErrorOccurred());
+  ASSERT_EQ(Third->getPreambleCounterForTests(), 1U);
+
+  ASTUnit::setSharedPreambleCacheSize(0);
+}
+
 } // anonymous namespace
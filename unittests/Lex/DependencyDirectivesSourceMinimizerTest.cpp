@@ -0,0 +1,186 @@
+//===- unittests/Lex/DependencyDirectivesSourceMinimizer.cpp -  -----------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Lex/DependencyDirectivesSourceMinimizer.h"
+#include "llvm/ADT/SmallString.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+using namespace clang;
+using namespace clang::minimize_source_to_dependency_directives;
+
+namespace clang {
+
+bool minimizeSourceToDependencyDirectives(StringRef Input,
+                                          SmallVectorImpl<char> &Out) {
+  SmallVector<minimize_source_to_dependency_directives::Token, 32> Tokens;
+  return minimizeSourceToDependencyDirectives(Input, Out, Tokens);
+}
+
+} // end namespace clang
+
+namespace {
+
+TEST(MinimizeSourceToDependencyDirectivesTest, Empty) {
+  SmallVector<char, 128> Out;
+  SmallVector<Token, 4> Tokens;
+
+  ASSERT_FALSE(minimizeSourceToDependencyDirectives("", Out, Tokens));
+  EXPECT_TRUE(Out.empty());
+  ASSERT_EQ(1u, Tokens.size());
+  ASSERT_EQ(pp_eof, Tokens.back().K);
+
+  ASSERT_FALSE(
+      minimizeSourceToDependencyDirectives("abc def\nxyz", Out, Tokens));
+  EXPECT_TRUE(Out.empty());
+  ASSERT_EQ(1u, Tokens.size());
+  ASSERT_EQ(pp_eof, Tokens.back().K);
+}
+
+TEST(MinimizeSourceToDependencyDirectivesTest, AllTokens) {
+  SmallVector<char, 128> Out;
+  SmallVector<Token, 4> Tokens;
+
+  ASSERT_FALSE(
+      minimizeSourceToDependencyDirectives("#define A\n"
+                                           "#undef A\n"
+                                           "#endif\n"
+                                           "#if A\n"
+                                           "#ifdef A\n"
+                                           "#ifndef A\n"
+                                           "#elif A\n"
+                                           "#else\n"
+                                           "#include <A>\n"
+                                           "#include_next <A>\n"
+                                           "#__include_macros <A>\n"
+                                           "#import <A>\n"
+                                           "@import A;\n"
+                                           "#pragma clang module import A\n"
+                                           "#pragma once\n"
+                                           "#pragma push_macro(\"A\")\n"
+                                           "#pragma pop_macro(\"A\")\n"
+                                           "#pragma include_alias(<A>, <B>)\n",
+                                           Out, Tokens));
+  EXPECT_EQ(pp_define, Tokens[0].K);
+  EXPECT_EQ(pp_undef, Tokens[1].K);
+  EXPECT_EQ(pp_endif, Tokens[2].K);
+  EXPECT_EQ(pp_if, Tokens[3].K);
+  EXPECT_EQ(pp_ifdef, Tokens[4].K);
+  EXPECT_EQ(pp_ifndef, Tokens[5].K);
+  EXPECT_EQ(pp_elif, Tokens[6].K);
+  EXPECT_EQ(pp_else, Tokens[7].K);
+  EXPECT_EQ(pp_include, Tokens[8].K);
+  EXPECT_EQ(pp_include_next, Tokens[9].K);
+  EXPECT_EQ(pp___include_macros, Tokens[10].K);
+  EXPECT_EQ(pp_import, Tokens[11].K);
+  EXPECT_EQ(decl_at_import, Tokens[12].K);
+  EXPECT_EQ(pp_pragma_import, Tokens[13].K);
+  EXPECT_EQ(pp_pragma_once, Tokens[14].K);
+  EXPECT_EQ(pp_pragma_push_macro, Tokens[15].K);
+  EXPECT_EQ(pp_pragma_pop_macro, Tokens[16].K);
+  EXPECT_EQ(pp_pragma_include_alias, Tokens[17].K);
+  EXPECT_EQ(pp_eof, Tokens[18].K);
+}
+
+TEST(MinimizeSourceToDependencyDirectivesTest, TokenOffsets) {
+  SmallVector<char, 128> Out;
+  SmallVector<Token, 4> Tokens;
+
+  ASSERT_FALSE(minimizeSourceToDependencyDirectives(
+      "int x;\n#include \"a.h\"\nint y;\n#define B 1\n", Out, Tokens));
+  Out.push_back('\0');
+  EXPECT_STREQ("#include \"a.h\"\n#define B 1\n", Out.data());
+  ASSERT_EQ(3u, Tokens.size());
+  EXPECT_EQ(0, Tokens[0].Offset);
+  EXPECT_EQ(15, Tokens[1].Offset);
+  EXPECT_EQ(27, Tokens[2].Offset);
+}
+
+TEST(MinimizeSourceToDependencyDirectivesTest, Whitespace) {
+  SmallVector<char, 128> Out;
+
+  ASSERT_FALSE(minimizeSourceToDependencyDirectives(
+      "  #  define   MACRO  a  \n", Out));
+  Out.push_back('\0');
+  EXPECT_STREQ("#define MACRO  a\n", Out.data());
+
+  ASSERT_FALSE(
+      minimizeSourceToDependencyDirectives("#define MACRO a \\\n  b\n", Out));
+  Out.push_back('\0');
+  EXPECT_STREQ("#define MACRO a   b\n", Out.data());
+}
+
+TEST(MinimizeSourceToDependencyDirectivesTest, Comments) {
+  SmallVector<char, 128> Out;
+
+  ASSERT_FALSE(minimizeSourceToDependencyDirectives(
+      "// #include <a>\n"
+      "/* #include <b>\n"
+      " */ #include <c>\n"
+      "#include <d> // trailing\n"
+      "/* leading */ #include <e>\n"
+      "// continued \\\n"
+      "#include <f>\n",
+      Out));
+  Out.push_back('\0');
+  EXPECT_STREQ("#include <c>\n#include <d>\n#include <e>\n", Out.data());
+}
+
+TEST(MinimizeSourceToDependencyDirectivesTest, Literals) {
+  SmallVector<char, 128> Out;
+
+  ASSERT_FALSE(minimizeSourceToDependencyDirectives(
+      "const char *S = \"/* not a comment\";\n"
+      "#include <a>\n"
+      "char C = '\"';\n"
+      "#include <b>\n"
+      "int I = 0x1'000'000; /* ' */\n"
+      "#include <c>\n"
+      "auto R = R\"x(\n"
+      "#include <d>\n"
+      ")\" )x\";\n"
+      "#include <e>\n",
+      Out));
+  Out.push_back('\0');
+  EXPECT_STREQ("#include <a>\n#include <b>\n#include <c>\n#include <e>\n",
+               Out.data());
+}
+
+TEST(MinimizeSourceToDependencyDirectivesTest, IgnoredDirectives) {
+  SmallVector<char, 128> Out;
+
+  ASSERT_FALSE(minimizeSourceToDependencyDirectives(
+      "#\n"
+      "#error #include <a>\n"
+      "#warning message\n"
+      "#line 12\n"
+      "#pragma GCC diagnostic ignored \"-Wall\"\n"
+      "#pragma clang module build A\n"
+      "#include <b>\n",
+      Out));
+  Out.push_back('\0');
+  EXPECT_STREQ("#include <b>\n", Out.data());
+}
+
+TEST(MinimizeSourceToDependencyDirectivesTest, Unterminated) {
+  SmallVector<char, 128> Out;
+
+  ASSERT_TRUE(minimizeSourceToDependencyDirectives("/* unterminated", Out));
+  ASSERT_TRUE(
+      minimizeSourceToDependencyDirectives("#include <a> /* unterminated", Out));
+  ASSERT_TRUE(minimizeSourceToDependencyDirectives("auto R = R\"(", Out));
+  ASSERT_TRUE(minimizeSourceToDependencyDirectives("@import A", Out));
+
+  // An unterminated string ends at the end of the line.
+  ASSERT_FALSE(
+      minimizeSourceToDependencyDirectives("char C = ';\n#include <a>\n", Out));
+  Out.push_back('\0');
+  EXPECT_STREQ("#include <a>\n", Out.data());
+}
+
+} // end anonymous namespace
@@ -15,12 +15,17 @@
 #include "clang/Frontend/FrontendActions.h"
 #include "clang/Tooling/AllTUsExecution.h"
 #include "clang/Tooling/CompilationDatabase.h"
+#include "clang/Tooling/DependencyScanning/DependencyScanningFilesystem.h"
 #include "clang/Tooling/StandaloneExecution.h"
 #include "clang/Tooling/ToolExecutorPluginRegistry.h"
 #include "clang/Tooling/Tooling.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/Path.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include <algorithm>
+#include <mutex>
 #include <string>
 
 namespace clang {
@@ -84,6 +89,28 @@ private:
   ExecutionContext *const Context;
 };
 
+/// Counts how often each path is opened through the wrapped file system. The
+/// counts are shared by all the instances, which may run on different threads.
+class OpenCountingFileSystem : public llvm::vfs::ProxyFileSystem {
+public:
+  OpenCountingFileSystem(IntrusiveRefCntPtr<llvm::vfs::FileSystem> FS,
+                         std::mutex &Lock, llvm::StringMap<unsigned> &Opens)
+      : ProxyFileSystem(std::move(FS)), Lock(Lock), Opens(Opens) {}
+
+  llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>>
+  openFileForRead(const Twine &Path) override {
+    {
+      std::lock_guard<std::mutex> LockGuard(Lock);
+      ++Opens[Path.str()];
+    }
+    return ProxyFileSystem::openFileForRead(Path);
+  }
+
+private:
+  std::mutex &Lock;
+  llvm::StringMap<unsigned> &Opens;
+};
+
 } // namespace
 
 class TestToolExecutor : public ToolExecutor {
@@ -293,5 +320,111 @@ TEST(AllTUsToolTest, ManyFiles) {
   EXPECT_THAT(ExpectedSymbols, ::testing::UnorderedElementsAreArray(Results));
 }
 
+TEST(AllTUsToolTest, ManyFilesSharingFileContents) {
+  SmallString<128> Dir;
+  ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("all-tus-test", Dir));
+  auto WriteFile = [&](StringRef Name, StringRef Contents) {
+    SmallString<128> Path(Dir);
+    llvm::sys::path::append(Path, Name);
+    std::error_code EC;
+    llvm::raw_fd_ostream OS(Path, EC, llvm::sys::fs::F_None);
+    EXPECT_FALSE(EC);
+    OS << Contents;
+    return Path.str().str();
+  };
+
+  unsigned NumFiles = 20;
+  std::vector<std::string> Files;
+  std::vector<std::string> ExpectedSymbols;
+  llvm::json::Array Commands;
+  std::string Header = WriteFile("header.h", "typedef int shared_t;");
+  for (unsigned i = 1; i <= NumFiles; ++i) {
+    std::string Symbol = "function_" + std::to_string(i);
+    std::string File =
+        WriteFile("f" + std::to_string(i) + ".cc",
+                  "#include \"header.h\"\nshared_t " + Symbol +
+                      "() { return 0; }");
+    Commands.push_back(llvm::json::Object{{"directory", Dir.str()},
+                                          {"command", "clang++ -c " + File},
+                                          {"file", File}});
+    Files.push_back(File);
+    ExpectedSymbols.push_back(Symbol);
+  }
+  std::string Database;
+  llvm::raw_string_ostream(Database) << llvm::json::Value(std::move(Commands));
+  WriteFile("compile_commands.json", Database);
+
+  // The executor is created the way tools create it, from the command line.
+  std::vector<const char *> argv = {"prog", "--executor=all-TUs",
+                                    "--execute-share-file-contents", "-p",
+                                    Dir.c_str(), Files[0].c_str()};
+  int argc = argv.size();
+  auto Executor = internal::createExecutorFromCommandLineArgsImpl(
+      argc, &argv[0], TestCategory);
+  ASSERT_TRUE((bool)Executor);
+  ASSERT_EQ(Executor->get()->getExecutorName(),
+            AllTUsToolExecutor::ExecutorName);
+
+  // All the threads read the headers through one cache, so each file is only
+  // read from disk once.
+  std::mutex OpensLock;
+  llvm::StringMap<unsigned> Opens;
+  static_cast<AllTUsToolExecutor *>(Executor->get())
+      ->setFileSystemWrapper([&](IntrusiveRefCntPtr<llvm::vfs::FileSystem> FS)
+                                 -> IntrusiveRefCntPtr<llvm::vfs::FileSystem> {
+        return new OpenCountingFileSystem(std::move(FS), OpensLock, Opens);
+      });
+
+  auto Err = Executor->get()->execute(std::unique_ptr<FrontendActionFactory>(
+      new ReportResultActionFactory(Executor->get()->getExecutionContext())));
+  ASSERT_TRUE(!Err);
+  std::vector<std::string> Results;
+  Executor->get()->getToolResults()->forEachResult(
+      [&](StringRef Name, StringRef) { Results.push_back(Name); });
+  EXPECT_THAT(ExpectedSymbols, ::testing::UnorderedElementsAreArray(Results));
+
+  EXPECT_EQ(1u, Opens.lookup(Header));
+  for (const std::string &File : Files)
+    EXPECT_EQ(1u, Opens.lookup(File)) << File;
+  for (const auto &FileAndOpens : Opens)
+    EXPECT_EQ(1u, FileAndOpens.second) << FileAndOpens.first();
+
+  // Reset to the default values.
+  ShareFileContents.setValue(false);
+  ExecutorName.setValue("standalone");
+  llvm::sys::fs::remove_directories(Dir);
+}
+
+TEST(AllTUsToolTest, SharedFileCacheIgnoresMainFiles) {
+  IntrusiveRefCntPtr<llvm::vfs::InMemoryFileSystem> InMemoryFS(
+      new llvm::vfs::InMemoryFileSystem);
+  InMemoryFS->addFile("/dir/header.h", 0,
+                      llvm::MemoryBuffer::getMemBuffer("int x;"));
+  InMemoryFS->addFile("/dir/main.cc", 0,
+                      llvm::MemoryBuffer::getMemBuffer("int y;"));
+  std::mutex OpensLock;
+  llvm::StringMap<unsigned> Opens;
+  IntrusiveRefCntPtr<llvm::vfs::FileSystem> CountingFS =
+      new OpenCountingFileSystem(InMemoryFS, OpensLock, Opens);
+
+  // Main files are read from the underlying file system every time, while
+  // headers are read once for all the workers.
+  dependencies::DependencyScanningFilesystemSharedCache Cache;
+  for (unsigned I = 0; I != 2; ++I) {
+    IntrusiveRefCntPtr<dependencies::DependencyScanningWorkerFilesystem> FS(
+        new dependencies::DependencyScanningWorkerFilesystem(
+            Cache, CountingFS, /*MinimizeSources=*/false));
+    FS->ignoreFile("/dir/main.cc");
+    for (StringRef Path : {"/dir/header.h", "/dir/main.cc"}) {
+      auto File = FS->openFileForRead(Path);
+      ASSERT_TRUE((bool)File) << Path;
+      auto Buffer = (*File)->getBuffer(Path);
+      ASSERT_TRUE((bool)Buffer) << Path;
+    }
+  }
+  EXPECT_EQ(1u, Opens.lookup("/dir/header.h"));
+  EXPECT_EQ(2u, Opens.lookup("/dir/main.cc"));
+}
+
 } // end namespace tooling
 } // end namespace clang
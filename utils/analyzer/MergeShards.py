@@ -0,0 +1,153 @@
+#!/usr/bin/env python
+
+"""
+MergeShards - Merges the reports that the shards of a static analyzer run
+wrote for one translation unit into a single report.
+
+When a translation unit is analyzed with
+'-analyzer-config shard-count=N,shard-index=K', the plist or SARIF output file
+given with '-o <output>' is written to '<output>.shardK' instead. This tool
+merges those files back into '<output>':
+
+    MergeShards.py <output> <output>.shard0 ... <output>.shard<N-1>
+
+The format of the inputs is detected from their contents. Plist reports refer
+to source files by their index in the 'files' array of the report, so the
+indices are renumbered in the merged report. SARIF reports are merged by
+concatenating their runs.
+
+A bug found on a path through a function that is inlined into functions of
+different shards is reported by each of those shards, while the analysis that
+isn't split into shards reports it once. Such duplicates are dropped: plist
+diagnostics with the same issue hash, checker and location, and SARIF results
+with the same fingerprints (or, without those, the same rule, message and
+location). The diagnostics and results are sorted by location, so the merged
+report doesn't depend on which shard found what.
+"""
+from __future__ import print_function
+
+import json
+import plistlib
+import sys
+
+
+def readPlist(path):
+    if hasattr(plistlib, 'load'):
+        with open(path, 'rb') as f:
+            return plistlib.load(f)
+    return plistlib.readPlist(path)
+
+
+def writePlist(data, path):
+    if hasattr(plistlib, 'dump'):
+        with open(path, 'wb') as f:
+            plistlib.dump(data, f)
+    else:
+        plistlib.writePlist(data, path)
+
+
+def remapFiles(value, fileMap):
+    """Renumbers the file indices that appear anywhere in a plist value."""
+    if isinstance(value, list):
+        return [remapFiles(v, fileMap) for v in value]
+    if not isinstance(value, dict):
+        return value
+    result = {}
+    for key, v in value.items():
+        if key == 'file':
+            result[key] = fileMap[v]
+        elif key == 'ExecutedLines':
+            result[key] = dict((str(fileMap[int(k)]), lines)
+                               for k, lines in v.items())
+        else:
+            result[key] = remapFiles(v, fileMap)
+    return result
+
+
+def plistDiagnosticKey(diagnostic):
+    location = diagnostic.get('location', {})
+    return (location.get('file', -1), location.get('line', 0),
+            location.get('col', 0), diagnostic.get('check_name', ''),
+            diagnostic.get('issue_hash_content_of_line_in_context', ''),
+            diagnostic.get('description', ''))
+
+
+def mergePlists(inputs):
+    merged = dict(inputs[0])
+    merged['files'] = sorted(set(f for data in inputs
+                                 for f in data.get('files', [])))
+    fileIndex = dict((f, i) for i, f in enumerate(merged['files']))
+    diagnostics = {}
+    for data in inputs:
+        fileMap = [fileIndex[f] for f in data.get('files', [])]
+        for d in data.get('diagnostics', []):
+            d = remapFiles(d, fileMap)
+            diagnostics.setdefault(plistDiagnosticKey(d), d)
+    merged['diagnostics'] = [diagnostics[key] for key in sorted(diagnostics)]
+    return merged
+
+
+def sarifResultKeys(result):
+    """Returns the key that identifies a SARIF result, and the key that it is
+    sorted by."""
+    location = {}
+    if result.get('locations'):
+        location = result['locations'][0].get('physicalLocation', {})
+    uri = location.get('fileLocation', {}).get('uri', '')
+    region = location.get('region', {})
+    ruleId = result.get('ruleId', '')
+    message = result.get('message', {}).get('text', '')
+    sortKey = (uri, region.get('startLine', 0), region.get('startColumn', 0),
+               ruleId, message)
+    for field in ('fingerprints', 'partialFingerprints'):
+        if result.get(field):
+            return (field, json.dumps(result[field], sort_keys=True)), sortKey
+    return (uri, json.dumps(region, sort_keys=True), ruleId, message), sortKey
+
+
+def mergeSarif(inputs):
+    merged = dict(inputs[0])
+    merged['runs'] = []
+    seen = set()
+    for data in inputs:
+        for run in data.get('runs', []):
+            results = []
+            for result in run.get('results', []):
+                identity, sortKey = sarifResultKeys(result)
+                if identity in seen:
+                    continue
+                seen.add(identity)
+                results.append((sortKey, result))
+            results.sort(key=lambda keyAndResult: keyAndResult[0])
+            run = dict(run)
+            run['results'] = [result for _, result in results]
+            merged['runs'].append(run)
+    return merged
+
+
+def isSarif(path):
+    with open(path, 'rb') as f:
+        return f.read(1) == b'{'
+
+
+def main():
+    if len(sys.argv) < 3:
+        print('usage: %s <output> <shard output>...' % sys.argv[0],
+              file=sys.stderr)
+        return 1
+
+    output, shards = sys.argv[1], sys.argv[2:]
+    if isSarif(shards[0]):
+        inputs = []
+        for path in shards:
+            with open(path) as f:
+                inputs.append(json.load(f))
+        with open(output, 'w') as f:
+            json.dump(mergeSarif(inputs), f, indent=2)
+    else:
+        writePlist(mergePlists([readPlist(path) for path in shards]), output)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
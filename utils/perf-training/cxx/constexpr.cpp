@@ -0,0 +1,200 @@
+// RUN: %clang_cpp -std=c++14 -fsyntax-only %s
+// RUN: %clang_cpp_skip_driver -std=c++14 -fsyntax-only %s
+// RUN: %clang_cpp -std=c++14 -fconstexpr-bytecode -fsyntax-only %s
+
+// Constant expressions in the style of compile-time hash tables, parsers and
+// metaprogramming libraries, which exercise the constant evaluator.
+
+namespace hash_table {
+
+constexpr unsigned fnv1a(const char *S, unsigned N) {
+  unsigned H = 2166136261u;
+  for (unsigned I = 0; I != N; ++I) {
+    H ^= static_cast<unsigned char>(S[I]);
+    H *= 16777619u;
+  }
+  return H;
+}
+
+template <unsigned Size> struct Table {
+  unsigned Keys[Size] = {};
+  int Values[Size] = {};
+  bool Used[Size] = {};
+
+  constexpr void insert(unsigned Key, int Value) {
+    unsigned Slot = Key % Size;
+    while (Used[Slot] && Keys[Slot] != Key)
+      Slot = (Slot + 1) % Size;
+    Used[Slot] = true;
+    Keys[Slot] = Key;
+    Values[Slot] = Value;
+  }
+
+  constexpr int lookup(unsigned Key) const {
+    unsigned Slot = Key % Size;
+    while (Used[Slot]) {
+      if (Keys[Slot] == Key)
+        return Values[Slot];
+      Slot = (Slot + 1) % Size;
+    }
+    return -1;
+  }
+};
+
+constexpr const char *Words[] = {
+    "alignas",   "alignof",  "and",       "asm",      "auto",
+    "bool",      "break",    "case",      "catch",    "char",
+    "class",     "const",    "constexpr", "continue", "decltype",
+    "default",   "delete",   "do",        "double",   "else",
+    "enum",      "explicit", "export",    "extern",   "false",
+    "float",     "for",      "friend",    "goto",     "if",
+    "inline",    "int",      "long",      "mutable",  "namespace",
+    "new",       "noexcept", "nullptr",   "operator", "private",
+    "protected", "public",   "register",  "return",   "short",
+    "signed",    "sizeof",   "static",    "struct",   "switch",
+    "template",  "this",     "throw",     "true",     "try",
+    "typedef",   "typeid",   "typename",  "union",    "unsigned",
+    "using",     "virtual",  "void",      "volatile", "while"};
+
+constexpr unsigned length(const char *S) {
+  unsigned N = 0;
+  while (S[N])
+    ++N;
+  return N;
+}
+
+constexpr Table<128> buildKeywordTable() {
+  Table<128> T;
+  for (unsigned I = 0; I != sizeof(Words) / sizeof(Words[0]); ++I)
+    T.insert(fnv1a(Words[I], length(Words[I])), I);
+  return T;
+}
+
+constexpr Table<128> Keywords = buildKeywordTable();
+static_assert(Keywords.lookup(fnv1a("constexpr", 9)) == 12, "");
+static_assert(Keywords.lookup(fnv1a("while", 5)) == 64, "");
+static_assert(Keywords.lookup(fnv1a("banana", 6)) == -1, "");
+
+} // namespace hash_table
+
+namespace parser {
+
+struct Parser {
+  const char *Text;
+  unsigned Pos = 0;
+
+  constexpr Parser(const char *Text) : Text(Text) {}
+
+  constexpr void skipSpaces() {
+    while (Text[Pos] == ' ')
+      ++Pos;
+  }
+
+  constexpr long primary() {
+    skipSpaces();
+    if (Text[Pos] == '(') {
+      ++Pos;
+      long Value = expression();
+      skipSpaces();
+      ++Pos; // ')'
+      return Value;
+    }
+    if (Text[Pos] == '-') {
+      ++Pos;
+      return -primary();
+    }
+    long Value = 0;
+    while (Text[Pos] >= '0' && Text[Pos] <= '9')
+      Value = Value * 10 + (Text[Pos++] - '0');
+    return Value;
+  }
+
+  constexpr long term() {
+    long Value = primary();
+    while (true) {
+      skipSpaces();
+      char Op = Text[Pos];
+      if (Op != '*' && Op != '/' && Op != '%')
+        return Value;
+      ++Pos;
+      long RHS = primary();
+      Value = Op == '*' ? Value * RHS : Op == '/' ? Value / RHS : Value % RHS;
+    }
+  }
+
+  constexpr long expression() {
+    long Value = term();
+    while (true) {
+      skipSpaces();
+      char Op = Text[Pos];
+      if (Op != '+' && Op != '-')
+        return Value;
+      ++Pos;
+      long RHS = term();
+      Value = Op == '+' ? Value + RHS : Value - RHS;
+    }
+  }
+};
+
+constexpr long evaluate(const char *Text) { return Parser(Text).expression(); }
+
+static_assert(evaluate("1 + 2 * 3") == 7, "");
+static_assert(evaluate("(1 + 2) * 3 - 4 / 2") == 7, "");
+static_assert(evaluate("((((((1 + 1) * 2) + 3) * 4) - 5) % 7) * -(8 + 9)") ==
+                  -17 * ((((2 * 2 + 3) * 4) - 5) % 7),
+              "");
+static_assert(evaluate("123456 / (7 * (8 + 9) - 10) + 11 * (12 - (13 % 5))") ==
+                  123456 / 109 + 11 * 9,
+              "");
+
+} // namespace parser
+
+namespace metaprogramming {
+
+template <typename... Ts> struct TypeList {};
+
+template <unsigned N> struct Index {};
+
+template <unsigned... Is> struct Sequence {
+  static constexpr unsigned Values[] = {Is...};
+};
+
+template <unsigned... Is>
+constexpr unsigned Sequence<Is...>::Values[];
+
+template <unsigned N, unsigned... Is>
+struct MakeSequence : MakeSequence<N - 1, N - 1, Is...> {};
+
+template <unsigned... Is> struct MakeSequence<0, Is...> {
+  using Type = Sequence<Is...>;
+};
+
+template <unsigned... Is>
+constexpr unsigned sumOfSquares(Sequence<Is...>) {
+  unsigned Sum = 0;
+  for (unsigned I : Sequence<Is...>::Values)
+    Sum += I * I;
+  return Sum;
+}
+
+static_assert(sumOfSquares(MakeSequence<200>::Type()) == 199 * 200 * 399 / 6,
+              "");
+
+template <unsigned Size> struct Sieve {
+  bool Composite[Size] = {};
+  unsigned Count = 0;
+
+  constexpr Sieve() {
+    for (unsigned I = 2; I < Size; ++I) {
+      if (Composite[I])
+        continue;
+      ++Count;
+      for (unsigned J = I * I; J < Size; J += I)
+        Composite[J] = true;
+    }
+  }
+};
+
+static_assert(Sieve<5000>().Count == 669, "");
+
+} // namespace metaprogramming
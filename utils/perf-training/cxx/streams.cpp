@@ -0,0 +1,130 @@
+// RUN: %clang_cpp -std=c++11 -fsyntax-only %s
+// RUN: %clang_cpp_skip_driver -std=c++11 -fsyntax-only %s
+
+// Formatting code in the style of logging and serialization libraries, whose
+// calls to heavily overloaded stream operators exercise overload resolution.
+#include <complex>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace geometry {
+
+struct Point {
+  double X, Y;
+};
+
+struct Rect {
+  Point Min, Max;
+};
+
+std::ostream &operator<<(std::ostream &OS, const Point &P) {
+  return OS << '(' << P.X << ", " << P.Y << ')';
+}
+
+std::ostream &operator<<(std::ostream &OS, const Rect &R) {
+  return OS << '[' << R.Min << " - " << R.Max << ']';
+}
+
+std::istream &operator>>(std::istream &IS, Point &P) {
+  char Open, Comma, Close;
+  return IS >> Open >> P.X >> Comma >> P.Y >> Close;
+}
+
+} // namespace geometry
+
+namespace logging {
+
+enum class Level { Debug, Info, Warning, Error };
+
+std::ostream &operator<<(std::ostream &OS, Level L) {
+  switch (L) {
+  case Level::Debug:
+    return OS << "debug";
+  case Level::Info:
+    return OS << "info";
+  case Level::Warning:
+    return OS << "warning";
+  case Level::Error:
+    return OS << "error";
+  }
+  return OS;
+}
+
+template <typename T>
+std::ostream &operator<<(std::ostream &OS, const std::vector<T> &Values) {
+  OS << '{';
+  for (std::size_t I = 0; I != Values.size(); ++I)
+    OS << (I ? ", " : "") << Values[I];
+  return OS << '}';
+}
+
+template <typename K, typename V>
+std::ostream &operator<<(std::ostream &OS, const std::map<K, V> &Values) {
+  OS << '{';
+  for (const auto &KV : Values)
+    OS << KV.first << ": " << KV.second << "; ";
+  return OS << '}';
+}
+
+class Record {
+  std::ostringstream Stream;
+
+public:
+  Record(Level L, const char *File, int Line) {
+    Stream << std::setw(8) << std::left << L << File << ':' << Line << ": ";
+  }
+  ~Record() { std::clog << Stream.str() << std::endl; }
+
+  template <typename T> Record &operator<<(const T &Value) {
+    Stream << Value;
+    return *this;
+  }
+};
+
+} // namespace logging
+
+#define LOG(L) logging::Record(logging::Level::L, __FILE__, __LINE__)
+
+using geometry::operator<<;
+using logging::operator<<;
+
+int main(int, char **) {
+  geometry::Point P = {1.5, -2.25};
+  geometry::Rect R = {{0, 0}, {3.5, 4}};
+  std::vector<int> Ints = {1, 2, 3, 5, 8, 13};
+  std::vector<std::string> Names = {"alpha", "beta", "gamma"};
+  std::map<std::string, double> Scores = {{"x", 0.5}, {"y", 0.25}};
+  std::complex<double> Z(1, -1);
+
+  LOG(Info) << "point " << P << " in " << R;
+  LOG(Debug) << "ints " << Ints << " names " << Names;
+  LOG(Warning) << "scores " << Scores << " z=" << Z;
+  LOG(Error) << 'c' << 1 << 2u << 3l << 4ul << 5ll << 6ull << 7.0f << 8.0
+             << 9.0L << true << static_cast<const void *>(&P);
+
+  std::cout << std::hex << std::showbase << 255 << ' ' << std::dec << 255
+            << ' ' << std::oct << 255 << std::dec << '\n';
+  std::cout << std::fixed << std::setprecision(3) << 3.14159 << ' '
+            << std::scientific << 6.02e23 << ' ' << std::setfill('*')
+            << std::setw(10) << std::right << 42 << '\n';
+  std::cout << std::boolalpha << (P.X < P.Y) << ' ' << std::noboolalpha
+            << (R.Min.X < R.Max.X) << std::endl;
+
+  std::stringstream Buffer;
+  Buffer << P << ' ' << 7 << ' ' << 2.5 << ' ' << "word";
+  geometry::Point Q;
+  int I;
+  double D;
+  std::string S;
+  Buffer >> Q >> I >> D >> S;
+  std::cerr << Q << I << D << S << std::flush;
+
+  std::wostringstream Wide;
+  Wide << L"wide " << 1 << L' ' << 2.0 << std::endl;
+  std::wcout << Wide.str();
+  return 0;
+}
@@ -0,0 +1,249 @@
+#!/usr/bin/env python
+"""Summarizes the -ftime-trace output of the compilations of a build.
+
+Reads the JSON traces written by `clang -ftime-trace` for each translation
+unit (the files named on the command line, and the .json files found in the
+directories named on it) and reports where the frontend spent its time across
+all of them:
+
+  headers         -- time spent parsing each header, including the headers it
+                     includes, and how many translation units parsed it
+  templates       -- time spent instantiating each class or function template,
+                     excluding the instantiations it triggers, summed over all
+                     of its specializations
+  instantiations  -- the same, for each specialization
+  constexpr       -- time spent in each constexpr call made directly by a
+                     constant expression, and in each initializer evaluation
+  overloads       -- time spent resolving each overloaded call or operator
+
+Template instantiations are also attributed to the header that defines the
+template, in the 'header instantiation' column of the headers report.
+
+Only the events that the compiler recorded are seen: clang leaves out the
+ones shorter than `-mllvm -time-trace-granularity=<us>` (500 by default), so
+small costs only show up when they add up to more than that.
+
+Example:
+  $ cmake -DCMAKE_CXX_FLAGS=-ftime-trace ... && ninja
+  $ summarize-time-trace.py --top 20 build/
+"""
+
+from __future__ import absolute_import, division, print_function
+from argparse import ArgumentParser, RawDescriptionHelpFormatter
+from collections import defaultdict
+import json
+import os
+import re
+import sys
+
+# Details are "<name> (<file>:<line>:<column>)" for the events below.
+DETAIL_LOCATION = re.compile(r'^(.*) \((.*):(\d+):(\d+)\)$')
+
+INSTANTIATION_EVENTS = ('InstantiateClass', 'InstantiateFunction')
+CONSTEXPR_EVENTS = ('EvaluateConstexprCall', 'EvaluateAsInitializer')
+OVERLOAD_EVENTS = ('OverloadResolution',)
+
+
+class Stat(object):
+  def __init__(self):
+    self.time = 0
+    self.count = 0
+    self.units = set()
+
+  def add(self, time, unit):
+    self.time += time
+    self.count += 1
+    self.units.add(unit)
+
+
+def split_detail(detail):
+  """Returns the name and the file of a detail with a location."""
+  match = DETAIL_LOCATION.match(detail)
+  if not match:
+    return detail, None
+  return match.group(1), match.group(2)
+
+
+OPERATOR_NAME = re.compile(r'operator(<=>|<<=|>>=|<<|>>|<=|>=|->\*|->|<|>)')
+
+
+def strip_template_args(name):
+  """Returns the name of a specialization without its template arguments."""
+  operators = []
+
+  def save_operator(match):
+    operators.append(match.group(0))
+    return '\0'
+
+  result = []
+  depth = 0
+  for c in OPERATOR_NAME.sub(save_operator, name):
+    if c == '<':
+      depth += 1
+    elif c == '>' and depth:
+      depth -= 1
+    elif not depth:
+      result.append(operators.pop(0) if c == '\0' else c)
+  return ''.join(result)
+
+
+def find_traces(paths):
+  for path in paths:
+    if not os.path.isdir(path):
+      yield path
+      continue
+    for root, _, files in os.walk(path):
+      for name in files:
+        if name.endswith('.json'):
+          yield os.path.join(root, name)
+
+
+def read_events(path):
+  """Returns the complete events of a trace, or None if it isn't one."""
+  try:
+    with open(path) as f:
+      trace = json.load(f)
+  except (IOError, ValueError):
+    return None
+  if not isinstance(trace, dict) or 'traceEvents' not in trace:
+    return None
+  return [e for e in trace['traceEvents']
+          if e.get('ph') == 'X' and not e.get('name', '').startswith('Total ')]
+
+
+def compute_self_times(events):
+  """Returns the duration of each event minus those of the events nested in
+  it, by index."""
+  self_times = [e['dur'] for e in events]
+  order = sorted(range(len(events)),
+                 key=lambda i: (events[i].get('tid', 0), events[i]['ts'],
+                                -events[i]['dur']))
+  stack = []
+  for i in order:
+    e = events[i]
+    end = e['ts'] + e['dur']
+    while stack and (events[stack[-1]].get('tid', 0) != e.get('tid', 0) or
+                     events[stack[-1]]['ts'] + events[stack[-1]]['dur'] < end):
+      stack.pop()
+    if stack:
+      self_times[stack[-1]] -= e['dur']
+    stack.append(i)
+  return self_times
+
+
+class Summary(object):
+  def __init__(self):
+    self.units = 0
+    self.frontend = 0
+    self.headers = defaultdict(Stat)
+    self.header_instantiations = defaultdict(Stat)
+    self.templates = defaultdict(Stat)
+    self.instantiations = defaultdict(Stat)
+    self.constexpr = defaultdict(Stat)
+    self.overloads = defaultdict(Stat)
+
+  def add_unit(self, unit, events):
+    self.units += 1
+    self_times = compute_self_times(events)
+    for e, self_time in zip(events, self_times):
+      name = e['name']
+      detail = e.get('args', {}).get('detail', '')
+      if name == 'Frontend':
+        self.frontend += e['dur']
+      elif name == 'Source':
+        self.headers[detail].add(e['dur'], unit)
+      elif name in INSTANTIATION_EVENTS:
+        specialization, header = split_detail(detail)
+        template = strip_template_args(specialization)
+        if header:
+          template += ' (%s)' % header
+          self.header_instantiations[header].add(self_time, unit)
+        self.templates[template].add(self_time, unit)
+        self.instantiations[specialization].add(self_time, unit)
+      elif name in CONSTEXPR_EVENTS:
+        self.constexpr[detail].add(e['dur'], unit)
+      elif name in OVERLOAD_EVENTS:
+        self.overloads[detail].add(e['dur'], unit)
+
+
+def ms(us):
+  return '%.1f' % (us / 1000.0)
+
+
+def print_table(title, columns, rows):
+  print(title)
+  print('=' * len(title))
+  widths = [max([len(c)] + [len(r[i]) for r in rows])
+            for i, c in enumerate(columns[:-1])]
+  print('  '.join(c.rjust(w) for c, w in zip(columns, widths)) +
+        '  ' + columns[-1])
+  for row in rows:
+    print('  '.join(v.rjust(w) for v, w in zip(row, widths)) + '  ' + row[-1])
+  print()
+
+
+def report_stats(title, stats, top, name_column):
+  items = sorted(stats.items(), key=lambda kv: -kv[1].time)[:top]
+  rows = [(ms(s.time), str(s.count), str(len(s.units)), name)
+          for name, s in items]
+  print_table(title, ('ms', 'count', 'TUs', name_column), rows)
+
+
+def report(summary, top, sections):
+  print('%d translation units, %s ms in the frontend' %
+        (summary.units, ms(summary.frontend)))
+  print()
+  if 'headers' in sections:
+    def cost(name):
+      return (summary.headers.get(name, Stat()).time +
+              summary.header_instantiations.get(name, Stat()).time)
+    names = set(summary.headers) | set(summary.header_instantiations)
+    rows = []
+    for name in sorted(names, key=lambda n: -cost(n))[:top]:
+      parse = summary.headers.get(name, Stat())
+      inst = summary.header_instantiations.get(name, Stat())
+      rows.append((ms(parse.time), ms(inst.time),
+                   str(len(parse.units | inst.units)), name))
+    print_table('Most expensive headers',
+                ('parse ms', 'header instantiation ms', 'TUs', 'header'), rows)
+  if 'templates' in sections:
+    report_stats('Most expensive templates', summary.templates, top,
+                 'template')
+  if 'instantiations' in sections:
+    report_stats('Most expensive instantiations', summary.instantiations, top,
+                 'specialization')
+  if 'constexpr' in sections:
+    report_stats('Most expensive constant evaluations', summary.constexpr, top,
+                 'call or variable')
+  if 'overloads' in sections:
+    report_stats('Most expensive overload resolutions', summary.overloads, top,
+                 'call')
+
+
+def main():
+  sections = ('headers', 'templates', 'instantiations', 'constexpr',
+              'overloads')
+  parser = ArgumentParser(description=__doc__,
+                          formatter_class=RawDescriptionHelpFormatter)
+  parser.add_argument('paths', nargs='+', metavar='path',
+                      help='A trace file, or a directory to search for them.')
+  parser.add_argument('--top', type=int, default=10,
+                      help='The number of entries in each report.')
+  parser.add_argument('--only', choices=sections, action='append',
+                      help='Only print the given report.')
+  args = parser.parse_args()
+
+  summary = Summary()
+  for path in find_traces(args.paths):
+    events = read_events(path)
+    if events is None:
+      print('warning: skipping %s: not a time trace' % path, file=sys.stderr)
+      continue
+    summary.add_unit(path, events)
+  if not summary.units:
+    sys.exit('error: no time traces found')
+  report(summary, args.top, args.only or sections)
+
+
+if __name__ == '__main__':
+  main()